@@ -6,21 +6,48 @@
  * 
  * Architecture:
  *   - Dual DAC channels (PA4 = left, PA5 = right) driven by TIM6 trigger
- *   - Circular DMA with half-transfer interrupts for double buffering
- *   - LEFT channel is master for timing (triggers refill requests, updates sync)
- *   - RIGHT channel follows LEFT (filled at same time from same source)
+ *   - Circular DMA over a ring of AUDIO_SEGMENT_COUNT segments
+ *   - Packed mode (AUDIO_DAC_PACKED): one DMA channel (DMA1 Ch3) writes
+ *     32-bit L|R words to the dual-channel DHR12RD register, so both
+ *     channels update on each TIM6 trigger from a single buffer
+ *   - Split mode: LEFT channel DMA is master for timing (triggers refill
+ *     requests, updates sync), RIGHT channel DMA follows LEFT
  * 
- * Buffer Layout (per channel):
- *   [---- First Half (2048 samples) ----][---- Second Half (2048 samples) ----]
+ * Buffer Layout (packed words, or per channel in split mode):
+ *   [ seg 0 ][ seg 1 ] ... [ seg N-1 ]   (AUDIO_SEGMENT_SAMPLES each)
  *   
- *   While DMA plays first half, main loop fills second half, and vice versa.
+ *   Segments are written in order; a segment can be refilled once the DMA
+ *   has played all of it. The DMA only interrupts at half and full ring,
+ *   so the read position between interrupts comes from its counter
+ *   (audio_GetPlaybackPosition()). With 2 segments this is plain double
+ *   buffering; more, larger segments ride out longer SD stalls.
+ * 
+ * Refill Cadence:
+ *   The refill hook fires per half-ring, not per segment: each interrupt
+ *   frees AUDIO_SEGMENT_COUNT / 2 segments, which a hook-driven refill
+ *   (PendSV) tops up back to back. Smaller segments shorten each SD read,
+ *   not the time between refills. Only a refill polled from the main loop
+ *   (audio_NeedsRefill()) can take a segment as soon as the DMA leaves it.
+ * 
+ * RAM:
+ *   The ring takes AUDIO_RING_BYTES of SRAM1 in either mode and must fit
+ *   AUDIO_RING_RAM_BUDGET (buffers.h), checked at compile time.
+ * 
+ * Health:
+ *   A half/full-ring interrupt that finds the DMA past the last written
+ *   segment means it replayed stale samples - an underrun. Each refill
+ *   also records its slack, how far ahead of the DMA it finished, as a
+ *   minimum and a histogram; a late refill (DMA already inside the
+ *   segment) counts as an underrun with negative slack.
  * 
  * Usage:
  *   1. audio_Init() with DAC and timer handles
  *   2. audio_SetAVSync() to link synchronization
- *   3. Pre-fill both buffer halves with audio_GetBuffer() + your fill function
+ *   3. Pre-fill both buffer halves via audio_GetPackedBuffer() (or the
+ *      left/right buffers in split mode) + your fill function
  *   4. audio_Start() to begin playback
- *   5. In main loop: check audio_NeedsRefill(), fill buffer, call audio_BufferFilled()
+ *   5. In main loop: while audio_NeedsRefill(), fill the segment at
+ *      audio_GetFillOffset() and call audio_BufferFilled()
  *   6. audio_Stop() when done
  */
 
@@ -34,13 +61,33 @@
 
 /* ========================== Configuration ========================== */
 
-// Buffer sizes derived from buffers.h
-#define AUDIO_HALF_BUFFER_SAMPLES   AUDIO_BUFFER_SAMPLES        // 2048 - samples per half
-#define AUDIO_FULL_BUFFER_SAMPLES   (AUDIO_BUFFER_SAMPLES * 2)  // 4096 - total circular buffer
+// Ring size derived from buffers.h
+#define AUDIO_RING_SAMPLES          (AUDIO_SEGMENT_SAMPLES * AUDIO_SEGMENT_COUNT)
+#define AUDIO_RING_HALF_SAMPLES     (AUDIO_RING_SAMPLES / 2)    // Between DMA interrupts
+
+#define AUDIO_RING_BYTES            (AUDIO_RING_SAMPLES * 4)    // L|R words, or two 16-bit rings
+
+#if AUDIO_RING_SAMPLES > 65535
+#error "Audio ring exceeds the DMA transfer count (CNDTR is 16-bit)"
+#endif
 
 // DAC output for silence (12-bit midpoint)
 #define AUDIO_DAC_SILENCE           2048
 
+// 1 = single DMA channel feeding packed L|R words to DHR12RD (halves DMA
+// requests and interrupts, frees DMA2 Ch5); 0 = one 16-bit DMA per channel
+#ifndef AUDIO_DAC_PACKED
+#define AUDIO_DAC_PACKED            1
+#endif
+
+// Packed DHR12RD word: channel 1 (left) in bits 0-11, channel 2 in 16-27
+#define AUDIO_PACK(left, right)     ((uint32_t)(left) | ((uint32_t)(right) << 16))
+
+// Refill slack histogram over the largest possible slack, ring minus one
+// segment (8 ms bins with the default 2 x 2048 ring at 32 kHz)
+#define AUDIO_SLACK_BINS            8
+#define AUDIO_SLACK_BIN_SAMPLES     ((AUDIO_RING_SAMPLES - AUDIO_SEGMENT_SAMPLES) / AUDIO_SLACK_BINS)
+
 /* ========================== Types ========================== */
 
 typedef enum {
@@ -55,21 +102,25 @@ typedef enum {
     AUDIO_ERROR
 } Audio_Status;
 
-typedef enum {
-    AUDIO_BUFFER_FIRST_HALF = 0,    // Fill samples 0 to HALF_BUFFER_SAMPLES-1
-    AUDIO_BUFFER_SECOND_HALF        // Fill samples HALF_BUFFER_SAMPLES to end
-} Audio_BufferHalf;
-
 // Audio statistics
 typedef struct {
-    uint32_t samples_played;    // Total samples output
+    volatile uint32_t samples_played;   // Total samples output (updated from ISR)
     uint32_t refill_count;      // Times buffer was refilled
-    uint32_t underrun_count;    // Times buffer wasn't ready in time
+    uint32_t underrun_count;    // Stale audio played (late refill, or DMA past the writes)
+    
+    // Refill slack: samples between audio_BufferFilled() and the DMA
+    // reaching that segment (negative = DMA was already playing it)
+    int32_t slack_min;                          // Worst refill during playback
+    volatile int32_t slack_last;                // Most recent refill (live display)
+    uint32_t slack_hist[AUDIO_SLACK_BINS];      // Bin i: [i, i+1) * AUDIO_SLACK_BIN_SAMPLES
 } Audio_Stats;
 
 // Forward declaration
 struct AVSync_Handle;
 
+// Called from the DAC DMA half/full-ring ISR (half the ring is free to refill)
+typedef void (*Audio_RefillHook)(void *ctx);
+
 typedef struct {
     // HAL handles (not owned, must outlive this struct)
     DAC_HandleTypeDef *hdac;
@@ -78,9 +129,12 @@ typedef struct {
     // A/V sync handle (optional)
     struct AVSync_Handle *avsync;
     
+    // Refill-request hook (optional)
+    Audio_RefillHook refill_hook;
+    void *refill_hook_ctx;
+    
     // Buffer state - LEFT channel is master, RIGHT follows
-    volatile bool needs_refill;             // Set by ISR when buffer half consumed
-    volatile Audio_BufferHalf fill_half;    // Which half needs filling
+    volatile uint32_t segments_filled;      // Segments written since start (incl. pre-fill)
     
     // Playback state
     Audio_State state;
@@ -105,14 +159,26 @@ Audio_Status audio_Init(Audio_Handle *audio, DAC_HandleTypeDef *hdac, TIM_Handle
  * @brief Link A/V synchronization
  * @param audio Handle
  * @param sync  AVSync handle to update from audio ISR
+ * @note  Also installs audio_GetPlaybackPosition() as the sync clock source
  */
 void audio_SetAVSync(Audio_Handle *audio, struct AVSync_Handle *sync);
 
+/**
+ * @brief Set hook called at each half/full-ring DMA interrupt
+ * @param audio Handle
+ * @param hook  Function called from DMA ISR context, after the position update
+ * @param ctx   Passed to hook
+ * @note  Set after audio_Init() (init clears the handle)
+ * @note  Fires once per AUDIO_RING_HALF_SAMPLES, when AUDIO_SEGMENT_COUNT / 2
+ *        segments have come free together, never per segment
+ */
+void audio_SetRefillHook(Audio_Handle *audio, Audio_RefillHook hook, void *ctx);
+
 /**
  * @brief Start audio playback
  * @param audio Handle
  * @return AUDIO_OK on success
- * @note  Pre-fill both buffer halves before calling this!
+ * @note  Pre-fill every segment before calling this!
  */
 Audio_Status audio_Start(Audio_Handle *audio);
 
@@ -125,40 +191,69 @@ void audio_Stop(Audio_Handle *audio);
 /* ========================== Buffer Management ========================== */
 
 /**
- * @brief Check if audio buffer needs refilling
+ * @brief Check if a segment is free to refill
  * @param audio Handle
- * @return true if main loop should fill buffer
+ * @return true once the DMA has played all of the next segment to write
  */
 bool audio_NeedsRefill(Audio_Handle *audio);
 
 /**
- * @brief Get which buffer half needs filling
+ * @brief Get the segment to fill next
+ * @param audio Handle
+ * @return Sample offset of the segment within the ring
+ */
+uint32_t audio_GetFillOffset(Audio_Handle *audio);
+
+/**
+ * @brief Get pointer to packed L|R DMA buffer
  * @param audio Handle
- * @return AUDIO_BUFFER_FIRST_HALF or AUDIO_BUFFER_SECOND_HALF
+ * @return Pointer to start of packed ring (AUDIO_RING_SAMPLES words), NULL in split mode
  */
-Audio_BufferHalf audio_GetFillHalf(Audio_Handle *audio);
+uint32_t* audio_GetPackedBuffer(Audio_Handle *audio);
 
 /**
  * @brief Get pointer to left channel DMA buffer
  * @param audio Handle
- * @return Pointer to start of left channel buffer (4096 samples)
+ * @return Pointer to start of left channel ring (AUDIO_RING_SAMPLES), NULL in packed mode
  */
 uint16_t* audio_GetLeftBuffer(Audio_Handle *audio);
 
 /**
  * @brief Get pointer to right channel DMA buffer
  * @param audio Handle
- * @return Pointer to start of right channel buffer (4096 samples)
+ * @return Pointer to start of right channel ring (AUDIO_RING_SAMPLES), NULL in packed mode
  */
 uint16_t* audio_GetRightBuffer(Audio_Handle *audio);
 
 /**
- * @brief Mark buffer as filled (clear refill flag)
+ * @brief Mark the segment at audio_GetFillOffset() as filled
  * @param audio Handle
- * @note  Call after filling BOTH left and right channel halves
+ * @note  Call after filling the segment (both channels in split mode). While
+ *        playing, also records the refill's slack in the stats.
  */
 void audio_BufferFilled(Audio_Handle *audio);
 
+/* ========================== Playback Position ========================== */
+
+/**
+ * @brief Get sample-exact playback position
+ * @param audio Handle
+ * @return Samples played since audio_Start()
+ * 
+ * Combines the completed half-ring count with the DAC DMA channel's
+ * remaining-transfer counter (CNDTR), so the position advances every
+ * sample instead of in half-ring steps. Safe to call from the main loop
+ * while a half/complete interrupt is pending.
+ */
+uint32_t audio_GetPlaybackPosition(Audio_Handle *audio);
+
+/**
+ * @brief Get audio queued ahead of the DAC
+ * @param audio Handle
+ * @return Samples written ahead of the DMA read position
+ */
+uint32_t audio_GetBufferedSamples(Audio_Handle *audio);
+
 /* ========================== Statistics ========================== */
 
 /**
@@ -14,12 +14,30 @@
  *   - DAC DMA runs at fixed rate, can't speed up or slow down
  *   - Video can drop/repeat frames without major artifacts
  * 
+ * Timebase:
+ *   Frame = samples * fps_num / (sample_rate * fps_den), computed exactly
+ *   in 64-bit. A truncated samples-per-frame (32000 / 30 = 1066) would run
+ *   video 0.06% fast, drifting ~4 frames over the clip; the rational form
+ *   has no cumulative drift and handles 29.97 fps (30000/1001).
+ * 
+ * Presentation:
+ *   A frame is visible only once its ~1 KB I2C transfer finishes, so the
+ *   player renders the frame due at (now + transfer latency) and starts its
+ *   DMA at the deadline (due sample - latency). The latency is an EWMA of
+ *   measured transfers; the error between each frame's due sample and its
+ *   transfer completion is recorded in the stats. All times are in audio
+ *   samples.
+ * 
  * Usage:
- *   1. AVSync_Init() with sample rate and FPS
+ *   1. AVSync_Init() with sample rate and FPS (AVSync_InitRational() for
+ *      non-integer rates)
  *   2. AVSync_Start() when playback begins
- *   3. AVSync_AudioTick() from audio DMA half-complete ISR
+ *   3. AVSync_AudioTick() from audio DMA half-complete ISR, and optionally
+ *      AVSync_SetClockSource() for a sample-exact position between ticks
  *   4. AVSync_GetFrameDecision() in main loop to decide what to do
  *   5. AVSync_FrameRendered()/FrameSkipped() after handling frame
+ *   6. AVSync_IsPresentDue() before starting a display transfer, and
+ *      AVSync_FramePresented() once it completes
  */
 
 #ifndef AV_SYNC_H
@@ -34,6 +52,13 @@
 // Default maximum drift before corrective action (in frames)
 #define AVSYNC_DEFAULT_MAX_DRIFT    2
 
+// Display transfer latency estimate before the first measurement (ms);
+// about one full frame on the 1 MHz display bus
+#define AVSYNC_INITIAL_LATENCY_MS   10
+
+// Latency EWMA weight: new = old + (sample - old) / 2^shift
+#define AVSYNC_LATENCY_SHIFT        3
+
 /* ========================== Types ========================== */
 
 typedef enum {
@@ -56,18 +81,43 @@ typedef struct {
     uint32_t frames_repeated;   // Frames repeated (video was ahead)
     int32_t max_drift;          // Maximum observed drift (frames)
     int32_t min_drift;          // Minimum observed drift (frames)
+    
+    // Presentation (audio samples; positive = frame shown late)
+    uint32_t frames_presented;      // Transfers completed
+    int32_t present_error_last;     // Completion - due, last frame
+    int32_t present_error_min;      // Earliest presentation
+    int32_t present_error_max;      // Latest presentation
+    uint64_t present_error_abs_sum; // Sum of |error| (mean = sum / presented)
+    uint32_t present_latency_max;   // Longest transfer
+    uint32_t frames_over_budget;    // Transfers longer than one frame period
 } AVSync_Stats;
 
+/**
+ * @brief High-resolution audio clock: samples played since playback start
+ * @param ctx Context pointer given to AVSync_SetClockSource()
+ */
+typedef uint32_t (*AVSync_ClockFn)(void *ctx);
+
 typedef struct AVSync_Handle {
     // Configuration (set at init, don't modify)
     uint32_t audio_sample_rate;     // e.g., 32000 Hz
-    uint32_t video_fps;             // e.g., 30 FPS
-    uint32_t samples_per_frame;     // Calculated: sample_rate / fps
+    uint32_t fps_num;               // Frame rate numerator, e.g., 30 or 30000
+    uint32_t fps_den;               // Frame rate denominator, e.g., 1 or 1001
+    uint64_t samples_per_frame_den; // sample_rate * fps_den (frame divisor)
     uint32_t max_drift_frames;      // Threshold for skip/repeat
+    uint32_t render_ahead_frames;   // Extra lead allowed before repeat (render-ahead)
     
     // Playback state
     AVSync_State state;
     volatile uint32_t audio_samples_played;  // Updated from ISR
+    
+    // Optional sample-exact clock (overrides the ISR count when set)
+    AVSync_ClockFn clock_fn;
+    void *clock_ctx;
+    uint32_t clock_base;                     // Clock reading at AVSync_Start()
+    
+    // Display transfer latency estimate (EWMA, samples)
+    uint32_t present_latency;
     uint32_t video_frames_rendered;          // Includes skipped frames
     
     // Statistics
@@ -89,6 +139,37 @@ typedef struct AVSync_Handle {
 void AVSync_Init(AVSync_Handle *sync, uint32_t sample_rate, 
                  uint32_t video_fps, uint32_t max_drift);
 
+/**
+ * @brief Initialize A/V sync with a rational frame rate
+ * @param sync        Handle to initialize
+ * @param sample_rate Audio sample rate in Hz (e.g., 32000)
+ * @param fps_num     Frame rate numerator (e.g., 30000)
+ * @param fps_den     Frame rate denominator (e.g., 1001 for 29.97 fps)
+ * @param max_drift   Max drift in frames before correction (0 = use default)
+ */
+void AVSync_InitRational(AVSync_Handle *sync, uint32_t sample_rate,
+                         uint32_t fps_num, uint32_t fps_den, uint32_t max_drift);
+
+/**
+ * @brief Allow video to be decoded ahead of the audio clock
+ * @param sync   Handle
+ * @param frames Frames video may lead by (on top of max drift) before
+ *               AVSync_GetFrameDecision() returns AVSYNC_REPEAT_FRAME
+ */
+void AVSync_SetRenderAhead(AVSync_Handle *sync, uint32_t frames);
+
+/**
+ * @brief Use a sample-exact clock instead of the ISR tick count
+ * @param sync Handle
+ * @param fn   Clock function (NULL reverts to AVSync_AudioTick() counting)
+ * @param ctx  Passed to fn
+ * 
+ * AVSync_AudioTick() advances in whole DMA half-buffers (64 ms at 32 kHz),
+ * so frame decisions jump in bursts. A clock that also reads the DMA
+ * position lets the current frame advance one frame at a time.
+ */
+void AVSync_SetClockSource(AVSync_Handle *sync, AVSync_ClockFn fn, void *ctx);
+
 /**
  * @brief Start synchronization (call when playback begins)
  * @param sync Handle
@@ -139,8 +220,64 @@ void AVSync_FrameRendered(AVSync_Handle *sync);
  */
 void AVSync_FrameSkipped(AVSync_Handle *sync);
 
+/* ========================== Presentation ========================== */
+
+/**
+ * @brief Get the audio position at which a frame is due
+ * @param sync  Handle
+ * @param frame Frame index
+ * @return First sample (since AVSync_Start()) belonging to the frame
+ */
+uint32_t AVSync_GetFrameDueSample(const AVSync_Handle *sync, uint32_t frame);
+
+/**
+ * @brief Get the frame to render now so it is due when its transfer lands
+ * @param sync Handle
+ * @return Frame at (audio position + transfer latency)
+ */
+uint32_t AVSync_GetPresentFrame(const AVSync_Handle *sync);
+
+/**
+ * @brief Check whether a frame's display transfer should start now
+ * @param sync  Handle
+ * @param frame Frame index of the ready buffer
+ * @return true once the audio position reaches due sample - latency
+ */
+bool AVSync_IsPresentDue(const AVSync_Handle *sync, uint32_t frame);
+
+/**
+ * @brief Record a completed display transfer
+ * @param sync     Handle
+ * @param frame    Frame index that was transferred
+ * @param start    Audio position when the transfer started
+ * @param complete Audio position when the transfer completed
+ * 
+ * Updates the latency EWMA and the presentation error statistics, and
+ * counts the transfer against the frame budget: at the file's frame rate
+ * the display must take a frame in less than one frame period (16.7 ms at
+ * 60 fps) or the queue backs up and frames are dropped.
+ */
+void AVSync_FramePresented(AVSync_Handle *sync, uint32_t frame,
+                           uint32_t start, uint32_t complete);
+
+/**
+ * @brief Get the display transfer latency estimate
+ * @param sync Handle
+ * @return Latency in audio samples
+ */
+static inline uint32_t AVSync_GetPresentLatency(const AVSync_Handle *sync) {
+    return sync ? sync->present_latency : 0;
+}
+
 /* ========================== Query Functions ========================== */
 
+/**
+ * @brief Get audio playback position since AVSync_Start()
+ * @param sync Handle
+ * @return Samples played (sample-exact if a clock source is set)
+ */
+uint32_t AVSync_GetAudioPosition(const AVSync_Handle *sync);
+
 /**
  * @brief Get current frame number based on audio position
  * @param sync Handle
@@ -4,15 +4,20 @@
  * @author  David Leathers
  * @date    November 2025
  * 
- * Provides triple-buffered display system and shared constants.
+ * Provides the display frame queue and shared constants.
  * All buffers are statically allocated and DMA-aligned.
  * 
- * Triple Buffer Operation:
- *   - render:   Main loop draws next frame here
- *   - ready:    Completed frame waiting for transfer
- *   - transfer: Currently being DMA'd to display
+ * Frame Queue Operation (single producer, single consumer):
+ *   - Producer (main loop): FrameQueue_AcquireRender() -> draw ->
+ *     FrameQueue_Publish(frame number)
+ *   - Consumer (display DMA): FrameQueue_Consume() -> transfer ->
+ *     FrameQueue_Release() from the DMA complete callback
  * 
- * Flow: render → ready (on SwapBuffers) → transfer (on StartTransfer)
+ * Slots [tail, head) are published frames, oldest first; the oldest may be
+ * in transfer. Slot head % depth is the render slot while the queue is not
+ * full. Only the producer writes head and only the consumer writes tail,
+ * each published with release ordering, so no interrupt masking is needed.
+ * The producer can run up to FRAME_QUEUE_DEPTH frames ahead of the display.
  */
 
 #ifndef BUFFERS_H
@@ -28,29 +33,65 @@
 #define DISPLAY_WIDTH           128
 #define DISPLAY_HEIGHT          64
 #define FRAMEBUFFER_SIZE        (DISPLAY_WIDTH * DISPLAY_HEIGHT / 8)  // 1024 bytes
-#define FRAMEBUFFER_COUNT       3   // Triple buffer
+
+// Frame queue depth (framebuffers); the renderer can queue this many frames
+#ifndef FRAME_QUEUE_DEPTH
+#define FRAME_QUEUE_DEPTH       4
+#endif
+#define FRAMEBUFFER_COUNT       FRAME_QUEUE_DEPTH
 
 /* ========================== Audio Configuration ========================== */
 
 #define AUDIO_SAMPLE_RATE       32000   // Hz
-#define AUDIO_BUFFER_SAMPLES    2048    // Samples per half-buffer
+
+// DAC ring: AUDIO_SEGMENT_COUNT segments, each refilled as a unit. The
+// DMA interrupts per half-ring, so refills come AUDIO_SEGMENT_COUNT / 2
+// segments at a time (ring RAM is 4 bytes per sample in either DAC mode):
+//   2 x 2048 - default, 1 segment every 64 ms, 128 ms buffered (16 KB)
+//   4 x 512  - short SD reads, 2 segments every 32 ms, 64 ms buffered (8 KB)
+//   6 x 2048 - stall tolerant, 3 segments every 192 ms, 384 ms buffered (48 KB)
+// The count must be even so the DMA half/complete interrupts fall on
+// segment boundaries.
+#ifndef AUDIO_SEGMENT_SAMPLES
+#define AUDIO_SEGMENT_SAMPLES   2048    // Samples per segment
+#endif
+#ifndef AUDIO_SEGMENT_COUNT
+#define AUDIO_SEGMENT_COUNT     2
+#endif
+
+#if (AUDIO_SEGMENT_COUNT < 2) || (AUDIO_SEGMENT_COUNT % 2)
+#error "AUDIO_SEGMENT_COUNT must be even and at least 2"
+#endif
+
+// SRAM1 (96 KB) the ring may take. The other large statics, at 2048-sample
+// segments:
+//   framebuffers (FRAME_QUEUE_DEPTH x 1 KB)           4 KB
+//   display shadow + internal buffer                  2 KB
+//   OSD bits + mask layers                            2 KB
+//   media audio read buffer (4 bytes per sample)      8 KB
+//   media chunk frames (MEDIA_CHUNK_STAGING only)     8 KB
+//   media delta reference + window, ADPCM tail      3.5 KB
+//   FAT scan window                                   4 KB
+//   SD block buffer + extent map                   1.25 KB
+// about 33 KB with staging on, which leaves 15 KB below this budget for the
+// stack, heap, handles and HAL state. An 8 x 2048 ring (64 KB) does not fit.
+#ifndef AUDIO_RING_RAM_BUDGET
+#define AUDIO_RING_RAM_BUDGET   (48 * 1024)
+#endif
 
 /* ========================== Display Framebuffers ========================== */
 
 extern uint8_t g_framebuffer[FRAMEBUFFER_COUNT][FRAMEBUFFER_SIZE];
 
-/* ========================== Triple Buffer State ========================== */
+/* ========================== Frame Queue State ========================== */
 
 typedef struct {
-    volatile uint8_t render;            // Index: main loop renders here
-    volatile uint8_t ready;             // Index: completed, awaiting transfer
-    volatile uint8_t transfer;          // Index: currently transferring via DMA
-    volatile bool transfer_busy;        // DMA transfer in progress
-    volatile uint32_t frames_rendered;  // Total frames drawn
-    volatile uint32_t frames_transferred; // Total frames sent to display
-} TripleBuffer_State;
+    volatile uint32_t head;             // Frames published (producer-owned)
+    volatile uint32_t tail;             // Frames released (consumer-owned)
+    uint32_t tag[FRAMEBUFFER_COUNT];    // Frame number per slot (set before publish)
+} FrameQueue;
 
-extern TripleBuffer_State g_display_buffers;
+extern FrameQueue g_frame_queue;
 
 /* ========================== Initialization ========================== */
 
@@ -60,77 +101,66 @@ extern TripleBuffer_State g_display_buffers;
  */
 void Buffers_Init(void);
 
-/* ========================== Display Buffer API ========================== */
-
-/**
- * @brief Get pointer to current render buffer
- * @return Pointer to 1024-byte framebuffer for drawing
- */
-static inline uint8_t* Display_GetRenderBuffer(void) {
-    return g_framebuffer[g_display_buffers.render];
-}
+/* ========================== Frame Queue API ========================== */
 
 /**
- * @brief Swap render buffer to ready queue
- * @note  Call after frame is fully rendered
- * 
- * Atomically swaps render and ready indices. The just-rendered
- * frame becomes available for transfer to the display.
+ * @brief Get the number of published frames not yet released
+ * @return Queued frames, including one in transfer
  */
-static inline void Display_SwapBuffers(void) {
-    __disable_irq();
-    uint8_t old_ready = g_display_buffers.ready;
-    g_display_buffers.ready = g_display_buffers.render;
-    g_display_buffers.render = old_ready;
-    g_display_buffers.frames_rendered++;
-    __enable_irq();
+static inline uint32_t FrameQueue_Count(void) {
+    return __atomic_load_n(&g_frame_queue.head, __ATOMIC_ACQUIRE) -
+           __atomic_load_n(&g_frame_queue.tail, __ATOMIC_ACQUIRE);
 }
 
 /**
- * @brief Check if a new frame is ready for transfer
- * @return true if frames_rendered > frames_transferred
+ * @brief Acquire the render slot (producer)
+ * @return Pointer to a 1024-byte framebuffer, or NULL if the queue is full
+ * @note  Returns the same slot until FrameQueue_Publish()
  */
-static inline bool Display_HasFrame(void) {
-    return g_display_buffers.frames_rendered > g_display_buffers.frames_transferred;
+static inline uint8_t* FrameQueue_AcquireRender(void) {
+    uint32_t head = g_frame_queue.head;
+    uint32_t tail = __atomic_load_n(&g_frame_queue.tail, __ATOMIC_ACQUIRE);
+    
+    if (head - tail >= FRAMEBUFFER_COUNT) return NULL;
+    return g_framebuffer[head % FRAMEBUFFER_COUNT];
 }
 
 /**
- * @brief Get pointer to current transfer buffer
- * @return Pointer to buffer being sent to display
- * @note   Only valid while transfer_busy is true
+ * @brief Publish the render slot as the newest queued frame (producer)
+ * @param frame Frame number, returned by FrameQueue_Consume()
+ * @note  Call only after FrameQueue_AcquireRender() returned a slot
  */
-static inline uint8_t* Display_GetTransferBuffer(void) {
-    return g_framebuffer[g_display_buffers.transfer];
+static inline void FrameQueue_Publish(uint32_t frame) {
+    uint32_t head = g_frame_queue.head;
+    
+    g_frame_queue.tag[head % FRAMEBUFFER_COUNT] = frame;
+    __atomic_store_n(&g_frame_queue.head, head + 1, __ATOMIC_RELEASE);
 }
 
 /**
- * @brief Begin DMA transfer of ready frame
- * @return true if transfer started, false if busy or no frame ready
- * 
- * Atomically swaps ready and transfer indices. Caller must then
- * initiate actual DMA transfer of Display_GetTransferBuffer().
+ * @brief Get the oldest queued frame (consumer)
+ * @param frame Receives its frame number (may be NULL)
+ * @return Pointer to the framebuffer, or NULL if the queue is empty
+ * @note  Does not dequeue; the slot stays owned until FrameQueue_Release()
  */
-static inline bool Display_StartTransfer(void) {
-    if (g_display_buffers.transfer_busy) return false;
-    if (!Display_HasFrame()) return false;
-    
-    __disable_irq();
-    uint8_t old_transfer = g_display_buffers.transfer;
-    g_display_buffers.transfer = g_display_buffers.ready;
-    g_display_buffers.ready = old_transfer;
-    g_display_buffers.transfer_busy = true;
-    __enable_irq();
+static inline uint8_t* FrameQueue_Consume(uint32_t *frame) {
+    uint32_t tail = g_frame_queue.tail;
+    uint32_t head = __atomic_load_n(&g_frame_queue.head, __ATOMIC_ACQUIRE);
     
-    return true;
+    if (head == tail) return NULL;
+    if (frame) *frame = g_frame_queue.tag[tail % FRAMEBUFFER_COUNT];
+    return g_framebuffer[tail % FRAMEBUFFER_COUNT];
 }
 
 /**
- * @brief Mark DMA transfer as complete
- * @note  Call from DMA complete callback
+ * @brief Release the oldest queued frame back to the producer (consumer)
+ * @note  Call from the DMA complete callback, or to drop a stale frame
  */
-static inline void Display_TransferComplete(void) {
-    g_display_buffers.transfer_busy = false;
-    g_display_buffers.frames_transferred++;
+static inline void FrameQueue_Release(void) {
+    uint32_t tail = g_frame_queue.tail;
+    
+    if (tail == __atomic_load_n(&g_frame_queue.head, __ATOMIC_ACQUIRE)) return;
+    __atomic_store_n(&g_frame_queue.tail, tail + 1, __ATOMIC_RELEASE);
 }
 
 #endif // BUFFERS_H
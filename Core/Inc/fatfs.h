@@ -7,7 +7,7 @@
  * Features:
  *   - FAT32 partition detection (MBR or direct)
  *   - Root directory file search
- *   - Cluster chain traversal
+ *   - Cluster chain traversal with a small LRU cache of FAT sectors
  *   - Read-only (no write support)
  * 
  * Limitations:
@@ -42,6 +42,13 @@
 // Cluster chain markers
 #define FAT_CLUSTER_END         0x0FFFFFF8  // >= this means end of chain
 
+// FAT sector cache (each entry holds 128 cluster entries)
+#define FAT_CACHE_ENTRIES       2       // Cached FAT sectors (512 bytes each)
+#define FAT_ENTRIES_PER_SECTOR  (FAT_SECTOR_SIZE / 4)   // 128
+
+// Bulk chain scan
+#define FAT_SCAN_SECTORS        8       // FAT sectors per multi-block read (1024 entries)
+
 /* ========================== Types ========================== */
 
 typedef enum {
@@ -66,11 +73,27 @@ typedef struct {
     uint32_t data_start_sector;     // First data sector (absolute)
 } FAT_BootSector;
 
+// One cached FAT sector
+typedef struct {
+    uint32_t sector;                    // Absolute sector held (0 = empty)
+    uint32_t last_used;                 // LRU stamp
+    uint8_t data[FAT_SECTOR_SIZE] __attribute__((aligned(4)));
+} FAT_CacheEntry;
+
+// FAT sector cache - separate from the shared scratch buffer
+typedef struct {
+    FAT_CacheEntry entries[FAT_CACHE_ENTRIES];
+    uint32_t tick;                      // LRU clock
+    uint32_t hits;                      // Lookups served from cache
+    uint32_t misses;                    // Lookups that read the SD card
+} FAT_Cache;
+
 // Mounted volume state
 typedef struct {
     SD_Handle *hsd;                     // SD card handle
     FAT_BootSector boot;                // Parsed boot sector
     uint8_t sector_buffer[FAT_SECTOR_SIZE];  // Scratch buffer
+    FAT_Cache fat_cache;                // Cached FAT sectors for chain walks
     bool mounted;                       // Mount successful
 } FAT_Volume;
 
@@ -81,6 +104,24 @@ typedef struct {
     uint8_t attributes;         // File attributes
 } FAT_FileInfo;
 
+/**
+ * @brief Run callback for FAT_ScanChain()
+ * @param ctx           User context
+ * @param file_cluster  Index of the run's first cluster within the file
+ * @param start_cluster First cluster of the run on disk
+ * @param length        Consecutive clusters in the run
+ * @return false to stop scanning
+ */
+typedef bool (*FAT_RunCallback)(void *ctx, uint32_t file_cluster,
+                                uint32_t start_cluster, uint32_t length);
+
+// Chain scan results
+typedef struct {
+    uint32_t clusters;          // Clusters visited
+    uint32_t runs;              // Runs reported to the callback
+    uint32_t sectors_read;      // FAT sectors read from the card
+} FAT_ScanResult;
+
 /* ========================== Core API ========================== */
 
 /**
@@ -112,9 +153,30 @@ FAT_Status FAT_FindFile(FAT_Volume *vol, const char *filename, FAT_FileInfo *inf
  * @param vol     Mounted volume
  * @param cluster Current cluster number
  * @return Next cluster, or 0 on error, or >= FAT_CLUSTER_END for end-of-chain
+ * 
+ * FAT sectors are served from vol->fat_cache, so walking a chain costs one
+ * SD read per 128 clusters and never touches vol->sector_buffer.
  */
 uint32_t FAT_GetNextCluster(FAT_Volume *vol, uint32_t cluster);
 
+/**
+ * @brief Scan a cluster chain and report runs of consecutive clusters
+ * @param vol           Mounted volume
+ * @param first_cluster First cluster of the chain
+ * @param max_clusters  Stop after this many clusters (file size in clusters)
+ * @param callback      Called once per run, in file order
+ * @param ctx           Passed to callback
+ * @param result        Output: scan counters (may be NULL)
+ * @return FAT_OK on success (including when the callback stops the scan)
+ * 
+ * Reads the FAT FAT_SCAN_SECTORS sectors at a time with one multi-block
+ * read and follows links within that window in a tight loop, so a
+ * contiguous file costs one SD command per 1024 clusters. Bypasses the
+ * FAT cache and vol->sector_buffer.
+ */
+FAT_Status FAT_ScanChain(FAT_Volume *vol, uint32_t first_cluster, uint32_t max_clusters,
+                         FAT_RunCallback callback, void *ctx, FAT_ScanResult *result);
+
 /**
  * @brief Convert cluster number to absolute sector number
  * @param vol     Mounted volume
@@ -142,6 +204,15 @@ static inline uint32_t FAT_GetClusterSize(const FAT_Volume *vol) {
     return (uint32_t)vol->boot.sectors_per_cluster * FAT_SECTOR_SIZE;
 }
 
+/**
+ * @brief Get FAT cache statistics
+ * @param vol Mounted volume
+ * @return Pointer to cache (hits/misses valid while volume exists)
+ */
+static inline const FAT_Cache* FAT_GetCacheStats(const FAT_Volume *vol) {
+    return vol ? &vol->fat_cache : NULL;
+}
+
 /* ========================== Utility ========================== */
 
 /**
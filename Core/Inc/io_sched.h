@@ -0,0 +1,199 @@
+/**
+ * @file    io_sched.h
+ * @brief   Deadline-aware SD read scheduler (audio before video)
+ * @author  David Leathers
+ * @date    November 2025
+ * 
+ * Audio refills and video frame reads share one SPI bus. Issued in call
+ * order, a frame read that starts just before a ring segment is freed
+ * holds the refill off for its whole duration. The scheduler queues both
+ * kinds of read, each tagged with a deadline on the A/V sync audio clock:
+ * 
+ *   - Audio: the sample at which the DAC DMA reaches the segment being
+ *     refilled (now + audio_GetBufferedSamples())
+ *   - Video: the frame's due sample (AVSync_GetFrameDueSample())
+ * 
+ * A pending refill is always serviced first. Video reads are issued one
+ * sector at a time, and the refill flag is checked between sectors, so a
+ * refill waits at most one sector read. Consecutive slices continue the
+ * SD stream, so splitting a frame costs no extra commands.
+ * 
+ * Refill context (IO_SCHED_REFILL_IRQ):
+ *   0 - refills run from IOSched_Run() in the main loop, so they start
+ *       only when the loop gets there
+ *   1 - the DAC DMA ISR pends PendSV, which refills every free segment at
+ *       the lowest interrupt priority. It preempts rendering and display work at any
+ *       point, while DMA completions (SPI3 included) still preempt it. The
+ *       main loop marks the SD bus busy for each media read; a refill that
+ *       fires inside one is deferred and re-pended when the read returns,
+ *       so at most one sector (or one whole delta frame) is ahead of it.
+ * 
+ * Usage:
+ *   1. IOSched_Init() after the media file, audio driver and A/V sync
+ *   2. IOSched_SetHandlers() with the audio fill and video done handlers
+ *   3. IOSched_SubmitVideo() to queue a frame read
+ *   4. IOSched_Run() from the main loop (queues refills as they fall due
+ *      and services requests until the queue is empty)
+ *   5. IOSched_AudioHalfDone() from the audio refill hook, and (IRQ mode)
+ *      IOSched_RefillIRQHandler() from PendSV_Handler()
+ */
+
+#ifndef IO_SCHED_H
+#define IO_SCHED_H
+
+#include "stm32l4xx.h"
+#include "media_file_reader.h"
+#include "audio_dac.h"
+#include "av_sync.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ========================== Configuration ========================== */
+
+// Queued requests (frame reads, plus one slot kept for a refill)
+#define IO_SCHED_MAX_REQUESTS       4
+
+// Video read granularity - refills can preempt between slices
+#define IO_SCHED_SLICE_BYTES        SD_BLOCK_SIZE
+
+// Refill from PendSV (1) or from the main loop (0)
+#ifndef IO_SCHED_REFILL_IRQ
+#define IO_SCHED_REFILL_IRQ         1
+#endif
+
+/* ========================== Types ========================== */
+
+typedef enum {
+    IO_REQ_AUDIO = 0,           // Refill the next ring segment the DMA has freed
+    IO_REQ_VIDEO                // Read one frame into a render buffer
+} IO_RequestType;
+
+typedef struct {
+    IO_RequestType type;
+    uint32_t deadline;          // Audio clock sample the read must finish by
+    uint32_t frame;             // Video: frame index
+    uint8_t *buffer;            // Video: destination (MEDIA_FRAME_SIZE bytes)
+    uint32_t done;              // Video: bytes read so far
+} IO_Request;
+
+// Scheduler statistics
+typedef struct {
+    uint32_t audio_serviced;    // Refills completed
+    uint32_t video_serviced;    // Frame reads completed
+    uint32_t video_slices;      // Sector-sized video reads issued
+    uint32_t preemptions;       // Frame reads paused for a refill
+    uint32_t audio_missed;      // Refills finished after their deadline
+    uint32_t video_missed;      // Frame reads finished after the frame was due
+    uint32_t depth_max;         // Deepest queue observed
+    uint32_t audio_max_us;      // Longest refill
+    uint32_t refill_latency_max_us;  // Longest ring interrupt to refill start
+    uint32_t refills_deferred;  // IRQ refills that waited for a media read
+} IO_Stats;
+
+/**
+ * @brief Fill one audio ring segment from the media file
+ * @param ctx    Context pointer given to IOSched_SetHandlers()
+ * @param offset Sample offset of the segment (from audio_GetFillOffset())
+ * @return false if nothing was written
+ */
+typedef bool (*IO_AudioFillFn)(void *ctx, uint32_t offset);
+
+/**
+ * @brief Frame read finished (buffer holds the frame unless status failed)
+ */
+typedef void (*IO_VideoDoneFn)(void *ctx, uint32_t frame, uint8_t *buffer, FAT_Status status);
+
+typedef struct {
+    MediaFile *media;
+    Audio_Handle *audio;
+    AVSync_Handle *sync;
+    
+    // Request handlers
+    IO_AudioFillFn audio_fill;
+    IO_VideoDoneFn video_done;
+    void *handler_ctx;
+    
+    // Pending requests (unordered; selection scans by type and deadline)
+    IO_Request queue[IO_SCHED_MAX_REQUESTS];
+    uint32_t depth;
+    
+    // Refill timing and IRQ-mode bus ownership
+    volatile uint32_t refill_requested_at;  // DWT cycles at the last ring ISR
+    volatile bool bus_busy;                 // Main loop is inside a media read
+    volatile bool refill_deferred;          // PendSV found the bus busy
+    
+    // Statistics
+    IO_Stats stats;
+    
+    // Init flag
+    bool initialized;
+} IO_Sched;
+
+/* ========================== API ========================== */
+
+/**
+ * @brief Initialize the scheduler
+ * @param sched Handle to initialize
+ * @param media Open media file
+ * @param audio Audio driver (refill flag and buffered samples)
+ * @param sync  A/V sync (deadline clock and frame due times)
+ */
+void IOSched_Init(IO_Sched *sched, MediaFile *media, Audio_Handle *audio, AVSync_Handle *sync);
+
+/**
+ * @brief Set the request handlers
+ * @param sched Handle
+ * @param fill  Reads audio into a segment (called before audio_BufferFilled())
+ * @param done  Called when a frame read completes
+ * @param ctx   Passed to both handlers
+ */
+void IOSched_SetHandlers(IO_Sched *sched, IO_AudioFillFn fill, IO_VideoDoneFn done, void *ctx);
+
+/**
+ * @brief Queue a frame read
+ * @param sched  Handle
+ * @param frame  Frame index
+ * @param buffer Destination (MEDIA_FRAME_SIZE bytes)
+ * @return false if the queue is full (the last slot is kept for a refill)
+ */
+bool IOSched_SubmitVideo(IO_Sched *sched, uint32_t frame, uint8_t *buffer);
+
+/**
+ * @brief Queue a refill if one is due and service requests until idle
+ * @param sched Handle
+ * 
+ * Each step services the pending refill if there is one, otherwise one
+ * slice of the frame read with the earliest deadline.
+ */
+void IOSched_Run(IO_Sched *sched);
+
+/**
+ * @brief Note a half/full-ring DMA interrupt (audio refill hook, ISR)
+ * @param sched Handle
+ * 
+ * Timestamps the request for the refill latency stat and, in IRQ mode,
+ * pends PendSV.
+ */
+void IOSched_AudioHalfDone(IO_Sched *sched);
+
+/**
+ * @brief Run a pending refill (PendSV_Handler(), IRQ mode)
+ * @param sched Handle
+ */
+void IOSched_RefillIRQHandler(IO_Sched *sched);
+
+/**
+ * @brief Get the number of queued requests
+ */
+static inline uint32_t IOSched_GetDepth(const IO_Sched *sched) {
+    return sched ? sched->depth : 0;
+}
+
+/**
+ * @brief Get scheduler statistics
+ */
+static inline const IO_Stats* IOSched_GetStats(const IO_Sched *sched) {
+    return sched ? &sched->stats : NULL;
+}
+
+#endif // IO_SCHED_H
@@ -51,6 +51,10 @@ extern DMA_HandleTypeDef hdma_spi3_rx;
 #define LED_Pin             GPIO_PIN_3
 #define LED_GPIO_Port       GPIOB
 
+// User button B1 (Nucleo, active low with external pull-up) - overlay toggle
+#define B1_Pin              GPIO_PIN_13
+#define B1_GPIO_Port        GPIOC
+
 /* ========================== Function Prototypes ========================== */
 
 void Error_Handler(void);
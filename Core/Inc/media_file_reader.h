@@ -6,7 +6,7 @@
  * 
  * Reads custom binary format containing video frames and audio data.
  * 
- * File Format:
+ * File Format v2 (legacy):
  *   - Header: 20 bytes
  *       [0-3]   frame_count (uint32_t LE)
  *       [4-7]   audio_size in bytes (uint32_t LE)
@@ -16,11 +16,75 @@
  *   - Video: frame_count * 1024 bytes (1024 bytes per frame)
  *   - Audio: audio_size bytes (16-bit stereo interleaved PCM)
  * 
+ * File Format v3 (sector-aligned):
+ *   - Header: 512 bytes (one sector, zero padded)
+ *       [0-3]   magic "BAV3"
+ *       [4-7]   version = 3
+ *       [8-11]  header_size in bytes (512)
+ *       [12-15] frame_count
+ *       [16-19] audio_size in bytes
+ *       [20-23] sample_rate in Hz
+ *       [24-27] channels
+ *       [28-31] bits_per_sample
+ *       [32-35] video_offset (multiple of 512)
+ *       [36-39] audio_offset (multiple of 512)
+ *       [40-43] video_codec (0 = raw frames, 1 = XOR/RLE delta)
+ *       [44-47] video_size in bytes (size of the video region)
+ *       [48-51] keyframe_interval (delta only)
+ *       [52-55] keyframe_count (delta only)
+ *       [56-59] keyframe_table_offset (delta only, multiple of 512)
+ *       [60-63] audio_codec (0 = PCM, 1 = IMA ADPCM)
+ *       [64-67] audio_samples (stereo sample count; ADPCM only)
+ *       [68-71] layout (0 = separate regions, 1 = interleaved chunks)
+ *       [72-75] chunk_samples (interleaved only)
+ *       [76-79] chunk_fps (interleaved only)
+ *       [80-83] fps_num (frame rate numerator; 0 = 30 fps)
+ *       [84-87] fps_den (frame rate denominator, e.g. 30000/1001 = 29.97)
+ *   - Video and audio regions start on sector boundaries, so every frame
+ *     and every audio refill is read by DMA straight into its destination
+ *     without touching the scratch sector buffer.
+ * 
+ * v2 files are detected by the absence of the magic (their first word is
+ * the frame count).
+ * 
+ * Delta video (v3, video_codec = 1):
+ *   - Video region is a stream of variable-length records, one per frame:
+ *       [0-1]   payload length (uint16_t LE)
+ *       [2]     flags (bit 0 = keyframe)
+ *       [3-]    payload
+ *   - Keyframe payload is the raw 1024-byte frame. Delta payload is a
+ *     list of tokens [skip u8][len u8][len bytes], each XORed onto the
+ *     previous frame at (position + skip); skip-only tokens have len 0.
+ *   - Frame k * keyframe_interval is always a keyframe. The keyframe table
+ *     holds keyframe_count uint32_t LE record offsets (relative to
+ *     video_offset), so any frame is reachable from the keyframe before it.
+ * 
+ * IMA ADPCM audio (v3, audio_codec = 1):
+ *   - Audio region is a sequence of 512-byte (one sector) blocks:
+ *       [0-1]   left predictor (int16_t LE)
+ *       [2]     left step index
+ *       [3]     reserved
+ *       [4-7]   right predictor / step index / reserved
+ *       [8-511] 504 stereo samples, one byte each (low nibble = left)
+ *   - The header is the decoder state before the block's first sample,
+ *     so every block decodes on its own.
+ * 
+ * Interleaved layout (v3, layout = 1; raw video and PCM audio only):
+ *   - video_offset = audio_offset = start of chunk data. Chunk i holds
+ *     chunk_samples of PCM (zero padded past the end of the track)
+ *     followed by frames [F(i), F(i+1)), where
+ *     F(i) = min(ceil(i * chunk_samples * chunk_fps / sample_rate), frame_count).
+ *   - Chunk i starts at video_offset + i * chunk_samples * 4 + F(i) * 1024,
+ *     so no per-chunk headers are needed. With chunk_samples equal to the
+ *     audio refill size and MEDIA_CHUNK_STAGING set, playback reads the
+ *     file strictly sequentially: each refill reads one chunk's audio and
+ *     stages its frames.
+ * 
  * Usage:
  *   1. Find file with FAT_FindFile()
  *   2. Media_Open() with file info
  *   3. Media_ReadFrameAt() for video frames
- *   4. Media_ReadAudioStereo() for audio data
+ *   4. Media_ReadAudioStereo() (or Media_ReadAudioPacked()) for audio data
  *   5. Media_Close() when done
  */
 
@@ -34,19 +98,86 @@
 
 /* ========================== Configuration ========================== */
 
-#define MEDIA_HEADER_SIZE       20      // Header size in bytes
+#define MEDIA_HEADER_SIZE       20      // v2 header size in bytes
+#define MEDIA_V3_MAGIC          0x33564142  // "BAV3" read as uint32_t LE
+#define MEDIA_V3_HEADER_SIZE    512     // v3 header size (one sector)
+#define MEDIA_V3_MIN_HEADER     40      // Bytes of v3 header with defined fields
 #define MEDIA_FRAME_SIZE        1024    // Video frame size (128x64 / 8)
 #define MEDIA_DEFAULT_VOLUME    50      // Default volume percentage (0-100)
+#define MEDIA_DEFAULT_FPS       30      // Frame rate of v2 files and headers without one
+#define MEDIA_MAX_EXTENTS       64      // Cluster runs mapped at open time
+
+// PCM conversion kernel: 1 = Cortex-M4 DSP (one stereo pair per word),
+// 0 = portable C reference (same output, bit for bit)
+#ifndef MEDIA_PCM_SIMD
+#define MEDIA_PCM_SIMD          1
+#endif
+
+// Raw PCM refills read in batches of this many sectors (128 samples each),
+// converting each batch while the SD card transfers the next
+#ifndef MEDIA_PCM_BATCH_SECTORS
+#define MEDIA_PCM_BATCH_SECTORS 2
+#endif
+
+// Video codecs (v3 video_codec field)
+#define MEDIA_CODEC_RAW         0       // frame_count * 1024-byte frames
+#define MEDIA_CODEC_DELTA       1       // XOR/RLE delta records with keyframes
+
+// Delta records
+#define MEDIA_DELTA_RECORD_HEADER   3       // uint16 length + uint8 flags
+#define MEDIA_DELTA_FLAG_KEYFRAME   0x01    // Payload is a raw frame
+#define MEDIA_DELTA_WINDOW_SIZE     2048    // Read window (fits any record)
+#define MEDIA_NO_FRAME              0xFFFFFFFF
+
+// Audio codecs (v3 audio_codec field)
+#define MEDIA_AUDIO_PCM         0       // 16-bit stereo interleaved PCM
+#define MEDIA_AUDIO_ADPCM       1       // 4-bit IMA ADPCM, 512-byte blocks
+
+// IMA ADPCM blocks
+#define MEDIA_ADPCM_BLOCK_SIZE      512     // One SD sector
+#define MEDIA_ADPCM_BLOCK_HEADER    8       // Predictor + index per channel
+#define MEDIA_ADPCM_BLOCK_SAMPLES   (MEDIA_ADPCM_BLOCK_SIZE - MEDIA_ADPCM_BLOCK_HEADER)  // 504
+#define MEDIA_NO_BLOCK              0xFFFFFFFF
+
+// Layouts (v3 layout field)
+#define MEDIA_LAYOUT_SEPARATE   0       // Video region, then audio region
+#define MEDIA_LAYOUT_INTERLEAVED 1      // Sequential A/V chunks
+
+// Interleaved frame staging: 1 = each chunk's frames are read into a
+// staging slot right after its audio, so playback reads one forward stream
+// (MEDIA_CHUNK_SLOTS * MEDIA_CHUNK_MAX_FRAMES KB of RAM); 0 = interleaved
+// frames are read in place. Separate-layout files never use it.
+#ifndef MEDIA_CHUNK_STAGING
+#define MEDIA_CHUNK_STAGING     0
+#endif
+#define MEDIA_CHUNK_SLOTS       2       // Chunks staged (playing + next)
+#define MEDIA_CHUNK_MAX_FRAMES  4       // Frames per chunk staging slot
 
 /* ========================== Types ========================== */
 
+// One run of physically consecutive clusters
+typedef struct {
+    uint32_t file_cluster;      // Index of the run's first cluster within the file
+    uint32_t start_cluster;     // First cluster on disk
+    uint32_t length;            // Clusters in the run
+} Media_Extent;
+
+// IMA ADPCM decoder state for one channel
+typedef struct {
+    int32_t predictor;          // Last decoded sample
+    int32_t index;              // Step table index (0-88)
+} Media_AdpcmChannel;
+
 typedef struct {
     // File metadata (from header)
+    uint32_t format_version;    // 2 (legacy) or 3 (sector-aligned)
     uint32_t frame_count;       // Total video frames
     uint32_t audio_size;        // Audio data size in bytes
     uint32_t sample_rate;       // Audio sample rate (Hz)
     uint32_t channels;          // Audio channels (1 or 2)
     uint32_t bits_per_sample;   // Bits per sample (typically 16)
+    uint32_t audio_codec;       // MEDIA_AUDIO_PCM or MEDIA_AUDIO_ADPCM
+    uint32_t audio_samples;     // Stereo samples in the audio track
     
     // File location
     uint32_t first_cluster;     // Starting cluster on SD
@@ -57,22 +188,70 @@ typedef struct {
     uint32_t video_offset;      // Byte offset to video data
     uint32_t audio_offset;      // Byte offset to audio data
     
+    // Video codec (v3 header; v2 and older v3 files are always raw)
+    uint32_t video_codec;       // MEDIA_CODEC_RAW or MEDIA_CODEC_DELTA
+    uint32_t video_size;        // Video region size in bytes
+    uint32_t keyframe_interval; // Frames between keyframes (delta)
+    uint32_t keyframe_count;    // Entries in keyframe table (delta)
+    uint32_t keyframe_table_offset;  // File offset of keyframe table (delta)
+    
+    // Delta decoder state (reference frame lives in the reader)
+    uint32_t delta_ref_frame;   // Frame held in the reference (MEDIA_NO_FRAME = none)
+    uint32_t delta_next_offset; // File offset of the record after delta_ref_frame
+    uint32_t delta_window_offset;   // File offset of read window start
+    uint32_t delta_window_len;      // Valid bytes in read window
+    uint32_t delta_records;     // Records decoded
+    uint32_t delta_seeks;       // Jumps back to a keyframe
+    
+    // ADPCM decoder state (partially consumed block is held by the reader)
+    Media_AdpcmChannel adpcm[2];    // Left, right
+    uint32_t adpcm_block;       // Block held (MEDIA_NO_BLOCK = none)
+    uint32_t adpcm_pos;         // Next sample within adpcm_block
+    
+    // Interleaved layout
+    uint32_t layout;            // MEDIA_LAYOUT_SEPARATE or MEDIA_LAYOUT_INTERLEAVED
+    uint32_t chunk_samples;     // Audio samples per chunk
+    uint32_t chunk_fps;         // Frame rate used to assign frames to chunks
+#if MEDIA_CHUNK_STAGING
+    uint32_t staged_chunk[MEDIA_CHUNK_SLOTS];  // Chunk held per slot (MEDIA_NO_BLOCK = none)
+#endif
+    uint32_t staged_hits;       // Frames served from staging
+    uint32_t staged_misses;     // Frames read in place (seek or late render)
+    
+    // Frame rate (fps_num / fps_den frames per second)
+    uint32_t fps_num;
+    uint32_t fps_den;
+    
     // Playback position
     uint32_t current_frame;     // Current video frame index
     uint32_t current_sample;    // Current audio sample index
     
     // Playback settings
     uint8_t volume_percent;     // Volume 0-100
+    int32_t gain_q16;           // volume_percent in Q16 (65536 = 100%)
+    
+    // PCM conversion cost (DWT, Media_ConvertPcm() only)
+    uint64_t convert_cycles;    // Cycles spent converting
+    uint32_t convert_samples;   // Stereo samples converted
     
     // State
     bool is_open;               // File successfully opened
     
-    // Cluster cache for sequential reads
+    // Cluster cache for sequential reads (chain-walk fallback only)
     uint32_t cached_cluster;        // Last accessed cluster
     uint32_t cached_cluster_index;  // Index of cached cluster
     
+    // Extent map (built once at open; empty if the file has too many runs)
+    Media_Extent extents[MEDIA_MAX_EXTENTS];
+    uint32_t extent_count;      // Valid entries in extents[] (0 = use chain walk)
+    bool extent_overflow;       // File has more than MEDIA_MAX_EXTENTS runs
+    
+    // Open-time FAT scan measurement (DWT)
+    uint32_t scan_time_us;      // Time spent mapping the cluster chain
+    uint32_t scan_fat_sectors;  // FAT sectors read while mapping
+    
     // Contiguous file optimization
-    bool is_contiguous;         // File clusters are sequential
+    bool is_contiguous;         // File clusters are sequential (one extent)
     uint32_t first_sector;      // First sector (if contiguous)
 } MediaFile;
 
@@ -85,8 +264,12 @@ typedef struct {
  * @param file_info File info from FAT_FindFile()
  * @return FAT_OK on success
  * 
- * Reads file header, calculates offsets, optionally enables
- * contiguous fast-path if file is not fragmented.
+ * Reads file header (v2 or v3), calculates offsets, and maps the cluster
+ * chain into an extent table with one bulk FAT scan (timed into
+ * scan_time_us). Reads then look up the extent for an offset
+ * by binary search and stream multi-block reads within it, so fragmented
+ * files only pay a seek at each extent boundary. Files with more than
+ * MEDIA_MAX_EXTENTS runs fall back to walking the chain.
  */
 FAT_Status Media_Open(MediaFile *media, FAT_Volume *vol, const FAT_FileInfo *file_info);
 
@@ -111,9 +294,31 @@ void Media_SetVolume(MediaFile *media, uint8_t percent);
  * @param frame_number Frame index (0-based)
  * @param buffer       Destination buffer (must be MEDIA_FRAME_SIZE bytes)
  * @return FAT_OK on success
+ * 
+ * For delta video the frame is rebuilt in a private reference frame and
+ * copied to buffer. Forward reads (including A/V sync skips) apply the
+ * intervening deltas; backward reads, or forward jumps past the next
+ * keyframe, restart from the nearest keyframe at or before frame_number.
  */
 FAT_Status Media_ReadFrameAt(MediaFile *media, uint32_t frame_number, uint8_t *buffer);
 
+/**
+ * @brief Read part of a video frame (for preemptible I/O)
+ * @param media        Handle
+ * @param frame_number Frame index (0-based)
+ * @param buffer       Whole-frame destination (MEDIA_FRAME_SIZE bytes)
+ * @param offset       Byte offset within the frame to continue from
+ * @param max_bytes    Most bytes to read in this call
+ * @param bytes_read   Set to bytes now present at buffer + offset
+ * @return FAT_OK on success
+ * 
+ * Raw frames are read in place, max_bytes at a time. Delta frames and
+ * frames already staged from an interleaved chunk have no on-card span to
+ * split, so the first call (offset 0) produces the whole frame.
+ */
+FAT_Status Media_ReadFramePart(MediaFile *media, uint32_t frame_number, uint8_t *buffer,
+                               uint32_t offset, uint32_t max_bytes, uint32_t *bytes_read);
+
 /* ========================== Audio API ========================== */
 
 /**
@@ -121,16 +326,34 @@ FAT_Status Media_ReadFrameAt(MediaFile *media, uint32_t frame_number, uint8_t *b
  * @param media Handle
  * @param left  Left channel buffer (12-bit unsigned for DAC)
  * @param right Right channel buffer (12-bit unsigned for DAC)
- * @param count Number of samples to read (max AUDIO_BUFFER_SAMPLES)
+ * @param count Number of samples to read (max AUDIO_SEGMENT_SAMPLES)
  * @return FAT_OK on success
  * 
  * Reads interleaved 16-bit signed PCM, converts to 12-bit unsigned,
  * applies volume scaling, and deinterleaves to separate L/R buffers.
+ * In the interleaved layout, completing a chunk's audio also stages that
+ * chunk's frames (they follow the audio on the card) for Media_ReadFrameAt().
+ * 
+ * IMA ADPCM tracks are read as whole blocks (one multi-block read per
+ * call, a quarter of the PCM traffic) and decoded straight into the
+ * 12-bit buffers.
  * 
  * If end of audio is reached, remaining samples are filled with silence.
  */
 FAT_Status Media_ReadAudioStereo(MediaFile *media, uint16_t *left, uint16_t *right, uint32_t count);
 
+/**
+ * @brief Read audio samples as packed dual-channel DAC words
+ * @param media  Handle
+ * @param packed Output words, left in bits 0-11 and right in bits 16-27
+ * @param count  Number of stereo samples to read
+ * @return FAT_OK on success
+ * 
+ * Same conversion as Media_ReadAudioStereo(), written as one interleaved
+ * buffer that a single DMA channel feeds to the DAC's DHR12RD register.
+ */
+FAT_Status Media_ReadAudioPacked(MediaFile *media, uint32_t *packed, uint32_t count);
+
 /* ========================== Query API ========================== */
 
 /**
@@ -142,25 +365,70 @@ static inline bool Media_IsContiguous(const MediaFile *media) {
     return media && media->is_contiguous;
 }
 
+/**
+ * @brief Check if video uses the delta codec
+ * @param media Handle
+ * @return true if frames are XOR/RLE delta records
+ */
+static inline bool Media_IsDeltaVideo(const MediaFile *media) {
+    return media && media->video_codec == MEDIA_CODEC_DELTA;
+}
+
+/**
+ * @brief Get number of mapped extents
+ * @param media Handle
+ * @return Extent count (1 if contiguous, 0 if the chain-walk fallback is in use)
+ */
+static inline uint32_t Media_GetExtentCount(const MediaFile *media) {
+    return media ? media->extent_count : 0;
+}
+
 /**
  * @brief Get total duration in seconds
  * @param media Handle
- * @param fps   Frames per second
- * @return Duration in seconds
+ * @return Duration in seconds at the header frame rate
+ */
+static inline uint32_t Media_GetDurationSeconds(const MediaFile *media) {
+    if (!media || media->fps_num == 0) return 0;
+    return (uint32_t)(((uint64_t)media->frame_count * media->fps_den) / media->fps_num);
+}
+
+/**
+ * @brief Get the PCM conversion cost
+ * @param media Handle
+ * @return Cycles per stereo sample x 10 (0 before any PCM has been converted)
  */
-static inline uint32_t Media_GetDurationSeconds(const MediaFile *media, uint32_t fps) {
-    if (!media || fps == 0) return 0;
-    return media->frame_count / fps;
+static inline uint32_t Media_GetConvertCost(const MediaFile *media) {
+    if (!media || media->convert_samples == 0) return 0;
+    return (uint32_t)(media->convert_cycles * 10 / media->convert_samples);
 }
 
 /**
  * @brief Get audio sample count
  * @param media Handle
- * @return Total stereo samples (audio_size / 4 for 16-bit stereo)
+ * @return Total stereo samples (audio_size / 4 for 16-bit PCM)
  */
 static inline uint32_t Media_GetSampleCount(const MediaFile *media) {
     if (!media) return 0;
-    return media->audio_size / 4;  // 4 bytes per stereo sample
+    return media->audio_samples;
+}
+
+/**
+ * @brief Check if the file uses the interleaved chunk layout
+ * @param media Handle
+ * @return true if audio and video are interleaved
+ */
+static inline bool Media_IsInterleaved(const MediaFile *media) {
+    return media && media->layout == MEDIA_LAYOUT_INTERLEAVED;
+}
+
+/**
+ * @brief Check if audio uses IMA ADPCM
+ * @param media Handle
+ * @return true if the audio track is IMA ADPCM
+ */
+static inline bool Media_IsAdpcmAudio(const MediaFile *media) {
+    return media && media->audio_codec == MEDIA_AUDIO_ADPCM;
 }
 
 #endif // MEDIA_FILE_READER_H
@@ -0,0 +1,133 @@
+/**
+ * @file    osd.h
+ * @brief   Live on-screen overlay composited into video frames
+ * @author  David Leathers
+ * @date    November 2025
+ * 
+ * Shows playback status over the video while it plays:
+ *   - Top page:    elapsed time, A/V drift (frames), last refill slack (ms)
+ *   - Bottom page: progress bar
+ * 
+ * The overlay is kept in two layers in display RAM layout: bits (pixels
+ * drawn) and mask (pixels the overlay owns). Text fields own a black box
+ * so they stay readable on white video. A field is re-rendered into the
+ * layers only when its value changes, and the progress bar only over the
+ * columns it grew by, so glyphs are drawn about once a second rather than
+ * once a frame. Each frame then costs one mask merge per overlay page,
+ * over the columns the overlay covers on that page:
+ * 
+ *   frame = (frame & ~mask) | bits
+ * 
+ * With partial display updates, an overlay that did not change on video
+ * that did not change sends nothing to the panel.
+ * 
+ * Usage:
+ *   1. OSD_Init() after the media file, audio driver and A/V sync
+ *   2. OSD_Toggle() or OSD_SetEnabled() (e.g. from the user button)
+ *   3. OSD_Compose() on each frame once it is read, before it is published
+ */
+
+#ifndef OSD_H
+#define OSD_H
+
+#include "ssd1306.h"
+#include "audio_dac.h"
+#include "av_sync.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ========================== Configuration ========================== */
+
+// Pages holding the text fields and the progress bar
+#define OSD_TEXT_PAGE       0
+#define OSD_BAR_PAGE        (SSD1306_PAGES - 1)
+
+// Progress bar rows within its page (bit 0 = top row): owned rows, the
+// filled bar, and the track shown past the fill
+#define OSD_BAR_MASK        0xF8
+#define OSD_BAR_FILL        0x70
+#define OSD_BAR_TRACK       0x40
+
+/* ========================== Types ========================== */
+
+typedef enum {
+    OSD_FIELD_TIME = 0,         // Elapsed time of the frame (mm:ss)
+    OSD_FIELD_DRIFT,            // AVSync_GetCurrentDrift() (frames)
+    OSD_FIELD_SLACK,            // Slack of the last audio refill (ms)
+    OSD_FIELD_COUNT
+} OSD_FieldId;
+
+// Text field on OSD_TEXT_PAGE
+typedef struct {
+    uint8_t x;                  // Left column of the field's box
+    uint8_t chars;              // Box width in characters
+    int32_t value;              // Value rendered in the layers
+    bool drawn;                 // value is valid
+} OSD_Field;
+
+typedef struct {
+    // Data sources (not owned)
+    AVSync_Handle *sync;
+    Audio_Handle *audio;
+    uint32_t frame_count;
+    
+    // Overlay layers (display RAM layout)
+    uint8_t bits[SSD1306_BUFFER_SIZE] __attribute__((aligned(4)));
+    uint8_t mask[SSD1306_BUFFER_SIZE] __attribute__((aligned(4)));
+    
+    // Word span the mask covers on each page (start > end = page unused)
+    uint8_t span_start[SSD1306_PAGES];
+    uint8_t span_end[SSD1306_PAGES];
+    
+    // Rendered state
+    OSD_Field fields[OSD_FIELD_COUNT];
+    uint32_t bar_fill;          // Progress bar columns filled
+    
+    // Statistics
+    uint32_t redraws;           // Fields re-rendered into the layers
+    
+    bool enabled;
+    
+    // Init flag
+    bool initialized;
+} OSD_Handle;
+
+/* ========================== API ========================== */
+
+/**
+ * @brief Initialize the overlay (starts disabled)
+ * @param osd         Handle to initialize
+ * @param sync        A/V sync (frame times and drift)
+ * @param audio       Audio driver (refill slack)
+ * @param frame_count Frames in the video (progress bar scale)
+ */
+void OSD_Init(OSD_Handle *osd, AVSync_Handle *sync, Audio_Handle *audio, uint32_t frame_count);
+
+/**
+ * @brief Show or hide the overlay
+ */
+void OSD_SetEnabled(OSD_Handle *osd, bool enabled);
+
+/**
+ * @brief Flip the overlay on or off
+ */
+void OSD_Toggle(OSD_Handle *osd);
+
+/**
+ * @brief Draw the overlay into a frame (no-op while disabled)
+ * @param osd    Handle
+ * @param frame  Frame index (elapsed time and progress)
+ * @param buffer Frame in display RAM layout (word-aligned)
+ * 
+ * Re-renders the fields whose values changed, then merges the layers.
+ */
+void OSD_Compose(OSD_Handle *osd, uint32_t frame, uint8_t *buffer);
+
+/**
+ * @brief Check whether the overlay is shown
+ */
+static inline bool OSD_IsEnabled(const OSD_Handle *osd) {
+    return osd ? osd->enabled : false;
+}
+
+#endif // OSD_H
@@ -8,6 +8,8 @@
  *   - SPI mode initialization (CMD0, CMD8, ACMD41, etc.)
  *   - Single and multi-block reads
  *   - DMA transfers for block data (frees CPU for audio interrupts)
+ *   - Non-blocking reads driven by a DMA-completion state machine
+ *   - Open-ended CMD18 streaming for sequential reads
  *   - SDHC/SDXC support (block addressing)
  * 
  * Hardware Requirements:
@@ -23,6 +25,22 @@
  * 
  * Note: This driver uses DMA for data transfers. Call SD_DMA_RxComplete()
  * from HAL_SPI_TxRxCpltCallback() to signal transfer completion.
+ * 
+ * Asynchronous Reads:
+ *   SD_ReadBlocksAsync() issues the read command and polls briefly for the
+ *   first data token. Each block then moves by DMA; SD_DMA_RxComplete() only
+ *   marks it received. Every phase that clocks bytes by polling (block CRC,
+ *   the next data token, CMD12 and its busy period) is a bounded step of
+ *   SD_AsyncPoll(), which the caller interleaves with other work, so no
+ *   polled SPI traffic runs in interrupt context. The blocking SD_ReadBlock()
+ *   / SD_ReadMultipleBlocks() are thin wrappers that submit a request and
+ *   poll it to completion.
+ * 
+ * Streaming Reads:
+ *   SD_StreamOpen() sends one CMD18 and keeps the card in multi-block read
+ *   mode (CS held low) across any number of SD_StreamRead() calls, so
+ *   sequential reads pay no per-call command, CMD12 or busy-wait overhead.
+ *   Any other read (or SD_StreamClose()) ends the stream with CMD12.
  */
 
 #ifndef SD_CARD_H
@@ -61,7 +79,9 @@ typedef enum {
     SD_OK = 0,
     SD_ERROR,
     SD_ERROR_TIMEOUT,
-    SD_ERROR_NO_CARD
+    SD_ERROR_NO_CARD,
+    SD_ERROR_BUSY,
+    SD_ERROR_READ       // Card sent a data error token
 } SD_Status;
 
 typedef enum {
@@ -79,7 +99,36 @@ typedef struct {
     uint8_t csd[16];        // Card Specific Data register
 } SD_CardInfo;
 
+typedef enum {
+    SD_ASYNC_IDLE = 0,      // No request submitted
+    SD_ASYNC_WAIT_TOKEN,    // Waiting for data start token (polled)
+    SD_ASYNC_DATA,          // Block DMA in flight
+    SD_ASYNC_BLOCK_DONE,    // Block DMA finished, CRC and next step pending (polled)
+    SD_ASYNC_STOPPING,      // Blocks received, CMD12 pending (polled)
+    SD_ASYNC_STOP_BUSY,     // CMD12 sent, card busy (polled)
+    SD_ASYNC_DONE,          // Request finished successfully
+    SD_ASYNC_ERROR          // Request failed (see async_status)
+} SD_AsyncState;
+
+// Bus statistics (for command-rate benchmarking)
 typedef struct {
+    uint32_t commands;      // Commands sent to the card
+    uint32_t blocks_read;   // 512-byte blocks received
+    uint32_t stream_opens;  // CMD18 streams started (one per seek)
+} SD_Stats;
+
+struct SD_Handle;
+
+/**
+ * @brief Async read completion callback
+ * @param hsd     Handle that finished the request
+ * @param status  SD_OK on success, error code otherwise
+ * @param context User pointer passed to SD_ReadBlocksAsync()
+ * @note  Runs from SD_AsyncPoll() or the submitting call, never from an interrupt
+ */
+typedef void (*SD_AsyncCallback)(struct SD_Handle *hsd, SD_Status status, void *context);
+
+typedef struct SD_Handle {
     // HAL handles (not owned)
     SPI_HandleTypeDef *hspi;
     
@@ -94,6 +143,23 @@ typedef struct {
     volatile bool dma_busy;
     volatile bool dma_error;
     
+    // Async request state (advanced by SD_DMA_RxComplete / SD_AsyncPoll)
+    volatile SD_AsyncState async_state;
+    volatile SD_Status async_status;    // Result (or first error) of request
+    uint8_t *async_buffer;              // Destination of next block
+    volatile uint32_t async_remaining;  // Blocks still to receive
+    bool async_multi;                   // CMD18 request (needs CMD12)
+    uint32_t async_phase_start;         // Cycle count at start of phase
+    SD_AsyncCallback async_callback;    // Optional completion callback
+    void *async_context;                // Callback user pointer
+    
+    // Streaming session (open-ended CMD18)
+    bool stream_open;                   // CMD18 active, CS held low
+    uint32_t stream_next_block;         // Block the stream delivers next
+    
+    // Statistics
+    SD_Stats stats;
+    
     // Init flag
     bool initialized;
 } SD_Handle;
@@ -133,12 +199,124 @@ SD_Status SD_ReadBlock(SD_Handle *hsd, uint8_t *buffer, uint32_t block);
 SD_Status SD_ReadMultipleBlocks(SD_Handle *hsd, uint8_t *buffer,
                                  uint32_t start_block, uint32_t count);
 
+/* ========================== Async API ========================== */
+
+/**
+ * @brief Start a non-blocking read of consecutive blocks
+ * @param hsd         Handle
+ * @param buffer      Destination buffer (must stay valid until completion)
+ * @param start_block Starting block number (LBA)
+ * @param count       Number of blocks to read
+ * @param callback    Completion callback (NULL to poll SD_AsyncPoll() only)
+ * @param context     User pointer passed to callback
+ * @return SD_OK if the request was submitted, SD_ERROR_BUSY if another
+ *         request is in flight, error code if the command was rejected
+ * 
+ * Uses CMD17 for one block and CMD18 + CMD12 for several.
+ */
+SD_Status SD_ReadBlocksAsync(SD_Handle *hsd, uint8_t *buffer,
+                             uint32_t start_block, uint32_t count,
+                             SD_AsyncCallback callback, void *context);
+
+/**
+ * @brief Advance polled phases of the current async request
+ * @param hsd Handle
+ * @return Current request state
+ * 
+ * Non-blocking: each call runs one bounded step (block CRC, at most a few
+ * token or busy polls, CMD12) and checks DMA timeouts. Call regularly from the main loop while
+ * SD_IsBusy() is true.
+ */
+SD_AsyncState SD_AsyncPoll(SD_Handle *hsd);
+
+/**
+ * @brief Block until the current async request finishes
+ * @param hsd Handle
+ * @return Status of the finished request (SD_OK if nothing was pending)
+ * @note  Returns the handle to SD_ASYNC_IDLE
+ */
+SD_Status SD_AsyncWait(SD_Handle *hsd);
+
+/**
+ * @brief Check whether an async request is in flight
+ * @param hsd Handle
+ * @return true while the card is busy with a submitted request
+ */
+static inline bool SD_IsBusy(const SD_Handle *hsd) {
+    if (!hsd) return false;
+    SD_AsyncState state = hsd->async_state;
+    return state == SD_ASYNC_WAIT_TOKEN || state == SD_ASYNC_DATA ||
+           state == SD_ASYNC_BLOCK_DONE || state == SD_ASYNC_STOPPING ||
+           state == SD_ASYNC_STOP_BUSY;
+}
+
+/* ========================== Streaming API ========================== */
+
+/**
+ * @brief Start (or continue) a multi-block read stream
+ * @param hsd         Handle
+ * @param start_block Block the stream should deliver next
+ * @return SD_OK on success
+ * 
+ * No-op if a stream is already open at start_block. An open stream at a
+ * different position is closed first (seek).
+ */
+SD_Status SD_StreamOpen(SD_Handle *hsd, uint32_t start_block);
+
+/**
+ * @brief Read the next blocks from the open stream (blocking)
+ * @param hsd    Handle
+ * @param buffer Destination buffer (must be at least count*512 bytes)
+ * @param count  Number of blocks to read
+ * @return SD_OK on success. On error the stream is closed.
+ */
+SD_Status SD_StreamRead(SD_Handle *hsd, uint8_t *buffer, uint32_t count);
+
+/**
+ * @brief Read the next blocks from the open stream (non-blocking)
+ * @param hsd      Handle
+ * @param buffer   Destination buffer (must stay valid until completion)
+ * @param count    Number of blocks to read
+ * @param callback Completion callback (may be NULL)
+ * @param context  User pointer passed to callback
+ * @return SD_OK if submitted
+ */
+SD_Status SD_StreamReadAsync(SD_Handle *hsd, uint8_t *buffer, uint32_t count,
+                             SD_AsyncCallback callback, void *context);
+
+/**
+ * @brief Stop the stream (CMD12) and release the card
+ * @param hsd Handle
+ * @return SD_OK on success (also when no stream was open)
+ */
+SD_Status SD_StreamClose(SD_Handle *hsd);
+
+/**
+ * @brief Check if a stream is open at the given block
+ * @param hsd   Handle
+ * @param block Block number (LBA)
+ * @return true if the next SD_StreamRead() would deliver this block
+ */
+static inline bool SD_StreamIsAt(const SD_Handle *hsd, uint32_t block) {
+    return hsd && hsd->stream_open && hsd->stream_next_block == block;
+}
+
+/**
+ * @brief Get bus statistics
+ * @param hsd Handle
+ * @return Pointer to stats (valid while handle exists)
+ */
+static inline const SD_Stats* SD_GetStats(const SD_Handle *hsd) {
+    return hsd ? &hsd->stats : NULL;
+}
+
 /* ========================== DMA Callback ========================== */
 
 /**
  * @brief Signal DMA transfer complete
  * @param hsd Handle
- * @note  Call this from HAL_SPI_TxRxCpltCallback() when hspi matches
+ * @note  Call this from HAL_SPI_TxRxCpltCallback() when hspi matches.
+ *        Only marks the block received; SD_AsyncPoll() does the rest.
  */
 void SD_DMA_RxComplete(SD_Handle *hsd);
 
@@ -7,20 +7,23 @@
  * Features:
  *   - 128x64 monochrome OLED via I2C
  *   - DMA transfers for video playback (non-blocking)
+ *   - Partial updates: only the columns that differ from the panel are sent
  *   - Polling transfers for init/debug (blocking)
  *   - 5x7 font for text/stats display
- *   - Integration with triple-buffer system
+ *   - Integration with the frame queue in buffers.h
  * 
  * Hardware:
  *   - I2C address: 0x3C (7-bit) / 0x78 (8-bit with R/W)
- *   - Typical I2C speed: 400kHz (Fast Mode)
+ *   - I2C speed: 1MHz Fast-mode Plus (a full frame in ~9ms), or 400kHz Fast Mode
  *   - DMA channel required for non-blocking updates
  * 
  * Usage (Playback):
- *   1. SSD1306_Init() with triple buffer from Display_GetRenderBuffer()
- *   2. In main loop: render to buffer, call Display_SwapBuffers()
- *   3. When Display_HasFrame(): call SSD1306_UpdateScreen_DMA()
- *   4. DMA callbacks update triple-buffer state automatically
+ *   1. SSD1306_Init()
+ *   2. In main loop: render to FrameQueue_AcquireRender(), then
+ *      FrameQueue_Publish()
+ *   3. When FrameQueue_Consume() has a frame: call SSD1306_UpdateScreen_DMA()
+ *   4. DMA callbacks chain the frame's transfers and release it after the last
+ *   5. Optionally SSD1306_SetTransferHook() to timestamp each completed frame
  * 
  * Usage (Debug/Stats):
  *   1. SSD1306_SetCursor() to position
@@ -50,6 +53,22 @@
 // Chunked transfer size for polling mode
 #define SSD1306_CHUNK_SIZE  128     // Bytes per I2C transaction
 
+// Display RAM pages (8 pixel rows each)
+#define SSD1306_PAGES       (SSD1306_HEIGHT / 8)
+
+// Partial updates: diff each DMA frame against the panel contents and send
+// only the changed column span of each page (0 = always send all 1024 bytes)
+#ifndef SSD1306_PARTIAL_UPDATES
+#define SSD1306_PARTIAL_UPDATES     1
+#endif
+
+// COLUMNADDR/PAGEADDR command stream for one window
+#define SSD1306_ADDR_CMD_BYTES      6
+
+// Bus bytes a window costs beyond its data: the command transfer (address,
+// control, six commands) and the data transfer's address and control
+#define SSD1306_WINDOW_SETUP_BYTES  (SSD1306_ADDR_CMD_BYTES + 4)
+
 /* ========================== Types ========================== */
 
 typedef enum {
@@ -64,6 +83,12 @@ typedef enum {
     SSD1306_COLOR_WHITE = 1
 } SSD1306_Color;
 
+// How text treats the pixels around each glyph
+typedef enum {
+    SSD1306_TEXT_OPAQUE = 0,        // Glyph box overwritten (background cleared)
+    SSD1306_TEXT_TRANSPARENT        // Only glyph pixels drawn (for overlays)
+} SSD1306_TextMode;
+
 // Font descriptor
 typedef struct {
     uint8_t width;          // Glyph width in pixels
@@ -71,6 +96,28 @@ typedef struct {
     const uint8_t *data;    // Font bitmap data (column-major)
 } SSD1306_Font;
 
+// Called from the I2C DMA ISR when a frame transfer completes
+typedef void (*SSD1306_TransferHook)(void *ctx);
+
+// Display RAM region sent as one transfer (inclusive bounds). The source
+// bytes are contiguous in the frame: one page, or full-width pages.
+typedef struct {
+    uint8_t page_start;
+    uint8_t page_end;
+    uint8_t col_start;
+    uint8_t col_end;
+} SSD1306_Window;
+
+// DMA update statistics
+typedef struct {
+    uint32_t frames;            // Frames sent to the panel
+    uint32_t full_frames;       // Frames sent whole (no shadow, or diff too large)
+    uint32_t unchanged_frames;  // Frames identical to the panel (nothing sent)
+    uint32_t windows;           // Windows transferred
+    uint32_t wire_bytes;        // Bus bytes: window data plus SSD1306_WINDOW_SETUP_BYTES each
+    uint64_t bus_cycles;        // DWT cycles with a window on the bus (commands to data complete)
+} SSD1306_Stats;
+
 // Driver handle
 typedef struct {
     // HAL handle (not owned)
@@ -82,10 +129,31 @@ typedef struct {
     // Text cursor position
     uint8_t cursor_x;
     uint8_t cursor_y;
+    SSD1306_TextMode text_mode;
     
     // DMA state
     volatile bool dma_busy;
     
+    // Transfer-complete hook (optional)
+    SSD1306_TransferHook transfer_hook;
+    void *transfer_hook_ctx;
+    
+    // Panel contents as last sent (partial updates diff against this)
+    uint8_t shadow[SSD1306_BUFFER_SIZE] __attribute__((aligned(4)));
+    bool shadow_valid;
+    
+    // Frame in flight: its windows and the one on the bus
+    uint8_t *tx_frame;
+    SSD1306_Window windows[SSD1306_PAGES];
+    volatile uint8_t window_count;
+    volatile uint8_t window_next;
+    volatile bool data_phase;   // Window data on the bus (else its address commands)
+    uint8_t cmd_buffer[SSD1306_ADDR_CMD_BYTES];     // DMA source for the command phase
+    uint32_t window_started;    // DWT cycles at the current window's command phase
+    
+    // Statistics
+    SSD1306_Stats stats;
+    
     // Chunk buffer for polling mode transfers
     uint8_t chunk_buffer[SSD1306_CHUNK_SIZE + 1];
     
@@ -145,6 +213,13 @@ SSD1306_Status SSD1306_SetContrast(SSD1306_Handle *hdisplay, uint8_t contrast);
  */
 void SSD1306_SetCursor(SSD1306_Handle *hdisplay, uint8_t x, uint8_t y);
 
+/**
+ * @brief Set how text is drawn over existing pixels
+ * @param hdisplay Handle
+ * @param mode     SSD1306_TEXT_OPAQUE (default) or SSD1306_TEXT_TRANSPARENT
+ */
+void SSD1306_SetTextMode(SSD1306_Handle *hdisplay, SSD1306_TextMode mode);
+
 /**
  * @brief Write string to framebuffer
  * @param hdisplay Handle
@@ -154,10 +229,43 @@ void SSD1306_SetCursor(SSD1306_Handle *hdisplay, uint8_t x, uint8_t y);
  * 
  * Draws text at current cursor position, advances cursor.
  * Wraps to next line when reaching right edge.
+ * Glyphs are written a byte per column: one byte when the cursor is on a
+ * page boundary (y a multiple of 8), two otherwise.
  */
 void SSD1306_WriteString(SSD1306_Handle *hdisplay, const char *str, 
                           const SSD1306_Font *font, SSD1306_Color color);
 
+/**
+ * @brief Draw a line of text into any buffer in display RAM layout
+ * @param buffer Destination (SSD1306_BUFFER_SIZE bytes, page-major like the framebuffer)
+ * @param x      Left column of the first glyph
+ * @param y      Top row of the glyphs
+ * @param str    Null-terminated string
+ * @param font   Font to use
+ * @param color  SSD1306_COLOR_WHITE or SSD1306_COLOR_BLACK
+ * @param mode   SSD1306_TEXT_OPAQUE or SSD1306_TEXT_TRANSPARENT
+ * @return Column after the last glyph drawn
+ * 
+ * Same glyph blitter as SSD1306_WriteString(), without the handle's
+ * cursor or line wrap (text past the right edge is dropped). For drawing
+ * into frames or overlay layers other than the handle's framebuffer.
+ */
+uint32_t SSD1306_DrawText(uint8_t *buffer, uint32_t x, uint32_t y, const char *str,
+                          const SSD1306_Font *font, SSD1306_Color color,
+                          SSD1306_TextMode mode);
+
+/**
+ * @brief Set or clear one pixel of a buffer in display RAM layout
+ * @param buffer Destination (SSD1306_BUFFER_SIZE bytes, page-major like the framebuffer)
+ * @param x      Column
+ * @param y      Row
+ * @param color  SSD1306_COLOR_WHITE or SSD1306_COLOR_BLACK
+ * 
+ * Pixels off the display are ignored. One read-modify-write per pixel;
+ * text goes through the glyph blitter instead.
+ */
+void SSD1306_DrawPixel(uint8_t *buffer, uint32_t x, uint32_t y, SSD1306_Color color);
+
 /* ========================== Screen Update (Polling) ========================== */
 
 /**
@@ -166,7 +274,7 @@ void SSD1306_WriteString(SSD1306_Handle *hdisplay, const char *str,
  * @return SSD1306_OK on success
  * 
  * Transfers entire 1024-byte framebuffer via I2C polling.
- * Blocks until complete (~20ms at 400kHz I2C).
+ * Blocks until complete (~10ms at 1MHz, ~23ms at 400kHz I2C).
  * Use for init, debug, or when DMA unavailable.
  */
 SSD1306_Status SSD1306_UpdateScreen(SSD1306_Handle *hdisplay);
@@ -178,11 +286,22 @@ SSD1306_Status SSD1306_UpdateScreen(SSD1306_Handle *hdisplay);
  * @param hdisplay Handle
  * @return SSD1306_OK if transfer started, SSD1306_ERROR_BUSY if DMA in progress
  * 
- * Uses triple-buffer system from buffers.h:
- *   - Calls Display_StartTransfer() to get ready buffer
+ * Uses the frame queue from buffers.h:
+ *   - Sends the oldest queued frame (FrameQueue_Consume())
  *   - Starts I2C DMA transfer
  *   - Returns immediately
  * 
+ * With SSD1306_PARTIAL_UPDATES the frame is compared with the shadow of
+ * the panel, and each page's changed column span becomes a window with
+ * its own COLUMNADDR/PAGEADDR setup. The whole frame is sent as one
+ * window instead when that costs fewer bus bytes. A frame identical to
+ * the panel is released at once (the transfer hook still runs).
+ * 
+ * Each window is two DMA transfers, its address command stream and then
+ * its data. The completion callback starts each next transfer, so the
+ * call returns once the first is started and the main loop never waits
+ * on the bus. The frame is released after the last window.
+ * 
  * Caller must configure HAL_I2C_MemTxCpltCallback() to call
  * SSD1306_DMA_CompleteCallback(), and HAL_I2C_ErrorCallback()
  * to call SSD1306_DMA_ErrorCallback().
@@ -196,6 +315,22 @@ SSD1306_Status SSD1306_UpdateScreen_DMA(SSD1306_Handle *hdisplay);
  */
 bool SSD1306_IsDMABusy(SSD1306_Handle *hdisplay);
 
+/**
+ * @brief Get DMA update statistics
+ */
+static inline const SSD1306_Stats* SSD1306_GetStats(const SSD1306_Handle *hdisplay) {
+    return hdisplay ? &hdisplay->stats : NULL;
+}
+
+/**
+ * @brief Set hook called when a DMA frame transfer completes
+ * @param hdisplay Handle
+ * @param hook     Function called from ISR context (NULL to clear)
+ * @param ctx      Passed to hook
+ * @note  Set after SSD1306_Init() (init clears the handle)
+ */
+void SSD1306_SetTransferHook(SSD1306_Handle *hdisplay, SSD1306_TransferHook hook, void *ctx);
+
 /**
  * @brief DMA transfer complete callback
  * @param hdisplay Handle
@@ -15,8 +15,21 @@
 static Audio_Handle *s_audio_handle = NULL;
 
 // DMA buffers - 32-byte aligned for optimal DMA performance
-static uint16_t s_dma_buffer_left[AUDIO_FULL_BUFFER_SAMPLES] __attribute__((aligned(32)));
-static uint16_t s_dma_buffer_right[AUDIO_FULL_BUFFER_SAMPLES] __attribute__((aligned(32)));
+#if AUDIO_DAC_PACKED
+static uint32_t s_dma_buffer_packed[AUDIO_RING_SAMPLES] __attribute__((aligned(32)));
+
+_Static_assert(sizeof(s_dma_buffer_packed) == AUDIO_RING_BYTES,
+               "AUDIO_RING_BYTES does not match the packed ring");
+#else
+static uint16_t s_dma_buffer_left[AUDIO_RING_SAMPLES] __attribute__((aligned(32)));
+static uint16_t s_dma_buffer_right[AUDIO_RING_SAMPLES] __attribute__((aligned(32)));
+
+_Static_assert(sizeof(s_dma_buffer_left) + sizeof(s_dma_buffer_right) == AUDIO_RING_BYTES,
+               "AUDIO_RING_BYTES does not match the split rings");
+#endif
+
+_Static_assert(AUDIO_RING_BYTES <= AUDIO_RING_RAM_BUDGET,
+               "Audio ring exceeds its SRAM1 budget (see buffers.h)");
 
 /* ========================== Private Functions ========================== */
 
@@ -31,27 +44,98 @@ static void audio_FillSilence(uint16_t *buffer, uint32_t count) {
 
 /**
  * @brief Handle DMA half-transfer or transfer-complete interrupt
- * @param is_half_transfer true for half-transfer, false for transfer-complete
  * 
- * Called from LEFT channel callbacks only. RIGHT channel follows LEFT timing
- * since both channels receive the same stereo audio data.
+ * Called from the packed channel callbacks, or from LEFT channel callbacks
+ * only in split mode (RIGHT follows LEFT timing). Either way another half
+ * of the ring has played; which segments that freed follows from the
+ * position, so both interrupts are handled alike. The refill hook runs
+ * here, so refills are requested per half-ring, AUDIO_SEGMENT_COUNT / 2
+ * segments at a time.
  */
-static void audio_HandleDMA(Audio_Handle *audio, bool is_half_transfer) {
+static void audio_HandleDMA(Audio_Handle *audio) {
     if (!audio || !audio->initialized) return;
     
-    // Determine which half just finished playing (opposite of what we fill)
-    audio->fill_half = is_half_transfer ? AUDIO_BUFFER_FIRST_HALF : AUDIO_BUFFER_SECOND_HALF;
-    audio->needs_refill = true;
+    uint32_t played = audio->stats.samples_played + AUDIO_RING_HALF_SAMPLES;
+    
+    // DMA passed the last written segment - it replayed stale samples
+    if (audio->segments_filled * AUDIO_SEGMENT_SAMPLES < played) {
+        audio->stats.underrun_count++;
+    }
     
     // Update A/V sync with samples played
     if (audio->avsync) {
-        AVSync_AudioTick(audio->avsync, AUDIO_HALF_BUFFER_SAMPLES);
+        AVSync_AudioTick(audio->avsync, AUDIO_RING_HALF_SAMPLES);
     }
     
     // Update statistics
-    audio->stats.samples_played += AUDIO_HALF_BUFFER_SAMPLES;
+    audio->stats.samples_played = played;
+    
+    if (audio->refill_hook) {
+        audio->refill_hook(audio->refill_hook_ctx);
+    }
+}
+
+#if AUDIO_DAC_PACKED
+/**
+ * @brief Packed DMA half-transfer callback (first half finished playing)
+ */
+static void audio_PackedHalfCplt(DMA_HandleTypeDef *hdma) {
+    (void)hdma;
+    if (s_audio_handle) {
+        audio_HandleDMA(s_audio_handle);
+    }
+}
+
+/**
+ * @brief Packed DMA transfer-complete callback (second half finished playing)
+ */
+static void audio_PackedCplt(DMA_HandleTypeDef *hdma) {
+    (void)hdma;
+    if (s_audio_handle) {
+        audio_HandleDMA(s_audio_handle);
+    }
+}
+
+/**
+ * @brief Packed DMA transfer error callback
+ */
+static void audio_PackedError(DMA_HandleTypeDef *hdma) {
+    (void)hdma;
+    if (s_audio_handle) {
+        s_audio_handle->state = AUDIO_STATE_ERROR;
+    }
 }
 
+/**
+ * @brief Start one circular DMA stream into the dual-channel register
+ * 
+ * HAL_DAC_Start_DMA() only targets single-channel registers, so the DMA
+ * is started directly on DHR12RD. Channel 1 raises the DMA request; both
+ * channels share the TIM6 trigger and latch their halves of each word.
+ */
+static Audio_Status audio_StartPacked(DAC_HandleTypeDef *hdac) {
+    DMA_HandleTypeDef *hdma = hdac->DMA_Handle1;
+    if (!hdma) return AUDIO_ERROR;
+    
+    hdma->XferHalfCpltCallback = audio_PackedHalfCplt;
+    hdma->XferCpltCallback = audio_PackedCplt;
+    hdma->XferErrorCallback = audio_PackedError;
+    
+    if (HAL_DMA_Start_IT(hdma, (uint32_t)s_dma_buffer_packed,
+                         (uint32_t)&hdac->Instance->DHR12RD,
+                         AUDIO_RING_SAMPLES) != HAL_OK) {
+        return AUDIO_ERROR;
+    }
+    
+    __HAL_DAC_ENABLE_IT(hdac, DAC_IT_DMAUDR1);
+    SET_BIT(hdac->Instance->CR, DAC_CR_DMAEN1);
+    __HAL_DAC_ENABLE(hdac, DAC_CHANNEL_1);
+    __HAL_DAC_ENABLE(hdac, DAC_CHANNEL_2);
+    
+    return AUDIO_OK;
+}
+#endif
+
 /* ========================== Public API ========================== */
 
 Audio_Status audio_Init(Audio_Handle *audio, DAC_HandleTypeDef *hdac, TIM_HandleTypeDef *htim) {
@@ -66,12 +150,15 @@ Audio_Status audio_Init(Audio_Handle *audio, DAC_HandleTypeDef *hdac, TIM_Handle
     audio->avsync = NULL;
     
     // Initialize DMA buffers with silence
-    audio_FillSilence(s_dma_buffer_left, AUDIO_FULL_BUFFER_SAMPLES);
-    audio_FillSilence(s_dma_buffer_right, AUDIO_FULL_BUFFER_SAMPLES);
+#if AUDIO_DAC_PACKED
+    audio_FillSilence((uint16_t*)s_dma_buffer_packed, AUDIO_RING_SAMPLES * 2);
+#else
+    audio_FillSilence(s_dma_buffer_left, AUDIO_RING_SAMPLES);
+    audio_FillSilence(s_dma_buffer_right, AUDIO_RING_SAMPLES);
+#endif
     
     // Initialize state
-    audio->needs_refill = false;
-    audio->fill_half = AUDIO_BUFFER_FIRST_HALF;
+    audio->segments_filled = 0;
     audio->state = AUDIO_STATE_READY;
     audio->initialized = true;
     
@@ -81,29 +168,57 @@ Audio_Status audio_Init(Audio_Handle *audio, DAC_HandleTypeDef *hdac, TIM_Handle
     return AUDIO_OK;
 }
 
+/**
+ * @brief AVSync clock source adapter
+ */
+static uint32_t audio_ClockSource(void *ctx) {
+    return audio_GetPlaybackPosition((Audio_Handle*)ctx);
+}
+
 void audio_SetAVSync(Audio_Handle *audio, struct AVSync_Handle *sync) {
     if (audio) {
         audio->avsync = sync;
+        if (sync) {
+            AVSync_SetClockSource(sync, audio_ClockSource, audio);
+        }
+    }
+}
+
+void audio_SetRefillHook(Audio_Handle *audio, Audio_RefillHook hook, void *ctx) {
+    if (audio) {
+        audio->refill_hook = hook;
+        audio->refill_hook_ctx = ctx;
     }
 }
 
 Audio_Status audio_Start(Audio_Handle *audio) {
     if (!audio || !audio->initialized) return AUDIO_ERROR;
     
+    // Whole ring pre-filled by the caller
+    audio->segments_filled = AUDIO_SEGMENT_COUNT;
+    
     // Start timer for DAC triggering
     HAL_TIM_Base_Start(audio->htim);
     
+#if AUDIO_DAC_PACKED
+    if (audio_StartPacked(audio->hdac) != AUDIO_OK) {
+        HAL_TIM_Base_Stop(audio->htim);
+        audio->state = AUDIO_STATE_ERROR;
+        return AUDIO_ERROR;
+    }
+#else
     // Start LEFT channel (DAC_CHANNEL_1) with circular DMA
     HAL_DAC_Start_DMA(audio->hdac, DAC_CHANNEL_1,
                       (uint32_t*)s_dma_buffer_left,
-                      AUDIO_FULL_BUFFER_SAMPLES,
+                      AUDIO_RING_SAMPLES,
                       DAC_ALIGN_12B_R);
     
     // Start RIGHT channel (DAC_CHANNEL_2) with circular DMA
     HAL_DAC_Start_DMA(audio->hdac, DAC_CHANNEL_2,
                       (uint32_t*)s_dma_buffer_right,
-                      AUDIO_FULL_BUFFER_SAMPLES,
+                      AUDIO_RING_SAMPLES,
                       DAC_ALIGN_12B_R);
+#endif
     
     audio->state = AUDIO_STATE_PLAYING;
     return AUDIO_OK;
@@ -112,9 +227,13 @@ Audio_Status audio_Start(Audio_Handle *audio) {
 void audio_Stop(Audio_Handle *audio) {
     if (!audio) return;
     
-    // Stop DMA on both channels
+    // Stop DMA on both channels (packed mode has only the channel 1 stream)
     HAL_DAC_Stop_DMA(audio->hdac, DAC_CHANNEL_1);
+#if AUDIO_DAC_PACKED
+    __HAL_DAC_DISABLE(audio->hdac, DAC_CHANNEL_2);
+#else
     HAL_DAC_Stop_DMA(audio->hdac, DAC_CHANNEL_2);
+#endif
     
     // Stop timer
     HAL_TIM_Base_Stop(audio->htim);
@@ -123,13 +242,37 @@ void audio_Stop(Audio_Handle *audio) {
 }
 
 bool audio_NeedsRefill(Audio_Handle *audio) {
-    if (!audio) return false;
-    return audio->needs_refill;
+    if (!audio || audio->state != AUDIO_STATE_PLAYING) return false;
+    
+    // Segment k reuses the slot of k - COUNT, free once that has played
+    uint32_t segments_played = audio_GetPlaybackPosition(audio) / AUDIO_SEGMENT_SAMPLES;
+    return audio->segments_filled < segments_played + AUDIO_SEGMENT_COUNT;
 }
 
-Audio_BufferHalf audio_GetFillHalf(Audio_Handle *audio) {
-    if (!audio) return AUDIO_BUFFER_FIRST_HALF;
-    return audio->fill_half;
+uint32_t audio_GetFillOffset(Audio_Handle *audio) {
+    if (!audio) return 0;
+    return (audio->segments_filled % AUDIO_SEGMENT_COUNT) * AUDIO_SEGMENT_SAMPLES;
+}
+
+#if AUDIO_DAC_PACKED
+uint32_t* audio_GetPackedBuffer(Audio_Handle *audio) {
+    (void)audio;  // Buffer is static, but keep param for API consistency
+    return s_dma_buffer_packed;
+}
+
+uint16_t* audio_GetLeftBuffer(Audio_Handle *audio) {
+    (void)audio;
+    return NULL;
+}
+
+uint16_t* audio_GetRightBuffer(Audio_Handle *audio) {
+    (void)audio;
+    return NULL;
+}
+#else
+uint32_t* audio_GetPackedBuffer(Audio_Handle *audio) {
+    (void)audio;
+    return NULL;
 }
 
 uint16_t* audio_GetLeftBuffer(Audio_Handle *audio) {
@@ -141,10 +284,83 @@ uint16_t* audio_GetRightBuffer(Audio_Handle *audio) {
     (void)audio;
     return s_dma_buffer_right;
 }
+#endif
+
+uint32_t audio_GetPlaybackPosition(Audio_Handle *audio) {
+    if (!audio || !audio->initialized) return 0;
+    
+    DMA_HandleTypeDef *hdma = audio->hdac->DMA_Handle1;
+    if (audio->state != AUDIO_STATE_PLAYING || !hdma) {
+        return audio->stats.samples_played;
+    }
+    
+    // Sample the ISR count and the DMA counter consistently
+    uint32_t halves_played;
+    uint32_t remaining;
+    do {
+        halves_played = audio->stats.samples_played;
+        remaining = __HAL_DMA_GET_COUNTER(hdma);
+    } while (halves_played != audio->stats.samples_played);
+    
+    // DMA read index within the ring (CNDTR reloads to the ring size)
+    uint32_t index = (AUDIO_RING_SAMPLES - remaining) % AUDIO_RING_SAMPLES;
+    uint32_t halves = halves_played / AUDIO_RING_HALF_SAMPLES;
+    uint32_t position = (halves / 2) * AUDIO_RING_SAMPLES + index;
+    
+    // Second half counted but DMA already wrapped: TC interrupt pending
+    if ((halves & 1) && index < AUDIO_RING_HALF_SAMPLES) {
+        position += AUDIO_RING_SAMPLES;
+    }
+    
+    return position;
+}
+
+uint32_t audio_GetBufferedSamples(Audio_Handle *audio) {
+    if (!audio || !audio->initialized) return 0;
+    if (audio->state != AUDIO_STATE_PLAYING) return AUDIO_RING_SAMPLES;
+    
+    int32_t buffered = (int32_t)(audio->segments_filled * AUDIO_SEGMENT_SAMPLES -
+                                 audio_GetPlaybackPosition(audio));
+    return (buffered > 0) ? (uint32_t)buffered : 0;
+}
+
+/**
+ * @brief Record the slack of the refill that just finished
+ * @param start Ring position (samples since start) of the refilled segment
+ * 
+ * Slack is the distance from the DMA read position to the segment's
+ * start: positive while the DMA has not reached it yet.
+ */
+static void audio_RecordSlack(Audio_Handle *audio, uint32_t start) {
+    uint32_t position = audio_GetPlaybackPosition(audio);
+    int32_t slack = (int32_t)(start - position);
+    Audio_Stats *st = &audio->stats;
+    
+    if (slack >= 0) {
+        uint32_t bin = (uint32_t)slack / AUDIO_SLACK_BIN_SAMPLES;
+        st->slack_hist[(bin < AUDIO_SLACK_BINS) ? bin : AUDIO_SLACK_BINS - 1]++;
+    } else {
+        // DMA already playing the refilled segment - its start went out
+        // stale. Counted here unless a ring interrupt has already seen it.
+        if (position / AUDIO_RING_HALF_SAMPLES == start / AUDIO_RING_HALF_SAMPLES) {
+            st->underrun_count++;
+        }
+        st->slack_hist[0]++;
+    }
+    
+    if (st->refill_count == 0 || slack < st->slack_min) {
+        st->slack_min = slack;
+    }
+    st->slack_last = slack;
+}
 
 void audio_BufferFilled(Audio_Handle *audio) {
     if (!audio) return;
-    audio->needs_refill = false;
+    
+    if (audio->initialized && audio->state == AUDIO_STATE_PLAYING) {
+        audio_RecordSlack(audio, audio->segments_filled * AUDIO_SEGMENT_SAMPLES);
+    }
+    audio->segments_filled++;
     audio->stats.refill_count++;
 }
 
@@ -154,13 +370,15 @@ void audio_BufferFilled(Audio_Handle *audio) {
  * These override the weak default implementations in the HAL.
  * Only LEFT channel (Ch1) callbacks do real work - LEFT is the master.
  * RIGHT channel callbacks are no-ops since both channels are filled together.
+ * In packed mode the DMA callbacks above are used instead and HAL never
+ * calls these.
  */
 
 // LEFT channel half-transfer complete (first half finished playing)
 void HAL_DAC_ConvHalfCpltCallbackCh1(DAC_HandleTypeDef *hdac) {
     (void)hdac;
     if (s_audio_handle) {
-        audio_HandleDMA(s_audio_handle, true);
+        audio_HandleDMA(s_audio_handle);
     }
 }
 
@@ -168,7 +386,7 @@ void HAL_DAC_ConvHalfCpltCallbackCh1(DAC_HandleTypeDef *hdac) {
 void HAL_DAC_ConvCpltCallbackCh1(DAC_HandleTypeDef *hdac) {
     (void)hdac;
     if (s_audio_handle) {
-        audio_HandleDMA(s_audio_handle, false);
+        audio_HandleDMA(s_audio_handle);
     }
 }
 
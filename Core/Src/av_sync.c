@@ -8,29 +8,59 @@
 #include "av_sync.h"
 #include <string.h>
 
+/**
+ * @brief Convert an audio sample position to a frame index (exact floor)
+ */
+static inline uint32_t AVSync_SamplesToFrame(const AVSync_Handle *sync, uint32_t samples) {
+    return (uint32_t)(((uint64_t)samples * sync->fps_num) / sync->samples_per_frame_den);
+}
+
 void AVSync_Init(AVSync_Handle *sync, uint32_t sample_rate, 
                  uint32_t video_fps, uint32_t max_drift) {
-    if (!sync || sample_rate == 0 || video_fps == 0) return;
+    AVSync_InitRational(sync, sample_rate, video_fps, 1, max_drift);
+}
+
+void AVSync_InitRational(AVSync_Handle *sync, uint32_t sample_rate,
+                         uint32_t fps_num, uint32_t fps_den, uint32_t max_drift) {
+    if (!sync || sample_rate == 0 || fps_num == 0 || fps_den == 0) return;
     
     // Clear everything
     memset(sync, 0, sizeof(AVSync_Handle));
     
     // Configuration
     sync->audio_sample_rate = sample_rate;
-    sync->video_fps = video_fps;
-    sync->samples_per_frame = sample_rate / video_fps;
+    sync->fps_num = fps_num;
+    sync->fps_den = fps_den;
+    sync->samples_per_frame_den = (uint64_t)sample_rate * fps_den;
     sync->max_drift_frames = (max_drift > 0) ? max_drift : AVSYNC_DEFAULT_MAX_DRIFT;
+    sync->present_latency = sample_rate / 1000 * AVSYNC_INITIAL_LATENCY_MS;
     
     // Initial state
     sync->state = AVSYNC_STATE_READY;
     sync->initialized = true;
 }
 
+void AVSync_SetRenderAhead(AVSync_Handle *sync, uint32_t frames) {
+    if (!sync) return;
+    sync->render_ahead_frames = frames;
+}
+
+void AVSync_SetClockSource(AVSync_Handle *sync, AVSync_ClockFn fn, void *ctx) {
+    if (!sync) return;
+    
+    sync->clock_fn = fn;
+    sync->clock_ctx = ctx;
+    sync->clock_base = fn ? fn(ctx) : 0;
+}
+
 void AVSync_Start(AVSync_Handle *sync) {
     if (!sync || !sync->initialized) return;
     
     // Reset playback counters
     sync->audio_samples_played = 0;
+    if (sync->clock_fn) {
+        sync->clock_base = sync->clock_fn(sync->clock_ctx);
+    }
     sync->video_frames_rendered = 0;
     
     // Reset statistics
@@ -54,8 +84,8 @@ AVSync_Decision AVSync_GetFrameDecision(AVSync_Handle *sync) {
         return AVSYNC_NOT_STARTED;
     }
     
-    // Calculate expected video frame from audio position
-    uint32_t audio_frame = sync->audio_samples_played / sync->samples_per_frame;
+    // Expected video frame: the one due when a transfer started now lands
+    uint32_t audio_frame = AVSync_GetPresentFrame(sync);
     uint32_t video_frame = sync->video_frames_rendered;
     
     // Drift: positive = video ahead, negative = video behind
@@ -69,8 +99,8 @@ AVSync_Decision AVSync_GetFrameDecision(AVSync_Handle *sync) {
     if (drift < -(int32_t)sync->max_drift_frames) {
         // Video behind audio - skip frame to catch up
         return AVSYNC_SKIP_FRAME;
-    } else if (drift > (int32_t)sync->max_drift_frames) {
-        // Video ahead of audio - wait
+    } else if (drift > (int32_t)(sync->max_drift_frames + sync->render_ahead_frames)) {
+        // Video ahead of audio (beyond any render-ahead lead) - wait
         return AVSYNC_REPEAT_FRAME;
     } else {
         // In sync - render normally
@@ -89,14 +119,70 @@ void AVSync_FrameSkipped(AVSync_Handle *sync) {
     sync->stats.frames_skipped++;
 }
 
+uint32_t AVSync_GetFrameDueSample(const AVSync_Handle *sync, uint32_t frame) {
+    if (!sync || !sync->initialized) return 0;
+    
+    // Smallest position whose frame (floor) reaches this one
+    return (uint32_t)(((uint64_t)frame * sync->samples_per_frame_den + sync->fps_num - 1) /
+                      sync->fps_num);
+}
+
+uint32_t AVSync_GetPresentFrame(const AVSync_Handle *sync) {
+    if (!sync || !sync->initialized) return 0;
+    return AVSync_SamplesToFrame(sync, AVSync_GetAudioPosition(sync) + sync->present_latency);
+}
+
+bool AVSync_IsPresentDue(const AVSync_Handle *sync, uint32_t frame) {
+    if (!sync || sync->state != AVSYNC_STATE_RUNNING) return true;
+    
+    uint32_t due = AVSync_GetFrameDueSample(sync, frame);
+    uint32_t deadline = (due > sync->present_latency) ? due - sync->present_latency : 0;
+    return AVSync_GetAudioPosition(sync) >= deadline;
+}
+
+void AVSync_FramePresented(AVSync_Handle *sync, uint32_t frame,
+                           uint32_t start, uint32_t complete) {
+    if (!sync || sync->state != AVSYNC_STATE_RUNNING) return;
+    
+    // Latency EWMA
+    int32_t latency = (int32_t)(complete - start);
+    int32_t estimate = (int32_t)sync->present_latency;
+    sync->present_latency = (uint32_t)(estimate + (latency - estimate) / (1 << AVSYNC_LATENCY_SHIFT));
+    
+    // Presentation error against the frame's due time
+    int32_t error = (int32_t)(complete - AVSync_GetFrameDueSample(sync, frame));
+    AVSync_Stats *st = &sync->stats;
+    
+    if (st->frames_presented == 0 || error < st->present_error_min) st->present_error_min = error;
+    if (st->frames_presented == 0 || error > st->present_error_max) st->present_error_max = error;
+    st->present_error_last = error;
+    st->present_error_abs_sum += (uint32_t)(error < 0 ? -error : error);
+    st->frames_presented++;
+    
+    // Frame budget: latency > sample_rate * fps_den / fps_num
+    if (latency > 0) {
+        if ((uint32_t)latency > st->present_latency_max) st->present_latency_max = (uint32_t)latency;
+        if ((uint64_t)latency * sync->fps_num > sync->samples_per_frame_den) st->frames_over_budget++;
+    }
+}
+
+uint32_t AVSync_GetAudioPosition(const AVSync_Handle *sync) {
+    if (!sync) return 0;
+    
+    if (sync->clock_fn && sync->state == AVSYNC_STATE_RUNNING) {
+        return sync->clock_fn(sync->clock_ctx) - sync->clock_base;
+    }
+    return sync->audio_samples_played;
+}
+
 uint32_t AVSync_GetCurrentFrame(const AVSync_Handle *sync) {
-    if (!sync || sync->samples_per_frame == 0) return 0;
-    return sync->audio_samples_played / sync->samples_per_frame;
+    if (!sync || !sync->initialized) return 0;
+    return AVSync_SamplesToFrame(sync, AVSync_GetAudioPosition(sync));
 }
 
 int32_t AVSync_GetCurrentDrift(const AVSync_Handle *sync) {
-    if (!sync || sync->samples_per_frame == 0) return 0;
+    if (!sync || !sync->initialized) return 0;
     
-    uint32_t audio_frame = sync->audio_samples_played / sync->samples_per_frame;
+    uint32_t audio_frame = AVSync_SamplesToFrame(sync, AVSync_GetAudioPosition(sync));
     return (int32_t)sync->video_frames_rendered - (int32_t)audio_frame;
 }
@@ -9,19 +9,15 @@
 
 /* ========================== Display Framebuffers ========================== */
 
-// Triple buffer for display - 32-byte aligned for DMA
+// Frame queue slots for display - 32-byte aligned for DMA
 uint8_t g_framebuffer[FRAMEBUFFER_COUNT][FRAMEBUFFER_SIZE]
     __attribute__((aligned(32)));
 
-/* ========================== Triple Buffer State ========================== */
+/* ========================== Frame Queue State ========================== */
 
-TripleBuffer_State g_display_buffers = {
-    .render = 0,
-    .ready = 2,
-    .transfer = 1,
-    .transfer_busy = false,
-    .frames_rendered = 0,
-    .frames_transferred = 0
+FrameQueue g_frame_queue = {
+    .head = 0,
+    .tail = 0
 };
 
 /* ========================== Initialization ========================== */
@@ -30,11 +26,8 @@ void Buffers_Init(void) {
     // Clear framebuffers
     memset(g_framebuffer, 0, sizeof(g_framebuffer));
     
-    // Reset triple buffer state
-    g_display_buffers.render = 0;
-    g_display_buffers.ready = 2;
-    g_display_buffers.transfer = 1;
-    g_display_buffers.transfer_busy = false;
-    g_display_buffers.frames_rendered = 0;
-    g_display_buffers.frames_transferred = 0;
+    // Empty queue
+    g_frame_queue.head = 0;
+    g_frame_queue.tail = 0;
+    memset(g_frame_queue.tag, 0, sizeof(g_frame_queue.tag));
 }
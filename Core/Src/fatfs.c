@@ -9,6 +9,11 @@
 #include <string.h>
 #include <ctype.h>
 
+/* ========================== Private Data ========================== */
+
+// Bulk FAT window for FAT_ScanChain (entries indexed directly)
+static uint32_t s_scan_window[FAT_SCAN_SECTORS * FAT_ENTRIES_PER_SECTOR];
+
 /* ========================== Private Helpers ========================== */
 
 // Read 16-bit little-endian value from buffer
@@ -24,6 +29,44 @@ static inline uint32_t FAT_Read32(const uint8_t *buf, uint16_t offset) {
            ((uint32_t)buf[offset + 3] << 24);
 }
 
+/**
+ * @brief Get a FAT sector from the cache, reading it on a miss
+ * @return Pointer to cached sector data, or NULL on read error
+ */
+static const uint8_t* FAT_CacheGetSector(FAT_Volume *vol, uint32_t sector) {
+    FAT_Cache *cache = &vol->fat_cache;
+    FAT_CacheEntry *victim = &cache->entries[0];
+    
+    cache->tick++;
+    
+    for (int i = 0; i < FAT_CACHE_ENTRIES; i++) {
+        FAT_CacheEntry *entry = &cache->entries[i];
+        
+        if (entry->sector == sector) {
+            entry->last_used = cache->tick;
+            cache->hits++;
+            return entry->data;
+        }
+        
+        // Prefer an empty slot, otherwise the least recently used
+        if (victim->sector != 0 &&
+            (entry->sector == 0 || entry->last_used < victim->last_used)) {
+            victim = entry;
+        }
+    }
+    
+    cache->misses++;
+    
+    if (SD_ReadBlock(vol->hsd, victim->data, sector) != SD_OK) {
+        victim->sector = 0;
+        return NULL;
+    }
+    
+    victim->sector = sector;
+    victim->last_used = cache->tick;
+    return victim->data;
+}
+
 /* ========================== Public API ========================== */
 
 FAT_Status FAT_Mount(FAT_Volume *vol, SD_Handle *hsd) {
@@ -192,17 +235,104 @@ uint32_t FAT_GetNextCluster(FAT_Volume *vol, uint32_t cluster) {
     uint32_t fat_sector = vol->boot.fat_start_sector + (fat_offset / FAT_SECTOR_SIZE);
     uint32_t entry_offset = fat_offset % FAT_SECTOR_SIZE;
     
-    // Read FAT sector
-    if (SD_ReadBlock(vol->hsd, vol->sector_buffer, fat_sector) != SD_OK) {
+    // Get FAT sector (cached - consecutive clusters share a sector)
+    const uint8_t *fat = FAT_CacheGetSector(vol, fat_sector);
+    if (!fat) {
         return 0;
     }
     
     // Get next cluster value (mask upper 4 bits - reserved in FAT32)
-    uint32_t next = FAT_Read32(vol->sector_buffer, entry_offset) & 0x0FFFFFFF;
+    uint32_t next = FAT_Read32(fat, entry_offset) & 0x0FFFFFFF;
     
     return next;
 }
 
+FAT_Status FAT_ScanChain(FAT_Volume *vol, uint32_t first_cluster, uint32_t max_clusters,
+                         FAT_RunCallback callback, void *ctx, FAT_ScanResult *result) {
+    if (!vol || !vol->mounted || !callback) return FAT_ERROR_INVALID_PARAM;
+    
+    FAT_ScanResult scan = {0};
+    FAT_Status status = FAT_OK;
+    bool stopped = false;
+    
+    uint32_t fat_entries = vol->boot.sectors_per_fat * FAT_ENTRIES_PER_SECTOR;
+    uint32_t window_first = 0;      // FAT index of s_scan_window[0]
+    uint32_t window_count = 0;      // Valid entries in window (0 = empty)
+    
+    uint32_t cluster = first_cluster;
+    uint32_t run_start = 0;
+    uint32_t run_length = 0;
+    uint32_t file_cluster = 0;
+    
+    while (!FAT_IsEndOfChain(cluster) && scan.clusters < max_clusters) {
+        if (cluster >= fat_entries) {
+            status = FAT_ERROR;
+            break;
+        }
+        
+        // Load the window holding this cluster's entry (wraps if below window)
+        if (cluster - window_first >= window_count) {
+            uint32_t sector_index = cluster / FAT_ENTRIES_PER_SECTOR;
+            uint32_t sectors = vol->boot.sectors_per_fat - sector_index;
+            if (sectors > FAT_SCAN_SECTORS) {
+                sectors = FAT_SCAN_SECTORS;
+            }
+            
+            if (SD_ReadMultipleBlocks(vol->hsd, (uint8_t*)s_scan_window,
+                                      vol->boot.fat_start_sector + sector_index,
+                                      sectors) != SD_OK) {
+                status = FAT_ERROR_READ;
+                break;
+            }
+            
+            window_first = sector_index * FAT_ENTRIES_PER_SECTOR;
+            window_count = sectors * FAT_ENTRIES_PER_SECTOR;
+            scan.sectors_read += sectors;
+        }
+        
+        // Extend the current run, or report it and start a new one
+        if (run_length > 0 && cluster == run_start + run_length) {
+            run_length++;
+        } else {
+            if (run_length > 0) {
+                scan.runs++;
+                if (!callback(ctx, file_cluster, run_start, run_length)) {
+                    stopped = true;
+                    break;
+                }
+                file_cluster += run_length;
+            }
+            run_start = cluster;
+            run_length = 1;
+        }
+        scan.clusters++;
+        
+        // Tight loop: follow consecutive links without leaving the window
+        // (entries are little-endian, matching the Cortex-M4)
+        uint32_t next = s_scan_window[cluster - window_first] & 0x0FFFFFFF;
+        while (next == cluster + 1 && next - window_first < window_count &&
+               scan.clusters < max_clusters) {
+            cluster = next;
+            run_length++;
+            scan.clusters++;
+            next = s_scan_window[cluster - window_first] & 0x0FFFFFFF;
+        }
+        cluster = next;
+    }
+    
+    // Report the final run
+    if (status == FAT_OK && !stopped && run_length > 0) {
+        scan.runs++;
+        callback(ctx, file_cluster, run_start, run_length);
+    }
+    
+    if (result) {
+        *result = scan;
+    }
+    
+    return status;
+}
+
 uint32_t FAT_ClusterToSector(FAT_Volume *vol, uint32_t cluster) {
     if (!vol || !vol->mounted || cluster < 2) {
         return 0;
@@ -0,0 +1,256 @@
+/**
+ * @file    io_sched.c
+ * @brief   Deadline-aware SD read scheduler implementation
+ * @author  David Leathers
+ * @date    November 2025
+ */
+
+#include "io_sched.h"
+#include "perf.h"
+#include <string.h>
+
+/**
+ * @brief True if sample position a is later than b (wrap-safe)
+ */
+static inline bool IOSched_After(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) > 0;
+}
+
+/**
+ * @brief Find the queued refill
+ * @return Queue index, or -1 if none
+ */
+static int32_t IOSched_FindAudio(const IO_Sched *sched) {
+    for (uint32_t i = 0; i < sched->depth; i++) {
+        if (sched->queue[i].type == IO_REQ_AUDIO) return (int32_t)i;
+    }
+    return -1;
+}
+
+/**
+ * @brief Pick the next request: the refill, else the earliest video deadline
+ */
+static int32_t IOSched_Select(const IO_Sched *sched) {
+    int32_t audio = IOSched_FindAudio(sched);
+    if (audio >= 0) return audio;
+    
+    int32_t best = -1;
+    for (uint32_t i = 0; i < sched->depth; i++) {
+        if (best < 0 || IOSched_After(sched->queue[best].deadline, sched->queue[i].deadline)) {
+            best = (int32_t)i;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Append a request, tracking queue depth
+ */
+static bool IOSched_Push(IO_Sched *sched, const IO_Request *req) {
+    if (sched->depth >= IO_SCHED_MAX_REQUESTS) return false;
+    
+    sched->queue[sched->depth++] = *req;
+    if (sched->depth > sched->stats.depth_max) {
+        sched->stats.depth_max = sched->depth;
+    }
+    return true;
+}
+
+/**
+ * @brief Remove a request (order is not kept - selection scans)
+ */
+static void IOSched_Remove(IO_Sched *sched, int32_t index) {
+    sched->depth--;
+    sched->queue[index] = sched->queue[sched->depth];
+}
+
+/**
+ * @brief Queue a refill once the DMA has released a segment (main-loop mode)
+ * 
+ * The deadline is the sample at which the DMA reaches that segment: the
+ * audio currently written ahead of it.
+ */
+static void IOSched_PollAudio(IO_Sched *sched) {
+    // PendSV owns refills in IRQ mode
+    if (IO_SCHED_REFILL_IRQ) return;
+    
+    if (!audio_NeedsRefill(sched->audio) || IOSched_FindAudio(sched) >= 0) return;
+    
+    IO_Request req = {
+        .type = IO_REQ_AUDIO,
+        .deadline = AVSync_GetAudioPosition(sched->sync) +
+                    audio_GetBufferedSamples(sched->audio),
+    };
+    IOSched_Push(sched, &req);
+}
+
+/**
+ * @brief Service a refill and check it against its deadline
+ * @return false if the fill handler wrote nothing (the segment stays free)
+ */
+static bool IOSched_ServiceAudio(IO_Sched *sched, const IO_Request *req) {
+    uint32_t start = Perf_GetCycles();
+    
+    uint32_t latency_us = Perf_CyclesToMicros(start - sched->refill_requested_at);
+    if (latency_us > sched->stats.refill_latency_max_us) {
+        sched->stats.refill_latency_max_us = latency_us;
+    }
+    
+    uint32_t offset = audio_GetFillOffset(sched->audio);
+    if (!sched->audio_fill || !sched->audio_fill(sched->handler_ctx, offset)) return false;
+    audio_BufferFilled(sched->audio);
+    
+    uint32_t elapsed_us = Perf_CyclesToMicros(Perf_GetCycles() - start);
+    if (elapsed_us > sched->stats.audio_max_us) {
+        sched->stats.audio_max_us = elapsed_us;
+    }
+    
+    // Slack itself is tracked by the audio driver (Audio_Stats)
+    if (IOSched_After(AVSync_GetAudioPosition(sched->sync), req->deadline)) {
+        sched->stats.audio_missed++;
+    }
+    sched->stats.audio_serviced++;
+    return true;
+}
+
+/**
+ * @brief Read the next slice of a frame
+ * @return true once the request is finished (read complete or failed)
+ * 
+ * In IRQ mode the read holds the SD bus against PendSV; a refill that
+ * fired meanwhile is re-pended as soon as the slice returns.
+ */
+static bool IOSched_ServiceVideo(IO_Sched *sched, IO_Request *req) {
+    uint32_t bytes_read = 0;
+    
+#if IO_SCHED_REFILL_IRQ
+    sched->bus_busy = true;
+    __DMB();
+#endif
+    
+    FAT_Status status = Media_ReadFramePart(sched->media, req->frame, req->buffer,
+                                            req->done, IO_SCHED_SLICE_BYTES, &bytes_read);
+    
+#if IO_SCHED_REFILL_IRQ
+    __DMB();
+    sched->bus_busy = false;
+    if (sched->refill_deferred) {
+        sched->refill_deferred = false;
+        sched->stats.preemptions++;
+        SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+    }
+#endif
+    
+    sched->stats.video_slices++;
+    req->done += bytes_read;
+    
+    if (status == FAT_OK && req->done < MEDIA_FRAME_SIZE) return false;
+    
+    if (IOSched_After(AVSync_GetAudioPosition(sched->sync), req->deadline)) {
+        sched->stats.video_missed++;
+    }
+    sched->stats.video_serviced++;
+    
+    if (sched->video_done) {
+        sched->video_done(sched->handler_ctx, req->frame, req->buffer, status);
+    }
+    return true;
+}
+
+/* ========================== Public API ========================== */
+
+void IOSched_Init(IO_Sched *sched, MediaFile *media, Audio_Handle *audio, AVSync_Handle *sync) {
+    if (!sched || !media || !audio || !sync) return;
+    
+    memset(sched, 0, sizeof(IO_Sched));
+    sched->media = media;
+    sched->audio = audio;
+    sched->sync = sync;
+    sched->initialized = true;
+}
+
+void IOSched_SetHandlers(IO_Sched *sched, IO_AudioFillFn fill, IO_VideoDoneFn done, void *ctx) {
+    if (!sched) return;
+    
+    sched->audio_fill = fill;
+    sched->video_done = done;
+    sched->handler_ctx = ctx;
+}
+
+bool IOSched_SubmitVideo(IO_Sched *sched, uint32_t frame, uint8_t *buffer) {
+    if (!sched || !sched->initialized || !buffer) return false;
+    
+    // Keep the last slot free for a refill
+    if (sched->depth >= IO_SCHED_MAX_REQUESTS - 1) return false;
+    
+    IO_Request req = {
+        .type = IO_REQ_VIDEO,
+        .deadline = AVSync_GetFrameDueSample(sched->sync, frame),
+        .frame = frame,
+        .buffer = buffer,
+        .done = 0,
+    };
+    return IOSched_Push(sched, &req);
+}
+
+void IOSched_AudioHalfDone(IO_Sched *sched) {
+    if (!sched || !sched->initialized) return;
+    
+    sched->refill_requested_at = Perf_GetCycles();
+#if IO_SCHED_REFILL_IRQ
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+#endif
+}
+
+void IOSched_RefillIRQHandler(IO_Sched *sched) {
+#if IO_SCHED_REFILL_IRQ
+    if (!sched || !sched->initialized || !audio_NeedsRefill(sched->audio)) return;
+    
+    // Never split a media read - run once the main loop's read returns
+    if (sched->bus_busy) {
+        sched->refill_deferred = true;
+        sched->stats.refills_deferred++;
+        return;
+    }
+    
+    // Every segment the DMA has freed since the last interrupt. A failed
+    // fill leaves its segment free, so stop rather than spin at PendSV.
+    do {
+        IO_Request req = {
+            .type = IO_REQ_AUDIO,
+            .deadline = AVSync_GetAudioPosition(sched->sync) +
+                        audio_GetBufferedSamples(sched->audio),
+        };
+        if (!IOSched_ServiceAudio(sched, &req)) break;
+    } while (audio_NeedsRefill(sched->audio));
+#else
+    (void)sched;
+#endif
+}
+
+void IOSched_Run(IO_Sched *sched) {
+    if (!sched || !sched->initialized) return;
+    
+    IOSched_PollAudio(sched);
+    
+    while (sched->depth > 0) {
+        int32_t index = IOSched_Select(sched);
+        IO_Request *req = &sched->queue[index];
+        
+        if (req->type == IO_REQ_AUDIO) {
+            IO_Request audio_req = *req;
+            IOSched_Remove(sched, index);
+            if (IOSched_ServiceAudio(sched, &audio_req)) {
+                IOSched_PollAudio(sched);   // Next free segment, if any
+            }
+        } else if (IOSched_ServiceVideo(sched, req)) {
+            IOSched_Remove(sched, index);
+        } else {
+            // Sector boundary - let a refill that fell due go first
+            IOSched_PollAudio(sched);
+            if (IOSched_FindAudio(sched) >= 0) {
+                sched->stats.preemptions++;
+            }
+        }
+    }
+}
@@ -6,15 +6,17 @@
  * Plays synchronized video and audio from SD card on STM32L476RG.
  * 
  * Hardware:
- *   - 128x64 OLED (SSD1306) via I2C2 with DMA
+ *   - 128x64 OLED (SSD1306) via I2C2 with DMA (1 MHz Fast-mode Plus)
  *   - SD Card via SPI3 with DMA
  *   - Stereo DAC output (PA4/PA5) via DMA
  *   - TIM6 triggers DAC at 32kHz
  * 
  * Architecture:
  *   - Audio-master synchronization (video follows audio timing)
- *   - Triple-buffered display for tear-free rendering
- *   - Double-buffered audio with half-transfer interrupts
+ *   - Frame queue: lock-free SPSC ring of FRAME_QUEUE_DEPTH framebuffers
+ *     between the renderer and the display DMA (tear-free, render-ahead)
+ *   - Segmented audio ring, refilled as the DMA frees each segment
+ *   - Optional live overlay (time, drift, refill slack), toggled by B1
  */
 
 #include "main.h"
@@ -25,13 +27,37 @@
 #include "audio_dac.h"
 #include "av_sync.h"
 #include "media_file_reader.h"
+#include "io_sched.h"
+#include "osd.h"
 #include "perf.h"
 #include <string.h>
 #include <stdio.h>
 
 /* ========================== Configuration ========================== */
 
-#define VIDEO_FPS               30
+// Render-ahead: frames decoded ahead of the audio clock into the frame
+// queue while the audio buffer has slack (0 = decode each frame when due)
+#define RENDER_AHEAD_FRAMES     (FRAME_QUEUE_DEPTH - 1)
+
+// Audio buffered ahead of the DAC required before rendering ahead (samples)
+#define RENDER_AHEAD_MIN_BUFFERED   (AUDIO_RING_HALF_SAMPLES + AUDIO_SEGMENT_SAMPLES / 8)
+
+// Display bus: 1 = Fast-mode Plus at 1 MHz (a full frame in ~9 ms, inside
+// the 16.7 ms budget of 60 fps files), 0 = Fast mode at 400 kHz (~23 ms)
+#ifndef DISPLAY_I2C_FAST_MODE_PLUS
+#define DISPLAY_I2C_FAST_MODE_PLUS  1
+#endif
+
+// Live overlay: shown from the start of playback (1) or only after a B1
+// press (0), and the button debounce time (ms)
+#ifndef OSD_SHOW_AT_START
+#define OSD_SHOW_AT_START       0
+#endif
+#define OSD_BUTTON_DEBOUNCE_MS  50
+
+// Time each statistics page is shown after playback (ms)
+#define STATS_PAGE_MS           4000
+
 #define TIM6_PERIOD             ((80000000 / AUDIO_SAMPLE_RATE) - 1)
 
 /* ========================== HAL Handles ========================== */
@@ -56,12 +82,30 @@ FAT_Volume g_volume;
 Audio_Handle g_audio;
 MediaFile g_media;
 AVSync_Handle g_avsync;
+IO_Sched g_iosched;
+OSD_Handle g_osd;
 
 /* ========================== Statistics ========================== */
 
-static volatile uint32_t g_max_audio_fill_us = 0;
 static volatile uint32_t g_frames_rendered = 0;
 static volatile uint32_t g_frames_repeated = 0;
+static uint32_t g_frames_ahead = 0;         // Frames rendered before they were due
+static uint32_t g_frames_dropped = 0;       // Stale queued frames never shown
+
+// Display presentation: the transfer in flight
+static uint32_t g_present_frame = 0;
+static uint32_t g_present_start = 0;
+static volatile uint32_t g_present_complete = 0;
+static volatile bool g_present_done = false;
+
+// UpdateDisplay() CPU time for calls that start a frame transfer (DWT)
+static uint64_t g_display_cpu_cycles = 0;
+static uint32_t g_display_cpu_max = 0;
+static uint32_t g_display_cpu_frames = 0;
+
+// SD command-rate benchmark (commands issued per second of playback)
+static uint32_t g_sd_cmds_at_start = 0;
+static uint32_t g_playback_start_ms = 0;
 
 /* ========================== Function Prototypes ========================== */
 
@@ -107,41 +151,42 @@ void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c) {
 /* ========================== Audio Buffer Refill ========================== */
 
 /**
- * @brief Refill audio buffers when needed
+ * @brief Read one ring segment of audio into the DAC DMA buffer(s)
+ * @param ctx    Unused
+ * @param offset Sample offset of the segment within the ring
+ * @return false if the driver has no buffer for this mode
  * 
- * Called from main loop. Checks if audio DMA has consumed a half-buffer
- * and refills it with next audio samples from media file.
+ * Also the I/O scheduler's refill handler, which marks the segment filled.
  */
-static void RefillAudioBuffers(void) {
-    if (!audio_NeedsRefill(&g_audio)) return;
+static bool FillAudioSegment(void *ctx, uint32_t offset) {
+    (void)ctx;
     
-    uint32_t start = Perf_GetCycles();
+#if AUDIO_DAC_PACKED
+    uint32_t *packed = audio_GetPackedBuffer(&g_audio);
+    if (!packed) return false;
     
-    // Get buffer pointers
-    Audio_BufferHalf fill_half = audio_GetFillHalf(&g_audio);
+    Media_ReadAudioPacked(&g_media, packed + offset, AUDIO_SEGMENT_SAMPLES);
+#else
     uint16_t *left_base = audio_GetLeftBuffer(&g_audio);
     uint16_t *right_base = audio_GetRightBuffer(&g_audio);
+    if (!left_base || !right_base) return false;
     
-    if (!left_base || !right_base) {
-        return;
-    }
-    
-    // Calculate offset into circular buffer
-    uint32_t offset = (fill_half == AUDIO_BUFFER_FIRST_HALF) ? 0 : AUDIO_HALF_BUFFER_SAMPLES;
-    uint16_t *left = left_base + offset;
-    uint16_t *right = right_base + offset;
-    
-    // Read and convert audio samples
-    Media_ReadAudioStereo(&g_media, left, right, AUDIO_HALF_BUFFER_SAMPLES);
-    
-    // Mark buffer as filled
-    audio_BufferFilled(&g_audio);
-    
-    // Track maximum fill time
-    uint32_t elapsed_us = Perf_CyclesToMicros(Perf_GetCycles() - start);
-    if (elapsed_us > g_max_audio_fill_us) {
-        g_max_audio_fill_us = elapsed_us;
-    }
+    Media_ReadAudioStereo(&g_media, left_base + offset, right_base + offset,
+                          AUDIO_SEGMENT_SAMPLES);
+#endif
+    return true;
+}
+
+/**
+ * @brief Refill audio buffers when needed
+ * 
+ * Called from main loop. The I/O scheduler queues a refill once the DMA
+ * has freed a segment and services it ahead of any frame read.
+ * With IO_SCHED_REFILL_IRQ the refill runs from PendSV instead, and this
+ * only services queued frame reads.
+ */
+static void RefillAudioBuffers(void) {
+    IOSched_Run(&g_iosched);
 }
 
 /* ========================== SPI Speed Control ========================== */
@@ -163,25 +208,274 @@ static void SPI3_SetFastSpeed(void) {
 /* ========================== Video Rendering ========================== */
 
 /**
- * @brief Render video frame to triple buffer
+ * @brief Check whether there is time to decode a frame ahead of the clock
+ * 
+ * True while the DAC has well over half the ring queued and, with
+ * main-loop refills, none is pending, so an extra SD read cannot delay
+ * the next refill. (PendSV refills preempt the read anyway.)
  */
-static void RenderVideoFrame(uint32_t frame_number) {
-    uint8_t *render_buffer = Display_GetRenderBuffer();
-    
-    if (Media_ReadFrameAt(&g_media, frame_number, render_buffer) != FAT_OK) {
-        memset(render_buffer, 0, FRAMEBUFFER_SIZE);
+static bool AudioHasSlack(void) {
+    if (!IO_SCHED_REFILL_IRQ && audio_NeedsRefill(&g_audio)) return false;
+    return audio_GetBufferedSamples(&g_audio) >= RENDER_AHEAD_MIN_BUFFERED;
+}
+
+/**
+ * @brief Frame read complete - publish it to the display (I/O scheduler handler)
+ * 
+ * The overlay is drawn into the frame here, once the read has landed. The
+ * delta decoder keeps its reference frame privately, so this does not
+ * leak into the next decoded frame.
+ */
+static void OnFrameRead(void *ctx, uint32_t frame, uint8_t *buffer, FAT_Status status) {
+    (void)ctx;
+    if (status != FAT_OK) {
+        memset(buffer, 0, FRAMEBUFFER_SIZE);
     }
+    OSD_Compose(&g_osd, frame, buffer);
+    FrameQueue_Publish(frame);
+}
+
+/**
+ * @brief Render video frame into the frame queue
+ * @return false if the queue is full (retry once the display catches up)
+ * 
+ * The read goes through the I/O scheduler a sector at a time, so a refill
+ * falling due mid-frame is serviced before the rest of the frame.
+ */
+static bool RenderVideoFrame(uint32_t frame_number) {
+    uint8_t *render_buffer = FrameQueue_AcquireRender();
+    if (!render_buffer) return false;
+    
+    if (!IOSched_SubmitVideo(&g_iosched, frame_number, render_buffer)) return false;
+    IOSched_Run(&g_iosched);
+    return true;
+}
+
+/**
+ * @brief Toggle the overlay on a B1 press (polled from the main loop)
+ * 
+ * Takes effect from the next frame read; frames already queued show the
+ * previous state.
+ */
+static void PollOverlayButton(void) {
+    static bool pressed_last = false;
+    static uint32_t changed_at = 0;
     
-    Display_SwapBuffers();
+    bool pressed = (HAL_GPIO_ReadPin(B1_GPIO_Port, B1_Pin) == GPIO_PIN_RESET);
+    if (pressed == pressed_last) return;
+    if (HAL_GetTick() - changed_at < OSD_BUTTON_DEBOUNCE_MS) return;
+    
+    pressed_last = pressed;
+    changed_at = HAL_GetTick();
+    if (pressed) OSD_Toggle(&g_osd);
+}
+
+/**
+ * @brief Audio ring half played - hand the refill to the scheduler (ISR)
+ */
+static void OnAudioRefillDue(void *ctx) {
+    (void)ctx;
+    IOSched_AudioHalfDone(&g_iosched);
 }
 
 /**
- * @brief Start DMA transfer if frame ready
+ * @brief Display transfer complete - timestamp on the audio clock (ISR)
+ */
+static void OnDisplayTransferDone(void *ctx) {
+    (void)ctx;
+    g_present_complete = AVSync_GetAudioPosition(&g_avsync);
+    g_present_done = true;
+}
+
+/**
+ * @brief Start DMA transfer when the oldest queued frame reaches its deadline
+ * 
+ * The deadline is the frame's due time minus the measured transfer
+ * latency, so the frame finishes landing on the panel when it is due.
  */
 static void UpdateDisplay(void) {
+    uint32_t start = Perf_GetCycles();
+    
+    if (g_present_done) {
+        g_present_done = false;
+        AVSync_FramePresented(&g_avsync, g_present_frame, g_present_start, g_present_complete);
+    }
+    
     if (SSD1306_IsDMABusy(&g_display)) return;
-    if (!Display_HasFrame()) return;
+    
+    uint32_t frame;
+    if (!FrameQueue_Consume(&frame)) return;
+    
+    // Drop frames whose slot has passed when a newer one is queued behind
+    while (FrameQueue_Count() > 1 && frame < AVSync_GetPresentFrame(&g_avsync)) {
+        FrameQueue_Release();
+        g_frames_dropped++;
+        FrameQueue_Consume(&frame);
+    }
+    
+    if (!AVSync_IsPresentDue(&g_avsync, frame)) return;
+    
+    g_present_frame = frame;
+    g_present_start = AVSync_GetAudioPosition(&g_avsync);
     SSD1306_UpdateScreen_DMA(&g_display);
+    
+    uint32_t elapsed = Perf_GetCycles() - start;
+    g_display_cpu_cycles += elapsed;
+    if (elapsed > g_display_cpu_max) g_display_cpu_max = elapsed;
+    g_display_cpu_frames++;
+}
+
+/* ========================== Statistics Screens ========================== */
+
+/**
+ * @brief Show the playback summary (sync, display and I/O counters)
+ */
+static void ShowPlaybackStats(uint32_t sd_cmds_per_sec) {
+    char buf[64];
+    
+    const AVSync_Stats *sync_stats = AVSync_GetStats(&g_avsync);
+    const Audio_Stats *audio_stats = audio_GetStats(&g_audio);
+    const IO_Stats *io_stats = IOSched_GetStats(&g_iosched);
+    
+    SSD1306_Clear(&g_display);
+    SSD1306_SetCursor(&g_display, 0, 0);
+    snprintf(buf, sizeof(buf), "DONE %lucmd/s Q:%lu", (unsigned long)sd_cmds_per_sec,
+             (unsigned long)io_stats->depth_max);
+    SSD1306_WriteString(&g_display, buf, &Font_5x7, SSD1306_COLOR_WHITE);
+    
+    SSD1306_SetCursor(&g_display, 0, 12);
+    snprintf(buf, sizeof(buf), "Rend:%lu Ahd:%lu", (unsigned long)g_frames_rendered,
+             (unsigned long)g_frames_ahead);
+    SSD1306_WriteString(&g_display, buf, &Font_5x7, SSD1306_COLOR_WHITE);
+    
+    SSD1306_SetCursor(&g_display, 0, 22);
+    snprintf(buf, sizeof(buf), "Skip:%lu Rep:%lu", 
+             (unsigned long)(sync_stats ? sync_stats->frames_skipped : 0),
+             (unsigned long)g_frames_repeated);
+    SSD1306_WriteString(&g_display, buf, &Font_5x7, SSD1306_COLOR_WHITE);
+    
+    SSD1306_SetCursor(&g_display, 0, 32);
+    uint32_t present_err_us = (sync_stats && sync_stats->frames_presented) ?
+        (uint32_t)(sync_stats->present_error_abs_sum * 1000000 /
+                   ((uint64_t)sync_stats->frames_presented * g_avsync.audio_sample_rate)) : 0;
+    snprintf(buf, sizeof(buf), "Start:%luus Err:%luus", 
+             (unsigned long)io_stats->refill_latency_max_us,
+             (unsigned long)present_err_us);
+    SSD1306_WriteString(&g_display, buf, &Font_5x7, SSD1306_COLOR_WHITE);
+    
+    SSD1306_SetCursor(&g_display, 0, 42);
+    snprintf(buf, sizeof(buf), "Fill:%luus Lat:%lums", (unsigned long)io_stats->audio_max_us,
+             (unsigned long)(AVSync_GetPresentLatency(&g_avsync) * 1000 /
+                             g_avsync.audio_sample_rate));
+    SSD1306_WriteString(&g_display, buf, &Font_5x7, SSD1306_COLOR_WHITE);
+    
+    SSD1306_SetCursor(&g_display, 0, 52);
+    snprintf(buf, sizeof(buf), "U:%lu Drop:%lu Miss:%lu/%lu", 
+             (unsigned long)(audio_stats ? audio_stats->underrun_count : 0),
+             (unsigned long)g_frames_dropped,
+             (unsigned long)io_stats->audio_missed,
+             (unsigned long)io_stats->video_missed);
+    SSD1306_WriteString(&g_display, buf, &Font_5x7, SSD1306_COLOR_WHITE);
+    
+    SSD1306_UpdateScreen(&g_display);
+}
+
+/**
+ * @brief Show audio health: underruns, refill slack histogram, conversion cost
+ * 
+ * Slack is how far ahead of the DAC DMA each refill finished; bins are
+ * AUDIO_SLACK_BIN_SAMPLES wide, two per line. A histogram bunched near 0
+ * means the card or buffer size has no margin left.
+ * The last line is the PCM conversion cost per stereo sample.
+ */
+static void ShowAudioHealth(void) {
+    char buf[64];
+    const Audio_Stats *audio_stats = audio_GetStats(&g_audio);
+    uint32_t bin_us = (uint32_t)((uint64_t)AUDIO_SLACK_BIN_SAMPLES * 1000000 / AUDIO_SAMPLE_RATE);
+    int32_t slack_min_us = (int32_t)((int64_t)audio_stats->slack_min * 1000000 / AUDIO_SAMPLE_RATE);
+    
+    SSD1306_Clear(&g_display);
+    SSD1306_SetCursor(&g_display, 0, 0);
+    snprintf(buf, sizeof(buf), "AUDIO U:%lu Min:%ldms",
+             (unsigned long)audio_stats->underrun_count, (long)(slack_min_us / 1000));
+    SSD1306_WriteString(&g_display, buf, &Font_5x7, SSD1306_COLOR_WHITE);
+    
+    // Histogram, labelled by each bin's upper edge in ms
+    for (uint32_t i = 0; i < AUDIO_SLACK_BINS; i += 2) {
+        SSD1306_SetCursor(&g_display, 0, (uint8_t)(12 + (i / 2) * 10));
+        snprintf(buf, sizeof(buf), "<%lu:%lu <%lu:%lu",
+                 (unsigned long)((i + 1) * bin_us / 1000),
+                 (unsigned long)audio_stats->slack_hist[i],
+                 (unsigned long)((i + 2) * bin_us / 1000),
+                 (unsigned long)audio_stats->slack_hist[i + 1]);
+        SSD1306_WriteString(&g_display, buf, &Font_5x7, SSD1306_COLOR_WHITE);
+    }
+    
+    // PCM conversion cost (0.0 for ADPCM tracks)
+    uint32_t cost = Media_GetConvertCost(&g_media);
+    SSD1306_SetCursor(&g_display, 0, 54);
+    snprintf(buf, sizeof(buf), "Cvt:%lu.%lu cyc/smp",
+             (unsigned long)(cost / 10), (unsigned long)(cost % 10));
+    SSD1306_WriteString(&g_display, buf, &Font_5x7, SSD1306_COLOR_WHITE);
+    
+    SSD1306_UpdateScreen(&g_display);
+}
+
+/**
+ * @brief Show display bus usage: bytes on the wire per frame and I2C idle time
+ * 
+ * Idle is the share of playback with no window on the bus (address
+ * commands through data complete), i.e. what partial updates leave free.
+ * Over counts transfers that took longer than one frame period (the frame
+ * budget, 16.7 ms at 60 fps); max is the longest.
+ * CPU is the main loop's UpdateDisplay() time per frame started, mean and
+ * worst case (interrupts taken meanwhile included).
+ */
+static void ShowDisplayStats(uint32_t playback_ms) {
+    char buf[64];
+    const SSD1306_Stats *st = SSD1306_GetStats(&g_display);
+    const AVSync_Stats *sync_stats = AVSync_GetStats(&g_avsync);
+    uint32_t frames = st->frames + st->unchanged_frames;
+    uint32_t bytes_per_frame = frames ? st->wire_bytes / frames : 0;
+    uint32_t windows_x10 = st->frames ? st->windows * 10 / st->frames : 0;
+    uint64_t playback_cycles = (uint64_t)playback_ms * PERF_CPU_FREQ_KHZ;
+    uint32_t busy_pct = playback_cycles ? (uint32_t)(st->bus_cycles * 100 / playback_cycles) : 0;
+    if (busy_pct > 100) busy_pct = 100;
+    
+    SSD1306_Clear(&g_display);
+    SSD1306_SetCursor(&g_display, 0, 0);
+    snprintf(buf, sizeof(buf), "DISPLAY %lu frames", (unsigned long)frames);
+    SSD1306_WriteString(&g_display, buf, &Font_5x7, SSD1306_COLOR_WHITE);
+    
+    SSD1306_SetCursor(&g_display, 0, 12);
+    snprintf(buf, sizeof(buf), "Wire:%luB/frame", (unsigned long)bytes_per_frame);
+    SSD1306_WriteString(&g_display, buf, &Font_5x7, SSD1306_COLOR_WHITE);
+    
+    SSD1306_SetCursor(&g_display, 0, 22);
+    snprintf(buf, sizeof(buf), "Win:%lu.%lu Full:%lu",
+             (unsigned long)(windows_x10 / 10), (unsigned long)(windows_x10 % 10),
+             (unsigned long)st->full_frames);
+    SSD1306_WriteString(&g_display, buf, &Font_5x7, SSD1306_COLOR_WHITE);
+    
+    SSD1306_SetCursor(&g_display, 0, 32);
+    snprintf(buf, sizeof(buf), "Same:%lu Over:%lu", (unsigned long)st->unchanged_frames,
+             (unsigned long)sync_stats->frames_over_budget);
+    SSD1306_WriteString(&g_display, buf, &Font_5x7, SSD1306_COLOR_WHITE);
+    
+    SSD1306_SetCursor(&g_display, 0, 42);
+    snprintf(buf, sizeof(buf), "I2C idle:%lu%% max:%lums", (unsigned long)(100 - busy_pct),
+             (unsigned long)(sync_stats->present_latency_max * 1000 / g_avsync.audio_sample_rate));
+    SSD1306_WriteString(&g_display, buf, &Font_5x7, SSD1306_COLOR_WHITE);
+    
+    SSD1306_SetCursor(&g_display, 0, 52);
+    uint32_t cpu_mean = g_display_cpu_frames ?
+        (uint32_t)(g_display_cpu_cycles / g_display_cpu_frames) : 0;
+    snprintf(buf, sizeof(buf), "CPU:%luus max:%luus",
+             (unsigned long)Perf_CyclesToMicros(cpu_mean),
+             (unsigned long)Perf_CyclesToMicros(g_display_cpu_max));
+    SSD1306_WriteString(&g_display, buf, &Font_5x7, SSD1306_COLOR_WHITE);
+    
+    SSD1306_UpdateScreen(&g_display);
 }
 
 /* ========================== Main ========================== */
@@ -254,7 +548,7 @@ int main(void) {
         while(1);
     }
     
-    // Open media file (reads header, checks contiguity)
+    // Open media file (reads header, maps extents with a bulk FAT scan)
     if (Media_Open(&g_media, &g_volume, &file_info) != FAT_OK) {
         SSD1306_SetCursor(&g_display, 0, 30);
         SSD1306_WriteString(&g_display, "OPEN FAIL", &Font_5x7, SSD1306_COLOR_WHITE);
@@ -268,62 +562,86 @@ int main(void) {
     // Show file info
     SSD1306_Clear(&g_display);
     SSD1306_SetCursor(&g_display, 0, 0);
-    snprintf(buf, sizeof(buf), "%lu frames", (unsigned long)g_media.frame_count);
+    uint32_t fps_x100 = (uint32_t)(((uint64_t)g_media.fps_num * 100) / g_media.fps_den);
+    snprintf(buf, sizeof(buf), "%lu frames %lu.%02lufps", (unsigned long)g_media.frame_count,
+             (unsigned long)(fps_x100 / 100), (unsigned long)(fps_x100 % 100));
     SSD1306_WriteString(&g_display, buf, &Font_5x7, SSD1306_COLOR_WHITE);
     
     SSD1306_SetCursor(&g_display, 0, 10);
-    snprintf(buf, sizeof(buf), "%luHz %luch", 
+    snprintf(buf, sizeof(buf), "%luHz %luch %s", 
              (unsigned long)g_media.sample_rate, 
-             (unsigned long)g_media.channels);
+             (unsigned long)g_media.channels,
+             Media_IsAdpcmAudio(&g_media) ? "ADPCM" : "PCM");
     SSD1306_WriteString(&g_display, buf, &Font_5x7, SSD1306_COLOR_WHITE);
     
     SSD1306_SetCursor(&g_display, 0, 20);
-    uint32_t duration = Media_GetDurationSeconds(&g_media, VIDEO_FPS);
+    uint32_t duration = Media_GetDurationSeconds(&g_media);
     snprintf(buf, sizeof(buf), "Duration: %lu:%02lu", 
              (unsigned long)(duration / 60), 
              (unsigned long)(duration % 60));
     SSD1306_WriteString(&g_display, buf, &Font_5x7, SSD1306_COLOR_WHITE);
     
     SSD1306_SetCursor(&g_display, 0, 30);
-    SSD1306_WriteString(&g_display, 
-                        Media_IsContiguous(&g_media) ? "CONTIGUOUS" : "FRAGMENTED", 
-                        &Font_5x7, SSD1306_COLOR_WHITE);
+    if (Media_IsContiguous(&g_media)) {
+        snprintf(buf, sizeof(buf), "CONTIGUOUS v%lu %s",
+                 (unsigned long)g_media.format_version,
+                 Media_IsDeltaVideo(&g_media) ? "DLT" : "RAW");
+    } else {
+        snprintf(buf, sizeof(buf), "FRAG %luext v%lu %s",
+                 (unsigned long)Media_GetExtentCount(&g_media),
+                 (unsigned long)g_media.format_version,
+                 Media_IsDeltaVideo(&g_media) ? "DLT" : "RAW");
+    }
+    SSD1306_WriteString(&g_display, buf, &Font_5x7, SSD1306_COLOR_WHITE);
     
-    SSD1306_SetCursor(&g_display, 0, 45);
+    SSD1306_SetCursor(&g_display, 0, 40);
+    snprintf(buf, sizeof(buf), "FAT scan %luus %lus",
+             (unsigned long)g_media.scan_time_us,
+             (unsigned long)g_media.scan_fat_sectors);
+    SSD1306_WriteString(&g_display, buf, &Font_5x7, SSD1306_COLOR_WHITE);
+    
+    SSD1306_SetCursor(&g_display, 0, 52);
     SSD1306_WriteString(&g_display, "Starting...", &Font_5x7, SSD1306_COLOR_WHITE);
     SSD1306_UpdateScreen(&g_display);
     HAL_Delay(2000);
     
     // Initialize A/V sync (audio-master, 2-frame drift threshold)
-    AVSync_Init(&g_avsync, g_media.sample_rate, VIDEO_FPS, 0);
+    AVSync_InitRational(&g_avsync, g_media.sample_rate, g_media.fps_num, g_media.fps_den, 0);
     
     // Initialize audio driver
     audio_Init(&g_audio, &hdac1, &htim6);
     audio_SetAVSync(&g_audio, &g_avsync);
+    SSD1306_SetTransferHook(&g_display, OnDisplayTransferDone, NULL);
     
-    // Pre-fill both audio buffer halves
-    uint16_t *left_base = audio_GetLeftBuffer(&g_audio);
-    uint16_t *right_base = audio_GetRightBuffer(&g_audio);
-    if (left_base && right_base) {
-        // Fill first half
-        Media_ReadAudioStereo(&g_media, left_base, right_base, AUDIO_HALF_BUFFER_SAMPLES);
-        // Fill second half
-        Media_ReadAudioStereo(&g_media, 
-                              left_base + AUDIO_HALF_BUFFER_SAMPLES, 
-                              right_base + AUDIO_HALF_BUFFER_SAMPLES, 
-                              AUDIO_HALF_BUFFER_SAMPLES);
+    // SD reads go through the deadline scheduler (refills before frames)
+    IOSched_Init(&g_iosched, &g_media, &g_audio, &g_avsync);
+    IOSched_SetHandlers(&g_iosched, FillAudioSegment, OnFrameRead, NULL);
+    audio_SetRefillHook(&g_audio, OnAudioRefillDue, NULL);
+    
+    // Live overlay, composited into each frame as it is read
+    OSD_Init(&g_osd, &g_avsync, &g_audio, g_media.frame_count);
+    OSD_SetEnabled(&g_osd, OSD_SHOW_AT_START);
+    
+    // Pre-fill every audio ring segment
+    for (uint32_t i = 0; i < AUDIO_SEGMENT_COUNT; i++) {
+        if (!FillAudioSegment(NULL, i * AUDIO_SEGMENT_SAMPLES)) break;
     }
     
     // Pre-render first video frame
     RenderVideoFrame(0);
     
     // Start playback
+    g_sd_cmds_at_start = SD_GetStats(&g_sd)->commands;
+    g_playback_start_ms = HAL_GetTick();
+    AVSync_SetRenderAhead(&g_avsync, RENDER_AHEAD_FRAMES);
     AVSync_Start(&g_avsync);
+    AVSync_FrameRendered(&g_avsync);
+    g_frames_rendered++;
     audio_Start(&g_audio);
     
     /* ========================== Main Playback Loop ========================== */
     
-    uint32_t last_frame = 0xFFFFFFFF;
+    uint32_t next_frame = 1;        // Next frame to decode (frames go in order)
     uint32_t frame_count = g_media.frame_count;
     bool playback_complete = false;
     
@@ -343,18 +661,25 @@ int main(void) {
         
         switch (decision) {
             case AVSYNC_RENDER_FRAME: {
-                uint32_t current_frame = AVSync_GetCurrentFrame(&g_avsync);
-                if (current_frame != last_frame && current_frame < frame_count) {
-                    RenderVideoFrame(current_frame);
-                    AVSync_FrameRendered(&g_avsync);
-                    g_frames_rendered++;
-                    last_frame = current_frame;
-                }
+                // Frame due when its transfer lands (UpdateDisplay holds it until then)
+                uint32_t present_frame = AVSync_GetPresentFrame(&g_avsync);
+                if (next_frame >= frame_count) break;
+                
+                // Decode ahead of the clock only while audio has slack
+                bool ahead = next_frame > present_frame;
+                if (ahead && !AudioHasSlack()) break;
+                
+                if (!RenderVideoFrame(next_frame)) break;    // Queue full
+                AVSync_FrameRendered(&g_avsync);
+                g_frames_rendered++;
+                if (ahead) g_frames_ahead++;
+                next_frame++;
                 break;
             }
             
             case AVSYNC_SKIP_FRAME:
                 AVSync_FrameSkipped(&g_avsync);
+                next_frame++;
                 // Skip count tracked in avsync stats
                 break;
                 
@@ -374,6 +699,8 @@ int main(void) {
         // Refill audio again (do it often to avoid underruns)
         RefillAudioBuffers();
         
+        PollOverlayButton();
+        
         // LED heartbeat
         static uint32_t led_timer = 0;
         if (HAL_GetTick() - led_timer > 500) {
@@ -386,6 +713,11 @@ int main(void) {
     
     audio_Stop(&g_audio);
     AVSync_Stop(&g_avsync);
+    
+    uint32_t playback_ms = HAL_GetTick() - g_playback_start_ms;
+    uint32_t sd_cmds = SD_GetStats(&g_sd)->commands - g_sd_cmds_at_start;
+    uint32_t sd_cmds_per_sec = playback_ms ? (uint32_t)((uint64_t)sd_cmds * 1000 / playback_ms) : 0;
+    
     Media_Close(&g_media);
     
     // Wait for display DMA to finish
@@ -393,45 +725,25 @@ int main(void) {
         HAL_Delay(1);
     }
     
-    // Get statistics from modules
-    const AVSync_Stats *sync_stats = AVSync_GetStats(&g_avsync);
-    const Audio_Stats *audio_stats = audio_GetStats(&g_audio);
-    
-    // Show statistics
-    SSD1306_Clear(&g_display);
-    SSD1306_SetCursor(&g_display, 0, 0);
-    SSD1306_WriteString(&g_display, "COMPLETE!", &Font_5x7, SSD1306_COLOR_WHITE);
-    
-    SSD1306_SetCursor(&g_display, 0, 12);
-    snprintf(buf, sizeof(buf), "Rendered:%lu", (unsigned long)g_frames_rendered);
-    SSD1306_WriteString(&g_display, buf, &Font_5x7, SSD1306_COLOR_WHITE);
-    
-    SSD1306_SetCursor(&g_display, 0, 22);
-    snprintf(buf, sizeof(buf), "Skip:%lu Rep:%lu", 
-             (unsigned long)(sync_stats ? sync_stats->frames_skipped : 0),
-             (unsigned long)g_frames_repeated);
-    SSD1306_WriteString(&g_display, buf, &Font_5x7, SSD1306_COLOR_WHITE);
-    
-    SSD1306_SetCursor(&g_display, 0, 32);
-    snprintf(buf, sizeof(buf), "Refills:%lu", 
-             (unsigned long)(audio_stats ? audio_stats->refill_count : 0));
-    SSD1306_WriteString(&g_display, buf, &Font_5x7, SSD1306_COLOR_WHITE);
-    
-    SSD1306_SetCursor(&g_display, 0, 42);
-    snprintf(buf, sizeof(buf), "Max fill:%luus", (unsigned long)g_max_audio_fill_us);
-    SSD1306_WriteString(&g_display, buf, &Font_5x7, SSD1306_COLOR_WHITE);
-    
-    SSD1306_SetCursor(&g_display, 0, 52);
-    snprintf(buf, sizeof(buf), "Underruns:%lu", 
-             (unsigned long)(audio_stats ? audio_stats->underrun_count : 0));
-    SSD1306_WriteString(&g_display, buf, &Font_5x7, SSD1306_COLOR_WHITE);
-    
-    SSD1306_UpdateScreen(&g_display);
-    
-    // Idle loop
+    // Cycle through the statistics pages until reset
+    uint32_t page = 0;
     while (1) {
-        HAL_GPIO_TogglePin(LED_GPIO_Port, LED_Pin);
-        HAL_Delay(1000);
+        switch (page++ % 3) {
+            case 0:
+                ShowPlaybackStats(sd_cmds_per_sec);
+                break;
+            case 1:
+                ShowAudioHealth();
+                break;
+            default:
+                ShowDisplayStats(playback_ms);
+                break;
+        }
+        
+        for (uint32_t i = 0; i < STATS_PAGE_MS / 1000; i++) {
+            HAL_GPIO_TogglePin(LED_GPIO_Port, LED_Pin);
+            HAL_Delay(1000);
+        }
     }
 }
 
@@ -443,9 +755,9 @@ int main(void) {
 void SystemClock_Config(void) {
     RCC_OscInitTypeDef RCC_OscInitStruct = {0};
     RCC_ClkInitTypeDef RCC_ClkInitStruct = {0};
-
+    
     HAL_PWREx_ControlVoltageScaling(PWR_REGULATOR_VOLTAGE_SCALE1);
-
+    
     RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_MSI;
     RCC_OscInitStruct.MSIState = RCC_MSI_ON;
     RCC_OscInitStruct.MSICalibrationValue = 0;
@@ -458,7 +770,7 @@ void SystemClock_Config(void) {
     RCC_OscInitStruct.PLL.PLLQ = RCC_PLLQ_DIV2;
     RCC_OscInitStruct.PLL.PLLR = RCC_PLLR_DIV2;
     HAL_RCC_OscConfig(&RCC_OscInitStruct);
-
+    
     RCC_ClkInitStruct.ClockType = RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_SYSCLK
                                 | RCC_CLOCKTYPE_PCLK1 | RCC_CLOCKTYPE_PCLK2;
     RCC_ClkInitStruct.SYSCLKSource = RCC_SYSCLKSOURCE_PLLCLK;
@@ -472,11 +784,11 @@ void SystemClock_Config(void) {
 
 static void MX_GPIO_Init(void) {
     GPIO_InitTypeDef GPIO_InitStruct = {0};
-
+    
     __HAL_RCC_GPIOA_CLK_ENABLE();
     __HAL_RCC_GPIOB_CLK_ENABLE();
     __HAL_RCC_GPIOC_CLK_ENABLE();
-
+    
     // LED
     HAL_GPIO_WritePin(LED_GPIO_Port, LED_Pin, GPIO_PIN_RESET);
     GPIO_InitStruct.Pin = LED_Pin;
@@ -484,7 +796,7 @@ static void MX_GPIO_Init(void) {
     GPIO_InitStruct.Pull = GPIO_NOPULL;
     GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
     HAL_GPIO_Init(LED_GPIO_Port, &GPIO_InitStruct);
-
+    
     // SD CS
     HAL_GPIO_WritePin(SD_CS_GPIO_Port, SD_CS_Pin, GPIO_PIN_SET);
     GPIO_InitStruct.Pin = SD_CS_Pin;
@@ -492,19 +804,45 @@ static void MX_GPIO_Init(void) {
     GPIO_InitStruct.Pull = GPIO_NOPULL;
     GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
     HAL_GPIO_Init(SD_CS_GPIO_Port, &GPIO_InitStruct);
+    
+    // User button B1 (overlay toggle)
+    GPIO_InitStruct.Pin = B1_Pin;
+    GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    HAL_GPIO_Init(B1_GPIO_Port, &GPIO_InitStruct);
 }
 
 /* ========================== DMA Init ========================== */
 
+/**
+ * @brief Enable DMA clocks and set the interrupt priority layout
+ * 
+ * Preemption priorities (NVIC group 4, 0 = most urgent):
+ *   0  DAC DMA, TIM6/DAC  - half/full-ring ISRs; timestamp and pend the refill
+ *   0  I2C2 EV/ER         - display transfer completion, starts the next
+ *                           chained transfer (set in HAL_I2C_MspInit())
+ *   3  I2C2 DMA           - DMA channel housekeeping; completion is reported
+ *                           through I2C2 EV
+ *   5  SPI3 DMA           - SD block completion (a refill waits on these)
+ *   14 SysTick            - HAL tick (TICK_INT_PRIORITY)
+ *   15 PendSV             - audio refill (IO_SCHED_REFILL_IRQ)
+ * 
+ * The refill must sit below SPI3 because its SD reads complete through
+ * the SPI3 DMA interrupt, and below SysTick because the SD driver's polled
+ * byte transfers (HAL_SPI_TransmitReceive()) time out on HAL_GetTick().
+ * At equal priority the tick would stop for the whole refill.
+ */
 static void MX_DMA_Init(void) {
     __HAL_RCC_DMA2_CLK_ENABLE();
     __HAL_RCC_DMA1_CLK_ENABLE();
-
+    
     // DAC DMA - highest priority
     HAL_NVIC_SetPriority(DMA1_Channel3_IRQn, 0, 0);  // DAC Ch1
     HAL_NVIC_EnableIRQ(DMA1_Channel3_IRQn);
+#if !AUDIO_DAC_PACKED
     HAL_NVIC_SetPriority(DMA2_Channel5_IRQn, 0, 0);  // DAC Ch2
     HAL_NVIC_EnableIRQ(DMA2_Channel5_IRQn);
+#endif
     
     // I2C2 DMA - medium priority
     HAL_NVIC_SetPriority(DMA1_Channel4_IRQn, 3, 0);  // I2C2 TX
@@ -521,13 +859,20 @@ static void MX_DMA_Init(void) {
     // TIM6/DAC IRQ
     HAL_NVIC_SetPriority(TIM6_DAC_IRQn, 0, 0);
     HAL_NVIC_EnableIRQ(TIM6_DAC_IRQn);
+    
+    // Audio refill (PendSV) - lowest, preempts only the main loop
+    HAL_NVIC_SetPriority(PendSV_IRQn, 15, 0);
 }
 
 /* ========================== I2C2 Init ========================== */
 
 static void MX_I2C2_Init(void) {
     hi2c2.Instance = I2C2;
+#if DISPLAY_I2C_FAST_MODE_PLUS
+    hi2c2.Init.Timing = 0x00D00E28;  // 1MHz Fast-mode Plus (80MHz PCLK1, 120ns rise, 25ns fall)
+#else
     hi2c2.Init.Timing = 0x00B10E9C;  // 400kHz Fast Mode
+#endif
     hi2c2.Init.OwnAddress1 = 0;
     hi2c2.Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;
     hi2c2.Init.DualAddressMode = I2C_DUALADDRESS_DISABLE;
@@ -538,7 +883,9 @@ static void MX_I2C2_Init(void) {
     HAL_I2C_Init(&hi2c2);
     HAL_I2CEx_ConfigAnalogFilter(&hi2c2, I2C_ANALOGFILTER_ENABLE);
     HAL_I2CEx_ConfigDigitalFilter(&hi2c2, 0);
-    HAL_I2CEx_EnableFastModePlus(I2C_FASTMODEPLUS_I2C2);
+#if DISPLAY_I2C_FAST_MODE_PLUS
+    HAL_I2CEx_EnableFastModePlus(I2C_FASTMODEPLUS_I2C2);    // 20mA drive on SCL/SDA
+#endif
 }
 
 /* ========================== SPI3 Init ========================== */
@@ -7,23 +7,66 @@
 
 #include "media_file_reader.h"
 #include "sd_card.h"
+#include "perf.h"
 #include <string.h>
 
 /* ========================== Private Constants ========================== */
 
 // Maximum samples per read (matches audio buffer size)
-#define MAX_AUDIO_READ_SAMPLES  AUDIO_BUFFER_SAMPLES
+#define MAX_AUDIO_READ_SAMPLES  AUDIO_SEGMENT_SAMPLES
+
+// ADPCM blocks one read can span: the segment, plus a block it starts
+// partway into
+#define MAX_AUDIO_READ_BLOCKS   ((MAX_AUDIO_READ_SAMPLES + MEDIA_ADPCM_BLOCK_SAMPLES - 1) / \
+                                 MEDIA_ADPCM_BLOCK_SAMPLES + 1)
+
+// Bulk audio buffer: stereo 16-bit PCM, or the ADPCM blocks of one read
+#define PCM_READ_BYTES          (MAX_AUDIO_READ_SAMPLES * 4)
+#define ADPCM_READ_BYTES        (MAX_AUDIO_READ_BLOCKS * MEDIA_ADPCM_BLOCK_SIZE)
+#define AUDIO_READ_BYTES        ((PCM_READ_BYTES > ADPCM_READ_BYTES) ? PCM_READ_BYTES : ADPCM_READ_BYTES)
 
 // DAC midpoint for silence (12-bit)
 #define DAC_SILENCE             2048
 
-// Multi-block read limit
-#define MAX_MULTIBLOCK_COUNT    16
+// Raw stereo PCM samples per SD sector
+#define PCM_SECTOR_SAMPLES      (SD_BLOCK_SIZE / 4)
+
+// Samples converted between SD_AsyncPoll() calls while a batch is in flight
+#define PCM_POLL_SAMPLES        32
 
 /* ========================== Private Data ========================== */
 
 // Static buffer for bulk audio reads (stereo interleaved)
-static int16_t s_audio_buffer[MAX_AUDIO_READ_SAMPLES * 2] __attribute__((aligned(4)));
+static int16_t s_audio_buffer[AUDIO_READ_BYTES / 2] __attribute__((aligned(4)));
+
+_Static_assert(ADPCM_READ_BYTES <= sizeof(s_audio_buffer),
+               "ADPCM refill can overrun s_audio_buffer");
+
+#if MEDIA_CHUNK_STAGING
+// Interleaved: frames of the most recently read chunks
+static uint8_t s_chunk_frames[MEDIA_CHUNK_SLOTS][MEDIA_CHUNK_MAX_FRAMES][MEDIA_FRAME_SIZE]
+    __attribute__((aligned(4)));
+#endif
+
+// ADPCM: block whose tail the next refill continues from
+static uint8_t s_adpcm_tail[MEDIA_ADPCM_BLOCK_SIZE] __attribute__((aligned(4)));
+
+// IMA ADPCM step sizes
+static const int16_t s_ima_step[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
+    34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143,
+    157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+    724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
+    3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+// IMA ADPCM step index adjustment (by nibble magnitude)
+static const int8_t s_ima_index[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+// Delta video: reference frame and record read window
+static uint8_t s_delta_ref[MEDIA_FRAME_SIZE] __attribute__((aligned(4)));
+static uint8_t s_delta_window[MEDIA_DELTA_WINDOW_SIZE] __attribute__((aligned(4)));
 
 /* ========================== Private Helpers ========================== */
 
@@ -37,6 +80,118 @@ static inline uint32_t Read32LE(const uint8_t *buf) {
            ((uint32_t)buf[3] << 24);
 }
 
+/**
+ * @brief Parse v2 or v3 header from the file's first sector
+ */
+static FAT_Status Media_ParseHeader(MediaFile *media, const uint8_t *sector) {
+    if (Read32LE(&sector[0]) != MEDIA_V3_MAGIC) {
+        // v2: 20-byte header, regions packed directly after it
+        media->format_version = 2;
+        media->frame_count = Read32LE(&sector[0]);
+        media->audio_size = Read32LE(&sector[4]);
+        media->sample_rate = Read32LE(&sector[8]);
+        media->channels = Read32LE(&sector[12]);
+        media->bits_per_sample = Read32LE(&sector[16]);
+        
+        media->video_offset = MEDIA_HEADER_SIZE;
+        media->audio_offset = MEDIA_HEADER_SIZE + (media->frame_count * MEDIA_FRAME_SIZE);
+        media->audio_samples = media->audio_size / 4;
+        media->fps_num = MEDIA_DEFAULT_FPS;
+        media->fps_den = 1;
+        return FAT_OK;
+    }
+    
+    // v3: sector-sized header with explicit region offsets
+    uint32_t version = Read32LE(&sector[4]);
+    uint32_t header_size = Read32LE(&sector[8]);
+    if (version != 3 || header_size < MEDIA_V3_MIN_HEADER || header_size > SD_BLOCK_SIZE) {
+        return FAT_ERROR;
+    }
+    
+    media->format_version = 3;
+    media->frame_count = Read32LE(&sector[12]);
+    media->audio_size = Read32LE(&sector[16]);
+    media->sample_rate = Read32LE(&sector[20]);
+    media->channels = Read32LE(&sector[24]);
+    media->bits_per_sample = Read32LE(&sector[28]);
+    media->video_offset = Read32LE(&sector[32]);
+    media->audio_offset = Read32LE(&sector[36]);
+    
+    // Regions must not overlap the header
+    if (media->video_offset < header_size || media->audio_offset < header_size) {
+        return FAT_ERROR;
+    }
+    
+    // Codec fields (zero in files written before they existed = raw)
+    media->video_codec = Read32LE(&sector[40]);
+    media->video_size = Read32LE(&sector[44]);
+    media->keyframe_interval = Read32LE(&sector[48]);
+    media->keyframe_count = Read32LE(&sector[52]);
+    media->keyframe_table_offset = Read32LE(&sector[56]);
+    
+    if (media->video_codec == MEDIA_CODEC_DELTA) {
+        // Every frame must be reachable from a keyframe in the table
+        if (media->keyframe_interval == 0 || media->video_offset % SD_BLOCK_SIZE != 0 ||
+            (media->frame_count + media->keyframe_interval - 1) / media->keyframe_interval
+                > media->keyframe_count ||
+            media->keyframe_table_offset > media->file_size ||
+            media->keyframe_count > (media->file_size - media->keyframe_table_offset) / 4) {
+            return FAT_ERROR;
+        }
+    } else if (media->video_codec != MEDIA_CODEC_RAW) {
+        return FAT_ERROR;
+    }
+    
+    media->audio_codec = Read32LE(&sector[60]);
+    
+    if (media->audio_codec == MEDIA_AUDIO_ADPCM) {
+        // Stereo only; every sample's block must lie inside the region
+        media->audio_samples = Read32LE(&sector[64]);
+        uint32_t blocks = (media->audio_samples + MEDIA_ADPCM_BLOCK_SAMPLES - 1) /
+                          MEDIA_ADPCM_BLOCK_SAMPLES;
+        if (media->channels != 2 || media->audio_offset % SD_BLOCK_SIZE != 0 ||
+            blocks > media->audio_size / MEDIA_ADPCM_BLOCK_SIZE) {
+            return FAT_ERROR;
+        }
+    } else if (media->audio_codec == MEDIA_AUDIO_PCM) {
+        media->audio_samples = media->audio_size / 4;
+    } else {
+        return FAT_ERROR;
+    }
+    
+    media->layout = Read32LE(&sector[68]);
+    
+    if (media->layout == MEDIA_LAYOUT_INTERLEAVED) {
+        media->chunk_samples = Read32LE(&sector[72]);
+        media->chunk_fps = Read32LE(&sector[76]);
+        
+        // Raw + PCM only, chunks sector-aligned, frames fit a staging slot
+        if (media->video_codec != MEDIA_CODEC_RAW || media->audio_codec != MEDIA_AUDIO_PCM ||
+            media->chunk_samples == 0 || media->chunk_fps == 0 || media->sample_rate == 0 ||
+            (media->chunk_samples * 4) % SD_BLOCK_SIZE != 0 ||
+            media->video_offset % SD_BLOCK_SIZE != 0 ||
+            ((uint64_t)media->chunk_samples * media->chunk_fps + media->sample_rate - 1) /
+                media->sample_rate > MEDIA_CHUNK_MAX_FRAMES) {
+            return FAT_ERROR;
+        }
+    } else if (media->layout != MEDIA_LAYOUT_SEPARATE) {
+        return FAT_ERROR;
+    }
+    
+    // Rational frame rate (zero in files written before it existed = 30 fps)
+    media->fps_num = Read32LE(&sector[80]);
+    media->fps_den = Read32LE(&sector[84]);
+    
+    if (media->fps_num == 0) {
+        media->fps_num = MEDIA_DEFAULT_FPS;
+        media->fps_den = 1;
+    } else if (media->fps_den == 0) {
+        return FAT_ERROR;
+    }
+    
+    return FAT_OK;
+}
+
 /**
  * @brief Get cluster containing byte offset (with caching)
  */
@@ -87,6 +242,18 @@ static FAT_Status Media_ReadAtFragmented(MediaFile *media, uint32_t offset,
         sector += offset_in_cluster / SD_BLOCK_SIZE;
         uint32_t sector_offset = offset_in_cluster % SD_BLOCK_SIZE;
         
+        // Whole aligned sector - DMA straight into the caller's buffer
+        if (sector_offset == 0 && size >= SD_BLOCK_SIZE &&
+            media->file_size - offset >= SD_BLOCK_SIZE) {
+            if (SD_ReadBlock(media->vol->hsd, buffer, sector) != SD_OK) {
+                return FAT_ERROR_READ;
+            }
+            buffer += SD_BLOCK_SIZE;
+            offset += SD_BLOCK_SIZE;
+            size -= SD_BLOCK_SIZE;
+            continue;
+        }
+        
         if (SD_ReadBlock(media->vol->hsd, media->vol->sector_buffer, sector) != SD_OK) {
             return FAT_ERROR_READ;
         }
@@ -107,24 +274,107 @@ static FAT_Status Media_ReadAtFragmented(MediaFile *media, uint32_t offset,
 }
 
 /**
- * @brief Read data at arbitrary file offset (contiguous fast path)
+ * @brief Read consecutive sectors through the SD stream
+ * 
+ * Sequential reads continue the open CMD18 stream; anything else is a
+ * seek, which closes the stream and reopens it at the new sector.
  */
-static FAT_Status Media_ReadAtContiguous(MediaFile *media, uint32_t offset,
-                                          uint8_t *buffer, uint32_t size) {
+static FAT_Status Media_ReadSectors(MediaFile *media, uint32_t sector,
+                                     uint8_t *buffer, uint32_t count) {
+    SD_Handle *hsd = media->vol->hsd;
+    
+    if (SD_StreamOpen(hsd, sector) != SD_OK) {
+        return FAT_ERROR_READ;
+    }
+    if (SD_StreamRead(hsd, buffer, count) != SD_OK) {
+        return FAT_ERROR_READ;
+    }
+    
+    return FAT_OK;
+}
+
+/**
+ * @brief Find the extent containing a file cluster index (binary search)
+ * @return Extent, or NULL if the index lies past the mapped chain
+ */
+static const Media_Extent* Media_FindExtent(const MediaFile *media, uint32_t file_cluster) {
+    uint32_t lo = 0;
+    uint32_t hi = media->extent_count;
+    
+    // Find the last extent starting at or before file_cluster
+    while (hi - lo > 1) {
+        uint32_t mid = (lo + hi) / 2;
+        if (media->extents[mid].file_cluster <= file_cluster) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    
+    const Media_Extent *ext = &media->extents[lo];
+    if (media->extent_count == 0 || file_cluster - ext->file_cluster >= ext->length) {
+        return NULL;
+    }
+    return ext;
+}
+
+/**
+ * @brief Map [offset, offset + size) to a run of whole sectors in one extent
+ * @return First sector of the run, or 0 if the span is unaligned, crosses
+ *         an extent or passes the end of the file
+ */
+static uint32_t Media_SectorRun(MediaFile *media, uint32_t offset, uint32_t size) {
+    uint32_t cluster_size = FAT_GetClusterSize(media->vol);
+    
+    if (media->extent_count == 0 || cluster_size == 0 || size == 0) return 0;
+    if ((offset | size) % SD_BLOCK_SIZE != 0) return 0;
+    if (offset > media->file_size || size > media->file_size - offset) return 0;
+    
+    const Media_Extent *ext = Media_FindExtent(media, offset / cluster_size);
+    if (!ext) return 0;
+    
+    uint32_t offset_in_extent = offset - ext->file_cluster * cluster_size;
+    if (size > ext->length * cluster_size - offset_in_extent) return 0;
+    
+    return FAT_ClusterToSector(media->vol, ext->start_cluster) + offset_in_extent / SD_BLOCK_SIZE;
+}
+
+/**
+ * @brief Read data at arbitrary file offset through the extent map
+ * 
+ * Each pass reads as many whole sectors as both the request and the
+ * current extent allow, so a read only splits where the file does.
+ */
+static FAT_Status Media_ReadAtExtents(MediaFile *media, uint32_t offset,
+                                       uint8_t *buffer, uint32_t size) {
+    uint32_t cluster_size = FAT_GetClusterSize(media->vol);
+    if (cluster_size == 0) return FAT_ERROR;
+    
     while (size > 0 && offset < media->file_size) {
-        uint32_t sector = media->first_sector + (offset / SD_BLOCK_SIZE);
+        const Media_Extent *ext = Media_FindExtent(media, offset / cluster_size);
+        if (!ext) break;
+        
+        // Position within the extent and bytes left before it ends
+        uint32_t offset_in_extent = offset - ext->file_cluster * cluster_size;
+        uint32_t run_bytes = ext->length * cluster_size - offset_in_extent;
+        if (run_bytes > media->file_size - offset) {
+            run_bytes = media->file_size - offset;
+        }
+        
+        uint32_t sector = FAT_ClusterToSector(media->vol, ext->start_cluster) +
+                          offset_in_extent / SD_BLOCK_SIZE;
         uint32_t sector_offset = offset % SD_BLOCK_SIZE;
         
-        if (sector_offset != 0 || size < SD_BLOCK_SIZE) {
-            // Unaligned or partial sector - use scratch buffer
-            if (SD_ReadBlock(media->vol->hsd, media->vol->sector_buffer, sector) != SD_OK) {
+        if (sector_offset != 0 || size < SD_BLOCK_SIZE || run_bytes < SD_BLOCK_SIZE) {
+            // Unaligned, partial or last sector of the file - use scratch buffer
+            if (Media_ReadSectors(media, sector, media->vol->sector_buffer, 1) != FAT_OK) {
                 return FAT_ERROR_READ;
             }
             
             uint32_t available = SD_BLOCK_SIZE - sector_offset;
             uint32_t to_copy = (size < available) ? size : available;
-            if (offset + to_copy > media->file_size) {
-                to_copy = media->file_size - offset;
+            if (to_copy > run_bytes) {
+                to_copy = run_bytes;
             }
             
             memcpy(buffer, media->vol->sector_buffer + sector_offset, to_copy);
@@ -132,20 +382,13 @@ static FAT_Status Media_ReadAtContiguous(MediaFile *media, uint32_t offset,
             offset += to_copy;
             size -= to_copy;
         } else {
-            // Aligned sector(s) - read directly to buffer
-            uint32_t sectors_available = (media->file_size - offset) / SD_BLOCK_SIZE;
+            // Aligned sector(s) - stream directly to buffer, up to extent end
+            uint32_t sectors_available = run_bytes / SD_BLOCK_SIZE;
             uint32_t sectors_needed = size / SD_BLOCK_SIZE;
             uint32_t count = (sectors_needed < sectors_available) ? sectors_needed : sectors_available;
-            if (count > MAX_MULTIBLOCK_COUNT) count = MAX_MULTIBLOCK_COUNT;
             
-            if (count > 1) {
-                if (SD_ReadMultipleBlocks(media->vol->hsd, buffer, sector, count) != SD_OK) {
-                    return FAT_ERROR_READ;
-                }
-            } else {
-                if (SD_ReadBlock(media->vol->hsd, buffer, sector) != SD_OK) {
-                    return FAT_ERROR_READ;
-                }
+            if (Media_ReadSectors(media, sector, buffer, count) != FAT_OK) {
+                return FAT_ERROR_READ;
             }
             
             uint32_t bytes_read = count * SD_BLOCK_SIZE;
@@ -165,52 +408,583 @@ static FAT_Status Media_ReadAt(MediaFile *media, uint32_t offset,
                                 uint8_t *buffer, uint32_t size) {
     if (!media || !media->is_open || !buffer) return FAT_ERROR_INVALID_PARAM;
     
-    if (media->is_contiguous && media->first_sector != 0) {
-        return Media_ReadAtContiguous(media, offset, buffer, size);
+    if (media->extent_count > 0) {
+        return Media_ReadAtExtents(media, offset, buffer, size);
     } else {
         return Media_ReadAtFragmented(media, offset, buffer, size);
     }
 }
 
 /**
- * @brief Check if file is contiguous and enable fast path
+ * @brief FAT_ScanChain() callback - append one run to the extent map
+ * @return false (stop scanning) once the map is full
  */
-static bool Media_CheckContiguous(MediaFile *media) {
+static bool Media_AddExtentRun(void *ctx, uint32_t file_cluster,
+                               uint32_t start_cluster, uint32_t length) {
+    MediaFile *media = (MediaFile*)ctx;
+    
+    if (media->extent_count >= MEDIA_MAX_EXTENTS) {
+        media->extent_overflow = true;
+        return false;
+    }
+    
+    Media_Extent *ext = &media->extents[media->extent_count++];
+    ext->file_cluster = file_cluster;
+    ext->start_cluster = start_cluster;
+    ext->length = length;
+    return true;
+}
+
+/**
+ * @brief Map the cluster chain into extents and detect contiguous files
+ * 
+ * Uses the bulk FAT scanner (one multi-block read per FAT_SCAN_SECTORS
+ * sectors) and times it with the DWT counter. A single extent enables the
+ * contiguous fast path. If the file has more runs than MEDIA_MAX_EXTENTS
+ * the map is dropped and reads walk the chain.
+ */
+static bool Media_BuildExtents(MediaFile *media) {
     if (!media || !media->is_open || !media->vol) return false;
     
     FAT_Volume *vol = media->vol;
-    uint32_t cluster = media->first_cluster;
-    uint32_t prev = cluster;
-    uint32_t count = 0;
-    
     uint32_t cluster_size = FAT_GetClusterSize(vol);
     if (cluster_size == 0) return false;
     
     uint32_t expected_clusters = (media->file_size + cluster_size - 1) / cluster_size;
     
-    // Walk cluster chain, checking for gaps
-    while (!FAT_IsEndOfChain(cluster)) {
-        count++;
-        if (count > 1 && cluster != prev + 1) {
-            // Non-contiguous
-            media->is_contiguous = false;
-            media->first_sector = 0;
-            return false;
-        }
-        prev = cluster;
-        cluster = FAT_GetNextCluster(vol, cluster);
-        
-        // Safety limit
-        if (count > expected_clusters + 10) break;
+    media->extent_count = 0;
+    media->extent_overflow = false;
+    
+    FAT_ScanResult scan;
+    uint32_t start = Perf_GetCycles();
+    FAT_Status status = FAT_ScanChain(vol, media->first_cluster, expected_clusters,
+                                      Media_AddExtentRun, media, &scan);
+    media->scan_time_us = Perf_CyclesToMicros(Perf_GetCycles() - start);
+    media->scan_fat_sectors = scan.sectors_read;
+    
+    if (status != FAT_OK || media->extent_overflow) {
+        // Too fragmented to map (or FAT unreadable) - fall back to chain walking
+        media->extent_count = 0;
     }
     
-    // File is contiguous
-    media->is_contiguous = true;
-    media->first_sector = FAT_ClusterToSector(vol, media->first_cluster);
+    media->is_contiguous = (media->extent_count == 1);
+    media->first_sector = media->is_contiguous ? FAT_ClusterToSector(vol, media->first_cluster) : 0;
     media->cached_cluster = media->first_cluster;
     media->cached_cluster_index = 0;
     
-    return true;
+    return media->extent_count > 0;
+}
+
+/**
+ * @brief Make bytes [offset, offset + size) of the file available in the window
+ * @return Pointer into s_delta_window, or NULL on read error / past EOF
+ * 
+ * The window is refilled from the sector containing offset. Sectors already
+ * held are moved down rather than reread, so a sequential record stream
+ * keeps the SD stream sequential.
+ */
+static const uint8_t* Media_DeltaFetch(MediaFile *media, uint32_t offset, uint32_t size) {
+    uint32_t window_end = media->delta_window_offset + media->delta_window_len;
+    
+    if (offset >= media->delta_window_offset && offset + size <= window_end) {
+        return &s_delta_window[offset - media->delta_window_offset];
+    }
+    
+    if (offset + size > media->file_size) {
+        return NULL;
+    }
+    
+    // Keep any held sectors from the one containing offset onwards
+    uint32_t base = offset - (offset % SD_BLOCK_SIZE);
+    uint32_t keep = 0;
+    if (base >= media->delta_window_offset && base < window_end) {
+        keep = window_end - base;
+        memmove(s_delta_window, &s_delta_window[base - media->delta_window_offset], keep);
+    }
+    
+    uint32_t read_len = MEDIA_DELTA_WINDOW_SIZE - keep;
+    if (read_len > media->file_size - (base + keep)) {
+        read_len = media->file_size - (base + keep);
+    }
+    
+    media->delta_window_offset = base;
+    media->delta_window_len = keep;
+    
+    if (read_len > 0 &&
+        Media_ReadAt(media, base + keep, &s_delta_window[keep], read_len) != FAT_OK) {
+        media->delta_window_len = 0;
+        return NULL;
+    }
+    media->delta_window_len += read_len;
+    
+    if (offset + size > base + media->delta_window_len) {
+        return NULL;
+    }
+    return &s_delta_window[offset - base];
+}
+
+/**
+ * @brief Decode the record at delta_next_offset onto the reference frame
+ * @param require_keyframe Fail unless the record is a keyframe (after a seek)
+ */
+static FAT_Status Media_DeltaApplyNext(MediaFile *media, bool require_keyframe) {
+    const uint8_t *hdr = Media_DeltaFetch(media, media->delta_next_offset,
+                                          MEDIA_DELTA_RECORD_HEADER);
+    if (!hdr) return FAT_ERROR_READ;
+    
+    uint32_t length = (uint32_t)hdr[0] | ((uint32_t)hdr[1] << 8);
+    uint8_t flags = hdr[2];
+    
+    if (length > MEDIA_FRAME_SIZE ||
+        (require_keyframe && !(flags & MEDIA_DELTA_FLAG_KEYFRAME))) {
+        return FAT_ERROR;
+    }
+    
+    const uint8_t *p = Media_DeltaFetch(media, media->delta_next_offset + MEDIA_DELTA_RECORD_HEADER,
+                                        length);
+    if (!p) return FAT_ERROR_READ;
+    
+    if (flags & MEDIA_DELTA_FLAG_KEYFRAME) {
+        if (length != MEDIA_FRAME_SIZE) return FAT_ERROR;
+        memcpy(s_delta_ref, p, MEDIA_FRAME_SIZE);
+    } else {
+        // Tokens: [skip][len][len bytes XORed onto the reference]
+        const uint8_t *end = p + length;
+        uint32_t pos = 0;
+        
+        while (p + 2 <= end) {
+            uint32_t run = p[1];
+            pos += p[0];
+            p += 2;
+            
+            if (pos + run > MEDIA_FRAME_SIZE || p + run > end) return FAT_ERROR;
+            
+            for (uint32_t i = 0; i < run; i++) {
+                s_delta_ref[pos + i] ^= p[i];
+            }
+            pos += run;
+            p += run;
+        }
+    }
+    
+    media->delta_next_offset += MEDIA_DELTA_RECORD_HEADER + length;
+    media->delta_records++;
+    return FAT_OK;
+}
+
+/**
+ * @brief Rebuild a delta-coded frame in the reference frame and copy it out
+ */
+static FAT_Status Media_ReadFrameDelta(MediaFile *media, uint32_t frame_number, uint8_t *buffer) {
+    uint32_t keyframe = frame_number / media->keyframe_interval;
+    uint32_t keyframe_first = keyframe * media->keyframe_interval;
+    
+    // Continue from the reference unless that means going backwards or
+    // decoding through a keyframe we could jump to instead
+    bool can_continue = media->delta_ref_frame != MEDIA_NO_FRAME &&
+                        media->delta_ref_frame <= frame_number &&
+                        media->delta_ref_frame >= keyframe_first;
+    
+    if (!can_continue) {
+        // Look up the keyframe's record offset (4 bytes from the table)
+        uint8_t entry[4];
+        if (Media_ReadAt(media, media->keyframe_table_offset + keyframe * 4, entry, 4) != FAT_OK) {
+            return FAT_ERROR_READ;
+        }
+        
+        media->delta_ref_frame = MEDIA_NO_FRAME;
+        media->delta_next_offset = media->video_offset + Read32LE(entry);
+        media->delta_seeks++;
+        
+        if (Media_DeltaApplyNext(media, true) != FAT_OK) {
+            return FAT_ERROR;
+        }
+        media->delta_ref_frame = keyframe_first;
+    }
+    
+    // Fast-apply deltas up to the requested frame
+    while (media->delta_ref_frame < frame_number) {
+        if (Media_DeltaApplyNext(media, false) != FAT_OK) {
+            media->delta_ref_frame = MEDIA_NO_FRAME;
+            return FAT_ERROR;
+        }
+        media->delta_ref_frame++;
+    }
+    
+    memcpy(buffer, s_delta_ref, MEDIA_FRAME_SIZE);
+    return FAT_OK;
+}
+
+/**
+ * @brief Decode one IMA ADPCM nibble (standard shift-add reconstruction)
+ */
+static inline int32_t Media_AdpcmNibble(int32_t *predictor, int32_t *index, uint32_t nibble) {
+    int32_t step = s_ima_step[*index];
+    int32_t diff = step >> 3;
+    
+    if (nibble & 4) diff += step;
+    if (nibble & 2) diff += step >> 1;
+    if (nibble & 1) diff += step >> 2;
+    if (nibble & 8) diff = -diff;
+    
+    int32_t idx = *index + s_ima_index[nibble & 7];
+    *index = (idx < 0) ? 0 : ((idx > 88) ? 88 : idx);
+    *predictor = __SSAT(*predictor + diff, 16);
+    return *predictor;
+}
+
+/**
+ * @brief Decode samples [start, start + n) of one ADPCM block
+ * @param left   Left output (12-bit DAC), or NULL to only advance the state
+ * @param stride Output step in samples (1 split buffers, 2 packed words)
+ * @param gain   Volume in Q16 (65536 = 100%)
+ * 
+ * start == 0 loads the channel state from the block header; otherwise the
+ * state in media->adpcm must already be positioned at start.
+ */
+static void Media_AdpcmDecode(MediaFile *media, const uint8_t *block, uint32_t start,
+                              uint32_t n, uint16_t *left, uint16_t *right, uint32_t stride,
+                              int32_t gain) {
+    if (start == 0) {
+        for (int ch = 0; ch < 2; ch++) {
+            const uint8_t *h = &block[ch * 4];
+            media->adpcm[ch].predictor = (int16_t)(h[0] | (h[1] << 8));
+            media->adpcm[ch].index = (h[2] > 88) ? 88 : h[2];
+        }
+    }
+    
+    // Keep the state in registers for the inner loop
+    int32_t pred_l = media->adpcm[0].predictor;
+    int32_t index_l = media->adpcm[0].index;
+    int32_t pred_r = media->adpcm[1].predictor;
+    int32_t index_r = media->adpcm[1].index;
+    const uint8_t *p = &block[MEDIA_ADPCM_BLOCK_HEADER + start];
+    
+    if (left) {
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t byte = p[i];
+            int32_t l = Media_AdpcmNibble(&pred_l, &index_l, byte & 0x0F);
+            int32_t r = Media_AdpcmNibble(&pred_r, &index_r, byte >> 4);
+            
+            // Scale (Q16), then signed 16-bit -> unsigned 12-bit
+            left[i * stride] = (uint16_t)((((l * gain) >> 16) + 32768) >> 4);
+            right[i * stride] = (uint16_t)((((r * gain) >> 16) + 32768) >> 4);
+        }
+    } else {
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t byte = p[i];
+            Media_AdpcmNibble(&pred_l, &index_l, byte & 0x0F);
+            Media_AdpcmNibble(&pred_r, &index_r, byte >> 4);
+        }
+    }
+    
+    media->adpcm[0].predictor = pred_l;
+    media->adpcm[0].index = index_l;
+    media->adpcm[1].predictor = pred_r;
+    media->adpcm[1].index = index_r;
+}
+
+/**
+ * @brief Read and decode IMA ADPCM audio at current_sample
+ * 
+ * A refill that ends mid-block keeps that block in s_adpcm_tail so the
+ * next refill continues without rereading it; the remaining blocks come
+ * from one multi-block read that follows on sequentially.
+ */
+static FAT_Status Media_ReadAudioAdpcm(MediaFile *media, uint16_t *left, uint16_t *right,
+                                       uint32_t stride, uint32_t count) {
+    int32_t gain = media->gain_q16;
+    uint32_t block = media->current_sample / MEDIA_ADPCM_BLOCK_SAMPLES;
+    uint32_t pos = media->current_sample % MEDIA_ADPCM_BLOCK_SAMPLES;
+    uint32_t done = 0;
+    
+    // Continue the held block
+    if (pos != 0 && block == media->adpcm_block && pos == media->adpcm_pos) {
+        uint32_t n = MEDIA_ADPCM_BLOCK_SAMPLES - pos;
+        if (n > count) n = count;
+        
+        Media_AdpcmDecode(media, s_adpcm_tail, pos, n, left, right, stride, gain);
+        done = n;
+        pos += n;
+        media->adpcm_pos = pos;
+        
+        if (pos == MEDIA_ADPCM_BLOCK_SAMPLES) {
+            media->adpcm_block = MEDIA_NO_BLOCK;
+            block++;
+            pos = 0;
+        }
+    }
+    
+    if (done == count) {
+        return FAT_OK;
+    }
+    
+    // Remaining whole blocks in one read (reuses the PCM buffer)
+    uint32_t blocks = (pos + (count - done) + MEDIA_ADPCM_BLOCK_SAMPLES - 1) /
+                      MEDIA_ADPCM_BLOCK_SAMPLES;
+    uint8_t *p = (uint8_t*)s_audio_buffer;
+    
+    if (Media_ReadAt(media, media->audio_offset + block * MEDIA_ADPCM_BLOCK_SIZE,
+                     p, blocks * MEDIA_ADPCM_BLOCK_SIZE) != FAT_OK) {
+        media->adpcm_block = MEDIA_NO_BLOCK;
+        return FAT_ERROR_READ;
+    }
+    
+    media->adpcm_block = MEDIA_NO_BLOCK;
+    
+    for (uint32_t b = 0; b < blocks; b++, block++, p += MEDIA_ADPCM_BLOCK_SIZE) {
+        // After a seek, run the state up to the first wanted sample
+        if (pos != 0) {
+            Media_AdpcmDecode(media, p, 0, pos, NULL, NULL, 0, gain);
+        }
+        
+        uint32_t n = MEDIA_ADPCM_BLOCK_SAMPLES - pos;
+        if (n > count - done) n = count - done;
+        
+        Media_AdpcmDecode(media, p, pos, n, &left[done * stride], &right[done * stride],
+                          stride, gain);
+        done += n;
+        pos += n;
+        
+        if (pos < MEDIA_ADPCM_BLOCK_SAMPLES) {
+            // Partially consumed - hold it for the next refill
+            memcpy(s_adpcm_tail, p, MEDIA_ADPCM_BLOCK_SIZE);
+            media->adpcm_block = block;
+            media->adpcm_pos = pos;
+            break;
+        }
+        pos = 0;
+    }
+    
+    return FAT_OK;
+}
+
+/**
+ * @brief First frame of an interleaved chunk (F(i) in the header docs)
+ */
+static uint32_t Media_ChunkFirstFrame(const MediaFile *media, uint32_t chunk) {
+    uint64_t num = (uint64_t)chunk * media->chunk_samples * media->chunk_fps;
+    uint64_t frame = (num + media->sample_rate - 1) / media->sample_rate;
+    return (frame < media->frame_count) ? (uint32_t)frame : media->frame_count;
+}
+
+/**
+ * @brief File offset of an interleaved chunk
+ */
+static uint32_t Media_ChunkOffset(const MediaFile *media, uint32_t chunk) {
+    return media->video_offset + chunk * media->chunk_samples * 4 +
+           Media_ChunkFirstFrame(media, chunk) * MEDIA_FRAME_SIZE;
+}
+
+/**
+ * @brief Chunk holding a frame (largest i with F(i) <= frame)
+ */
+static uint32_t Media_ChunkOfFrame(const MediaFile *media, uint32_t frame) {
+    return (uint32_t)(((uint64_t)frame * media->sample_rate) /
+                      ((uint64_t)media->chunk_samples * media->chunk_fps));
+}
+
+/**
+ * @brief Forget all staged chunks
+ */
+static void Media_ClearStaging(MediaFile *media) {
+#if MEDIA_CHUNK_STAGING
+    for (int i = 0; i < MEDIA_CHUNK_SLOTS; i++) {
+        media->staged_chunk[i] = MEDIA_NO_BLOCK;
+    }
+#else
+    (void)media;
+#endif
+}
+
+/**
+ * @brief Check if a chunk's frames are held in its staging slot
+ */
+static bool Media_ChunkStaged(const MediaFile *media, uint32_t chunk) {
+#if MEDIA_CHUNK_STAGING
+    return media->staged_chunk[chunk % MEDIA_CHUNK_SLOTS] == chunk;
+#else
+    (void)media;
+    (void)chunk;
+    return false;
+#endif
+}
+
+#if MEDIA_CHUNK_STAGING
+/**
+ * @brief Read a chunk's frames into its staging slot
+ * 
+ * Called right after the chunk's audio, so the read continues the stream.
+ */
+static void Media_StageChunkFrames(MediaFile *media, uint32_t chunk) {
+    uint32_t slot = chunk % MEDIA_CHUNK_SLOTS;
+    uint32_t first = Media_ChunkFirstFrame(media, chunk);
+    uint32_t count = Media_ChunkFirstFrame(media, chunk + 1) - first;
+    
+    media->staged_chunk[slot] = MEDIA_NO_BLOCK;
+    
+    if (count > 0 &&
+        Media_ReadAt(media, Media_ChunkOffset(media, chunk) + media->chunk_samples * 4,
+                     s_chunk_frames[slot][0], count * MEDIA_FRAME_SIZE) != FAT_OK) {
+        return;
+    }
+    
+    media->staged_chunk[slot] = chunk;
+}
+#endif
+
+/**
+ * @brief Read an interleaved frame (from staging if its chunk was just read)
+ */
+static FAT_Status Media_ReadFrameInterleaved(MediaFile *media, uint32_t frame_number,
+                                             uint8_t *buffer) {
+    uint32_t chunk = Media_ChunkOfFrame(media, frame_number);
+    uint32_t index = frame_number - Media_ChunkFirstFrame(media, chunk);
+    
+#if MEDIA_CHUNK_STAGING
+    if (Media_ChunkStaged(media, chunk)) {
+        memcpy(buffer, s_chunk_frames[chunk % MEDIA_CHUNK_SLOTS][index], MEDIA_FRAME_SIZE);
+        media->staged_hits++;
+        return FAT_OK;
+    }
+#endif
+    
+    // Not staged (staging off, seek, or rendered after its chunk was recycled) - read in place
+    media->staged_misses++;
+    return Media_ReadAt(media, Media_ChunkOffset(media, chunk) + media->chunk_samples * 4 +
+                        index * MEDIA_FRAME_SIZE, buffer, MEDIA_FRAME_SIZE);
+}
+
+/**
+ * @brief Portable PCM kernel: deinterleave, Q16 volume, signed 16-bit to 12-bit DAC codes
+ */
+static inline void Media_ConvertPcmScalar(int32_t gain, const int16_t *pcm, uint16_t *left,
+                                          uint16_t *right, uint32_t stride, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        int32_t l_raw = pcm[i * 2];
+        int32_t r_raw = pcm[i * 2 + 1];
+        
+        // Scale (Q16), then signed 16-bit -> unsigned 12-bit
+        left[i * stride] = (uint16_t)((((l_raw * gain) >> 16) + 32768) >> 4);
+        right[i * stride] = (uint16_t)((((r_raw * gain) >> 16) + 32768) >> 4);
+    }
+}
+
+#if MEDIA_PCM_SIMD
+/**
+ * @brief SMULWB/SMULWT: (a * signed half of b) >> 16 (not in CMSIS)
+ * 
+ * Without the DSP extension (host tests) the same result is computed in C.
+ */
+static inline int32_t Media_SMULWB(int32_t a, uint32_t b) {
+#if defined(__ARM_FEATURE_DSP)
+    int32_t result;
+    __asm ("smulwb %0, %1, %2" : "=r" (result) : "r" (a), "r" (b));
+    return result;
+#else
+    return (int32_t)(((int64_t)a * (int16_t)b) >> 16);
+#endif
+}
+
+static inline int32_t Media_SMULWT(int32_t a, uint32_t b) {
+#if defined(__ARM_FEATURE_DSP)
+    int32_t result;
+    __asm ("smulwt %0, %1, %2" : "=r" (result) : "r" (a), "r" (b));
+    return result;
+#else
+    return (int32_t)(((int64_t)a * (int16_t)(b >> 16)) >> 16);
+#endif
+}
+
+/**
+ * @brief Scale one interleaved L|R PCM word and convert it to packed DAC codes
+ * @return Left in bits 0-11, right in bits 16-27
+ * 
+ * The gain is at most 1.0, so the scaled halves stay in 16 bits and need
+ * no saturation. XOR with 0x8000 is the +32768 offset on each half.
+ */
+static inline uint32_t Media_PcmToDac(int32_t gain, uint32_t pcm) {
+    uint32_t scaled = __PKHBT((uint32_t)Media_SMULWB(gain, pcm),
+                              (uint32_t)Media_SMULWT(gain, pcm), 16);
+    return ((scaled ^ 0x80008000) >> 4) & 0x0FFF0FFF;
+}
+
+/**
+ * @brief SIMD PCM kernel: a stereo pair per 32-bit load and, for packed output, per store
+ * @note  pcm must be word aligned; with stride 2, right must be left + 1
+ */
+static inline void Media_ConvertPcmSimd(int32_t gain, const int16_t *pcm, uint16_t *left,
+                                        uint16_t *right, uint32_t stride, uint32_t count) {
+    const uint32_t *in = (const uint32_t*)pcm;
+    
+    if (stride == 2) {
+        // left/right are the halves of the packed words
+        uint32_t *out = (uint32_t*)left;
+        for (uint32_t i = 0; i < count; i++) {
+            out[i] = Media_PcmToDac(gain, in[i]);
+        }
+    } else {
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t dac = Media_PcmToDac(gain, in[i]);
+            left[i] = (uint16_t)dac;
+            right[i] = (uint16_t)(dac >> 16);
+        }
+    }
+}
+#endif
+
+/**
+ * @brief Deinterleave PCM from s_audio_buffer, apply volume, convert to 12-bit
+ * 
+ * Q16 gain, the same arithmetic as the ADPCM decoder. Both kernels give
+ * identical output (tests/test_pcm_convert.c).
+ */
+static void Media_ConvertPcm(MediaFile *media, const int16_t *pcm,
+                             uint16_t *left, uint16_t *right, uint32_t stride, uint32_t count) {
+    uint32_t start = Perf_GetCycles();
+    
+#if MEDIA_PCM_SIMD
+    Media_ConvertPcmSimd(media->gain_q16, pcm, left, right, stride, count);
+#else
+    Media_ConvertPcmScalar(media->gain_q16, pcm, left, right, stride, count);
+#endif
+    
+    media->convert_cycles += Perf_GetCycles() - start;
+    media->convert_samples += count;
+}
+
+/**
+ * @brief Read interleaved PCM at current_sample, staging each completed chunk
+ */
+static FAT_Status Media_ReadAudioInterleaved(MediaFile *media, uint16_t *left, uint16_t *right,
+                                             uint32_t stride, uint32_t count) {
+    uint32_t done = 0;
+    
+    while (done < count) {
+        uint32_t sample = media->current_sample + done;
+        uint32_t chunk = sample / media->chunk_samples;
+        uint32_t within = sample % media->chunk_samples;
+        uint32_t n = media->chunk_samples - within;
+        if (n > count - done) n = count - done;
+        
+        if (Media_ReadAt(media, Media_ChunkOffset(media, chunk) + within * 4,
+                         (uint8_t*)s_audio_buffer, n * 4) != FAT_OK) {
+            return FAT_ERROR_READ;
+        }
+        
+        Media_ConvertPcm(media, s_audio_buffer, &left[done * stride], &right[done * stride],
+                         stride, n);
+        done += n;
+        
+#if MEDIA_CHUNK_STAGING
+        // Chunk's audio complete - its frames are next on the card
+        if (within + n == media->chunk_samples) {
+            Media_StageChunkFrames(media, chunk);
+        }
+#endif
+    }
+    
+    return FAT_OK;
 }
 
 /* ========================== Public API ========================== */
@@ -228,47 +1002,49 @@ FAT_Status Media_Open(MediaFile *media, FAT_Volume *vol, const FAT_FileInfo *fil
     media->first_cluster = file_info->first_cluster;
     media->file_size = file_info->size;
     
-    // Read header
-    uint8_t header[MEDIA_HEADER_SIZE];
+    // Read header sector (covers both v2 and v3 headers)
     uint32_t first_sector = FAT_ClusterToSector(vol, file_info->first_cluster);
     
     if (SD_ReadBlock(vol->hsd, vol->sector_buffer, first_sector) != SD_OK) {
         return FAT_ERROR_READ;
     }
-    memcpy(header, vol->sector_buffer, MEDIA_HEADER_SIZE);
-    
-    // Parse header
-    media->frame_count = Read32LE(&header[0]);
-    media->audio_size = Read32LE(&header[4]);
-    media->sample_rate = Read32LE(&header[8]);
-    media->channels = Read32LE(&header[12]);
-    media->bits_per_sample = Read32LE(&header[16]);
     
-    // Calculate offsets
-    media->video_offset = MEDIA_HEADER_SIZE;
-    media->audio_offset = MEDIA_HEADER_SIZE + (media->frame_count * MEDIA_FRAME_SIZE);
+    if (Media_ParseHeader(media, vol->sector_buffer) != FAT_OK) {
+        return FAT_ERROR;
+    }
     
     // Initialize playback state
+    media->delta_ref_frame = MEDIA_NO_FRAME;
+    media->adpcm_block = MEDIA_NO_BLOCK;
+    Media_ClearStaging(media);
     media->current_frame = 0;
     media->current_sample = 0;
-    media->volume_percent = MEDIA_DEFAULT_VOLUME;
+    Media_SetVolume(media, MEDIA_DEFAULT_VOLUME);
     
     // Mark as open
     media->is_open = true;
     
-    // Try to enable contiguous fast path
-    Media_CheckContiguous(media);
+    // Map the file's extents (enables the contiguous fast path if one run)
+    Media_BuildExtents(media);
     
     return FAT_OK;
 }
 
 void Media_Close(MediaFile *media) {
     if (media) {
+        if (media->vol && media->vol->hsd) {
+            SD_StreamClose(media->vol->hsd);
+        }
         media->is_open = false;
         media->current_frame = 0;
         media->current_sample = 0;
         media->cached_cluster = 0;
         media->cached_cluster_index = 0;
+        media->extent_count = 0;
+        media->delta_ref_frame = MEDIA_NO_FRAME;
+        media->delta_window_len = 0;
+        media->adpcm_block = MEDIA_NO_BLOCK;
+        Media_ClearStaging(media);
         media->is_contiguous = false;
         media->first_sector = 0;
     }
@@ -277,6 +1053,7 @@ void Media_Close(MediaFile *media) {
 void Media_SetVolume(MediaFile *media, uint8_t percent) {
     if (media) {
         media->volume_percent = (percent > 100) ? 100 : percent;
+        media->gain_q16 = ((int32_t)media->volume_percent << 16) / 100;
     }
 }
 
@@ -284,28 +1061,178 @@ FAT_Status Media_ReadFrameAt(MediaFile *media, uint32_t frame_number, uint8_t *b
     if (!media || !media->is_open || !buffer) return FAT_ERROR_INVALID_PARAM;
     if (frame_number >= media->frame_count) return FAT_ERROR_INVALID_PARAM;
     
+    if (media->video_codec == MEDIA_CODEC_DELTA) {
+        return Media_ReadFrameDelta(media, frame_number, buffer);
+    }
+    if (media->layout == MEDIA_LAYOUT_INTERLEAVED) {
+        return Media_ReadFrameInterleaved(media, frame_number, buffer);
+    }
+    
     uint32_t offset = media->video_offset + (frame_number * MEDIA_FRAME_SIZE);
     return Media_ReadAt(media, offset, buffer, MEDIA_FRAME_SIZE);
 }
 
-FAT_Status Media_ReadAudioStereo(MediaFile *media, uint16_t *left, uint16_t *right, uint32_t count) {
-    if (!media || !media->is_open || !left || !right) return FAT_ERROR_INVALID_PARAM;
+FAT_Status Media_ReadFramePart(MediaFile *media, uint32_t frame_number, uint8_t *buffer,
+                               uint32_t offset, uint32_t max_bytes, uint32_t *bytes_read) {
+    if (!media || !media->is_open || !buffer || !bytes_read) return FAT_ERROR_INVALID_PARAM;
+    if (frame_number >= media->frame_count || offset >= MEDIA_FRAME_SIZE) return FAT_ERROR_INVALID_PARAM;
+    
+    *bytes_read = 0;
+    
+    uint32_t frame_offset = 0;
+    bool whole = false;
+    
+    if (media->video_codec == MEDIA_CODEC_DELTA) {
+        whole = true;
+    } else if (media->layout == MEDIA_LAYOUT_INTERLEAVED) {
+        uint32_t chunk = Media_ChunkOfFrame(media, frame_number);
+        uint32_t index = frame_number - Media_ChunkFirstFrame(media, chunk);
+        
+        whole = Media_ChunkStaged(media, chunk);
+        frame_offset = Media_ChunkOffset(media, chunk) + media->chunk_samples * 4 +
+                       index * MEDIA_FRAME_SIZE;
+    } else {
+        frame_offset = media->video_offset + (frame_number * MEDIA_FRAME_SIZE);
+    }
+    
+    // Nothing to split - produce the whole frame on the first call
+    if (whole) {
+        if (offset != 0) return FAT_ERROR_INVALID_PARAM;
+        
+        FAT_Status status = Media_ReadFrameAt(media, frame_number, buffer);
+        if (status == FAT_OK) {
+            *bytes_read = MEDIA_FRAME_SIZE;
+        }
+        return status;
+    }
+    
+    if (offset == 0 && media->layout == MEDIA_LAYOUT_INTERLEAVED) {
+        media->staged_misses++;
+    }
+    
+    uint32_t size = MEDIA_FRAME_SIZE - offset;
+    if (size > max_bytes) size = max_bytes;
+    
+    FAT_Status status = Media_ReadAt(media, frame_offset + offset, buffer + offset, size);
+    if (status == FAT_OK) {
+        *bytes_read = size;
+    }
+    return status;
+}
+
+/**
+ * @brief Write DAC silence to samples [from, count) of strided L/R outputs
+ */
+static void Media_FillSilence(uint16_t *left, uint16_t *right, uint32_t stride,
+                              uint32_t from, uint32_t count) {
+    for (uint32_t i = from; i < count; i++) {
+        left[i * stride] = DAC_SILENCE;
+        right[i * stride] = DAC_SILENCE;
+    }
+}
+
+/**
+ * @brief Convert PCM in PCM_POLL_SAMPLES chunks, advancing the SD request between them
+ * 
+ * Keeps the card moving (data token, CRC, next block DMA) while the CPU
+ * converts, instead of leaving every polled phase for SD_AsyncWait().
+ */
+static void Media_ConvertPcmPolled(MediaFile *media, SD_Handle *hsd, const int16_t *pcm,
+                                   uint16_t *left, uint16_t *right, uint32_t stride,
+                                   uint32_t count) {
+    for (uint32_t i = 0; i < count; i += PCM_POLL_SAMPLES) {
+        uint32_t n = count - i;
+        if (n > PCM_POLL_SAMPLES) n = PCM_POLL_SAMPLES;
+        
+        Media_ConvertPcm(media, &pcm[i * 2], &left[i * stride], &right[i * stride], stride, n);
+        
+        if (SD_IsBusy(hsd)) {
+            SD_AsyncPoll(hsd);
+        }
+    }
+}
+
+/**
+ * @brief Read raw PCM at current_sample and convert it
+ * 
+ * When the samples fill whole sectors of one extent, they are read on the
+ * SD stream in MEDIA_PCM_BATCH_SECTORS batches. Each batch after the first
+ * is started with SD_StreamReadAsync() before the previous one is
+ * converted, and the conversion polls the request between chunks, so a
+ * late data token or the next block's DMA is picked up mid-conversion
+ * rather than after it. Other spans (fragmented files, v2 offsets, the file's last partial
+ * sector) are read in one piece, then converted.
+ */
+static FAT_Status Media_ReadAudioPcm(MediaFile *media, uint16_t *left, uint16_t *right,
+                                     uint32_t stride, uint32_t count) {
+    uint32_t offset = media->audio_offset + media->current_sample * 4;
+    uint8_t *buffer = (uint8_t*)s_audio_buffer;
+    uint32_t sector = Media_SectorRun(media, offset, count * 4);
+    
+    if (sector == 0) {
+        if (Media_ReadAt(media, offset, buffer, count * 4) != FAT_OK) {
+            return FAT_ERROR_READ;
+        }
+        Media_ConvertPcm(media, s_audio_buffer, left, right, stride, count);
+        return FAT_OK;
+    }
     
+    SD_Handle *hsd = media->vol->hsd;
+    uint32_t sectors = count / PCM_SECTOR_SAMPLES;
+    uint32_t batch = (sectors < MEDIA_PCM_BATCH_SECTORS) ? sectors : MEDIA_PCM_BATCH_SECTORS;
+    
+    // First batch has nothing to overlap with
+    if (Media_ReadSectors(media, sector, buffer, batch) != FAT_OK) {
+        return FAT_ERROR_READ;
+    }
+    
+    for (uint32_t done = 0; done < sectors; ) {
+        uint32_t next = done + batch;
+        uint32_t next_batch = sectors - next;
+        if (next_batch > MEDIA_PCM_BATCH_SECTORS) {
+            next_batch = MEDIA_PCM_BATCH_SECTORS;
+        }
+        
+        // Continue the stream into the next batch, then convert under it
+        if (next_batch > 0 &&
+            SD_StreamReadAsync(hsd, buffer + next * SD_BLOCK_SIZE, next_batch, NULL, NULL) != SD_OK) {
+            return FAT_ERROR_READ;
+        }
+        
+        uint32_t first = done * PCM_SECTOR_SAMPLES;
+        Media_ConvertPcmPolled(media, hsd, &s_audio_buffer[first * 2], &left[first * stride],
+                               &right[first * stride], stride, batch * PCM_SECTOR_SAMPLES);
+        
+        if (next_batch > 0 && SD_AsyncWait(hsd) != SD_OK) {
+            return FAT_ERROR_READ;
+        }
+        
+        done = next;
+        batch = next_batch;
+    }
+    
+    return FAT_OK;
+}
+
+/**
+ * @brief Read count samples at current_sample into strided L/R outputs
+ * 
+ * Sample i goes to left[i * stride] and right[i * stride]: stride 1 fills
+ * two channel buffers, stride 2 fills packed L|R words.
+ */
+static FAT_Status Media_ReadAudio(MediaFile *media, uint16_t *left, uint16_t *right,
+                                  uint32_t stride, uint32_t count) {
     // Limit to buffer size
     if (count > MAX_AUDIO_READ_SAMPLES) {
         count = MAX_AUDIO_READ_SAMPLES;
     }
     
     // Calculate total samples available
-    uint32_t bytes_per_sample = 4;  // 16-bit stereo = 4 bytes
-    uint32_t total_samples = media->audio_size / bytes_per_sample;
+    uint32_t total_samples = media->audio_samples;
     
     // Fill with silence if past end
     if (media->current_sample >= total_samples) {
-        for (uint32_t i = 0; i < count; i++) {
-            left[i] = DAC_SILENCE;
-            right[i] = DAC_SILENCE;
-        }
+        Media_FillSilence(left, right, stride, 0, count);
         return FAT_OK;
     }
     
@@ -313,47 +1240,46 @@ FAT_Status Media_ReadAudioStereo(MediaFile *media, uint16_t *left, uint16_t *rig
     uint32_t available = total_samples - media->current_sample;
     uint32_t to_read = (count < available) ? count : available;
     
-    // Read raw audio data
-    uint32_t offset = media->audio_offset + (media->current_sample * bytes_per_sample);
-    uint32_t bytes_to_read = to_read * bytes_per_sample;
-    
-    if (Media_ReadAt(media, offset, (uint8_t*)s_audio_buffer, bytes_to_read) != FAT_OK) {
-        // On error, fill with silence
-        for (uint32_t i = 0; i < count; i++) {
-            left[i] = DAC_SILENCE;
-            right[i] = DAC_SILENCE;
+    if (media->audio_codec == MEDIA_AUDIO_ADPCM) {
+        if (Media_ReadAudioAdpcm(media, left, right, stride, to_read) != FAT_OK) {
+            Media_FillSilence(left, right, stride, 0, count);
+            return FAT_ERROR_READ;
+        }
+    } else if (media->layout == MEDIA_LAYOUT_INTERLEAVED) {
+        if (Media_ReadAudioInterleaved(media, left, right, stride, to_read) != FAT_OK) {
+            Media_FillSilence(left, right, stride, 0, count);
+            return FAT_ERROR_READ;
+        }
+    } else {
+        if (Media_ReadAudioPcm(media, left, right, stride, to_read) != FAT_OK) {
+            // On error, fill with silence
+            Media_FillSilence(left, right, stride, 0, count);
+            return FAT_ERROR_READ;
         }
-        return FAT_ERROR_READ;
-    }
-    
-    // Convert: deinterleave, apply volume, convert to 12-bit unsigned
-    uint8_t vol = media->volume_percent;
-    
-    for (uint32_t i = 0; i < to_read; i++) {
-        int16_t l_raw = s_audio_buffer[i * 2];
-        int16_t r_raw = s_audio_buffer[i * 2 + 1];
-        
-        // Apply volume (scale by percentage)
-        int32_t l_scaled = ((int32_t)l_raw * vol) / 100;
-        int32_t r_scaled = ((int32_t)r_raw * vol) / 100;
-        
-        // Convert from signed 16-bit to unsigned 12-bit for DAC
-        // Input: -32768 to 32767, Output: 0 to 4095
-        left[i] = (uint16_t)((l_scaled + 32768) >> 4);
-        right[i] = (uint16_t)((r_scaled + 32768) >> 4);
     }
     
     // Update position
     media->current_sample += to_read;
     
     // Fill remainder with silence
-    for (uint32_t i = to_read; i < count; i++) {
-        left[i] = DAC_SILENCE;
-        right[i] = DAC_SILENCE;
-    }
+    Media_FillSilence(left, right, stride, to_read, count);
     
     // Memory barrier for DMA coherency
     __DMB();
     
     return FAT_OK;
 }
+
+FAT_Status Media_ReadAudioStereo(MediaFile *media, uint16_t *left, uint16_t *right, uint32_t count) {
+    if (!media || !media->is_open || !left || !right) return FAT_ERROR_INVALID_PARAM;
+    
+    return Media_ReadAudio(media, left, right, 1, count);
+}
+
+FAT_Status Media_ReadAudioPacked(MediaFile *media, uint32_t *packed, uint32_t count) {
+    if (!media || !media->is_open || !packed) return FAT_ERROR_INVALID_PARAM;
+    
+    // Little-endian word: left in bits 0-15 (DHR12RD ch1), right in 16-31
+    uint16_t *halves = (uint16_t*)packed;
+    return Media_ReadAudio(media, halves, halves + 1, 2, count);
+}
@@ -0,0 +1,196 @@
+/**
+ * @file    osd.c
+ * @brief   Live on-screen overlay implementation
+ * @author  David Leathers
+ * @date    November 2025
+ */
+
+#include "osd.h"
+#include <string.h>
+#include <stdio.h>
+
+/* ========================== Private Data ========================== */
+
+// Text field layout on OSD_TEXT_PAGE: "mm:ss", "+dd", "-ddms"
+static const OSD_Field s_field_layout[OSD_FIELD_COUNT] = {
+    [OSD_FIELD_TIME]  = { .x = 0,  .chars = 5 },
+    [OSD_FIELD_DRIFT] = { .x = 48, .chars = 4 },
+    [OSD_FIELD_SLACK] = { .x = 97, .chars = 5 },
+};
+
+// Glyph pitch of Font_5x7 (glyph plus spacing)
+#define OSD_CHAR_WIDTH      (5 + 1)
+
+/* ========================== Private Functions ========================== */
+
+/**
+ * @brief Clamp a value to a field's printable range
+ */
+static inline int32_t OSD_Clamp(int32_t value, int32_t lo, int32_t hi) {
+    return (value < lo) ? lo : (value > hi) ? hi : value;
+}
+
+/**
+ * @brief Box width of a text field in columns (1-column left margin)
+ */
+static inline uint32_t OSD_FieldWidth(const OSD_Field *field) {
+    return 1 + field->chars * OSD_CHAR_WIDTH;
+}
+
+/**
+ * @brief Record the word span the mask covers on each page
+ */
+static void OSD_ComputeSpans(OSD_Handle *osd) {
+    const uint32_t words = SSD1306_WIDTH / 4;
+    
+    for (uint32_t page = 0; page < SSD1306_PAGES; page++) {
+        const uint32_t *mask = (const uint32_t *)&osd->mask[page * SSD1306_WIDTH];
+        uint32_t start = words;
+        uint32_t end = 0;
+        
+        for (uint32_t w = 0; w < words; w++) {
+            if (!mask[w]) continue;
+            if (start == words) start = w;
+            end = w;
+        }
+        
+        osd->span_start[page] = (uint8_t)start;
+        osd->span_end[page] = (uint8_t)end;
+    }
+}
+
+/**
+ * @brief Current value of a text field
+ */
+static int32_t OSD_FieldValue(const OSD_Handle *osd, OSD_FieldId id, uint32_t frame) {
+    switch (id) {
+        case OSD_FIELD_TIME:
+            return (int32_t)(AVSync_GetFrameDueSample(osd->sync, frame) /
+                             osd->sync->audio_sample_rate);
+        case OSD_FIELD_DRIFT:
+            return OSD_Clamp(AVSync_GetCurrentDrift(osd->sync), -99, 99);
+        default: {
+            int64_t ms = (int64_t)osd->audio->stats.slack_last * 1000 /
+                         (int32_t)osd->sync->audio_sample_rate;
+            return OSD_Clamp((int32_t)ms, -99, 999);
+        }
+    }
+}
+
+/**
+ * @brief Re-render a text field's box in the bits layer
+ */
+static void OSD_DrawField(OSD_Handle *osd, const OSD_Field *field, OSD_FieldId id) {
+    char text[8];
+    int32_t value = field->value;
+    
+    switch (id) {
+        case OSD_FIELD_TIME:
+            value = OSD_Clamp(value, 0, 99 * 60 + 59);
+            snprintf(text, sizeof(text), "%02ld:%02ld", (long)(value / 60), (long)(value % 60));
+            break;
+        case OSD_FIELD_DRIFT:
+            snprintf(text, sizeof(text), "%+ldf", (long)value);
+            break;
+        default:
+            snprintf(text, sizeof(text), "%ldms", (long)value);
+            break;
+    }
+    
+    uint8_t *row = &osd->bits[OSD_TEXT_PAGE * SSD1306_WIDTH];
+    memset(&row[field->x], 0, OSD_FieldWidth(field));
+    SSD1306_DrawText(osd->bits, field->x + 1, OSD_TEXT_PAGE * 8, text, &Font_5x7,
+                     SSD1306_COLOR_WHITE, SSD1306_TEXT_TRANSPARENT);
+}
+
+/**
+ * @brief Redraw the bar columns between the old and new fill
+ */
+static void OSD_DrawBar(OSD_Handle *osd, uint32_t frame) {
+    uint32_t fill = osd->frame_count ?
+                    (uint32_t)((uint64_t)frame * SSD1306_WIDTH / osd->frame_count) : 0;
+    if (fill > SSD1306_WIDTH) fill = SSD1306_WIDTH;
+    if (fill == osd->bar_fill) return;
+    
+    uint8_t *row = &osd->bits[OSD_BAR_PAGE * SSD1306_WIDTH];
+    uint32_t lo = (fill < osd->bar_fill) ? fill : osd->bar_fill;
+    uint32_t hi = (fill < osd->bar_fill) ? osd->bar_fill : fill;
+    
+    for (uint32_t col = lo; col < hi; col++) {
+        row[col] = (col < fill) ? OSD_BAR_FILL : OSD_BAR_TRACK;
+    }
+    osd->bar_fill = fill;
+    osd->redraws++;
+}
+
+/**
+ * @brief Merge the layers into a frame, a word at a time over each page's span
+ */
+static void OSD_Merge(const OSD_Handle *osd, uint8_t *buffer) {
+    uint32_t *dst = (uint32_t *)buffer;
+    const uint32_t *bits = (const uint32_t *)osd->bits;
+    const uint32_t *mask = (const uint32_t *)osd->mask;
+    
+    for (uint32_t page = 0; page < SSD1306_PAGES; page++) {
+        uint32_t base = page * (SSD1306_WIDTH / 4);
+        
+        for (uint32_t w = osd->span_start[page]; w <= osd->span_end[page]; w++) {
+            dst[base + w] = (dst[base + w] & ~mask[base + w]) | bits[base + w];
+        }
+    }
+}
+
+/* ========================== Public API ========================== */
+
+void OSD_Init(OSD_Handle *osd, AVSync_Handle *sync, Audio_Handle *audio, uint32_t frame_count) {
+    if (!osd || !sync || !audio) return;
+    
+    memset(osd, 0, sizeof(OSD_Handle));
+    osd->sync = sync;
+    osd->audio = audio;
+    osd->frame_count = frame_count;
+    memcpy(osd->fields, s_field_layout, sizeof(s_field_layout));
+    
+    // Text boxes own their whole page height
+    for (uint32_t i = 0; i < OSD_FIELD_COUNT; i++) {
+        const OSD_Field *field = &osd->fields[i];
+        memset(&osd->mask[OSD_TEXT_PAGE * SSD1306_WIDTH + field->x], 0xFF, OSD_FieldWidth(field));
+    }
+    
+    // Bar spans the width, empty
+    memset(&osd->mask[OSD_BAR_PAGE * SSD1306_WIDTH], OSD_BAR_MASK, SSD1306_WIDTH);
+    memset(&osd->bits[OSD_BAR_PAGE * SSD1306_WIDTH], OSD_BAR_TRACK, SSD1306_WIDTH);
+    
+    OSD_ComputeSpans(osd);
+    osd->initialized = true;
+}
+
+void OSD_SetEnabled(OSD_Handle *osd, bool enabled) {
+    if (!osd || !osd->initialized) return;
+    osd->enabled = enabled;
+}
+
+void OSD_Toggle(OSD_Handle *osd) {
+    if (!osd) return;
+    OSD_SetEnabled(osd, !osd->enabled);
+}
+
+void OSD_Compose(OSD_Handle *osd, uint32_t frame, uint8_t *buffer) {
+    if (!osd || !osd->initialized || !osd->enabled || !buffer) return;
+    
+    // Re-render only what changed since the last frame
+    for (uint32_t i = 0; i < OSD_FIELD_COUNT; i++) {
+        OSD_Field *field = &osd->fields[i];
+        int32_t value = OSD_FieldValue(osd, (OSD_FieldId)i, frame);
+        
+        if (field->drawn && field->value == value) continue;
+        
+        field->value = value;
+        field->drawn = true;
+        OSD_DrawField(osd, field, (OSD_FieldId)i);
+        osd->redraws++;
+    }
+    OSD_DrawBar(osd, frame);
+    
+    OSD_Merge(osd, buffer);
+}
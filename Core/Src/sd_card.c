@@ -17,6 +17,10 @@
 #define SD_DATA_TIMEOUT_US          250000      // 250ms for data token
 #define SD_DMA_TIMEOUT_US           100000      // 100ms for DMA transfer
 
+// Byte polling budget per SD_AsyncPoll() / submit step (bytes read before yielding)
+#define SD_ASYNC_POLL_TOKEN_POLLS   8           // Data start token
+#define SD_ASYNC_POLL_BUSY_POLLS    8           // Card busy after CMD12
+
 /* ========================== Private Data ========================== */
 
 // 0xFF buffer for SPI receive - MOSI must stay HIGH while reading
@@ -59,6 +63,8 @@ static inline uint8_t SD_ReadByte(SD_Handle *hsd) {
 /* ========================== Command Protocol ========================== */
 
 static void SD_SendCommand(SD_Handle *hsd, uint8_t cmd, uint32_t arg) {
+    hsd->stats.commands++;
+    
     // Send dummy byte before command
     SD_SendByte(hsd, SD_DUMMY_BYTE);
     
@@ -121,7 +127,7 @@ static SD_Status SD_WaitDataToken(SD_Handle *hsd) {
         
         // Check for error token (0x0X)
         if ((token & 0xF0) == 0x00) {
-            return SD_ERROR;
+            return SD_ERROR_READ;
         }
         
         if (Perf_CyclesToMicros(Perf_GetCycles() - start) > SD_DATA_TIMEOUT_US) {
@@ -130,54 +136,192 @@ static SD_Status SD_WaitDataToken(SD_Handle *hsd) {
     } while (1);
 }
 
-/* ========================== DMA Block Read ========================== */
+/* ========================== Async Read State Machine ========================== */
+
+/*
+ * Request flow (one block per DMA transfer):
+ * 
+ *   submit --CMD17/18--> WAIT_TOKEN --token--> DATA --DMA done--> BLOCK_DONE
+ *                            ^                                       | CRC
+ *                            +------------- more blocks -------------+
+ *                                                                    | last
+ *                          CMD17: DONE <-----------------------------+
+ *                          CMD18: STOPPING --CMD12--> STOP_BUSY --ready--> DONE
+ * 
+ * The SPI DMA interrupt only moves DATA to BLOCK_DONE. Every step that
+ * clocks bytes by polling runs in SD_AsyncPoll() (or the submitting call)
+ * and reads a bounded number of bytes, so the caller can do other work
+ * between polls. Failed transfers also pass through BLOCK_DONE, which
+ * keeps CS release and CMD12 out of the interrupt.
+ * 
+ * Stream reads use the same states, but finish a request without CMD12 or
+ * CS release; the card simply waits for the next clock.
+ */
+
+/**
+ * @brief Complete the current request and notify the owner
+ */
+static void SD_AsyncFinish(SD_Handle *hsd, SD_Status status) {
+    // An open stream keeps the card selected between requests
+    if (!hsd->stream_open) {
+        SD_CS_Deselect(hsd);
+    }
+    
+    hsd->async_status = status;
+    hsd->async_state = (status == SD_OK) ? SD_ASYNC_DONE : SD_ASYNC_ERROR;
+    
+    if (hsd->async_callback) {
+        hsd->async_callback(hsd, status, hsd->async_context);
+    }
+}
+
+/**
+ * @brief Abort data phase; multi-block reads still need CMD12
+ */
+static void SD_AsyncFail(SD_Handle *hsd, SD_Status status) {
+    if (hsd->async_multi) {
+        hsd->async_status = status;
+        hsd->async_state = SD_ASYNC_STOPPING;
+    } else {
+        SD_AsyncFinish(hsd, status);
+    }
+}
 
 /**
- * @brief Read block data using DMA
- * @param hsd    Handle
- * @param buffer Destination (512 bytes)
- * @return SD_OK on success
+ * @brief Start DMA for the next 512-byte block
  * 
- * Assumes data token already received. Reads 512 bytes + 2 CRC bytes.
- * Uses DMA for the 512-byte transfer, polling for CRC.
+ * Assumes data token already received. Transmits 0xFF while receiving
+ * into the request buffer. CRC bytes are discarded on completion.
  */
-static SD_Status SD_ReadBlockData_DMA(SD_Handle *hsd, uint8_t *buffer) {
-    // Start DMA transfer - transmit 0xFF buffer, receive to user buffer
+static void SD_AsyncStartBlockDMA(SD_Handle *hsd) {
     hsd->dma_busy = true;
     hsd->dma_error = false;
+    hsd->async_phase_start = Perf_GetCycles();
+    hsd->async_state = SD_ASYNC_DATA;
     
     HAL_StatusTypeDef hal_status = HAL_SPI_TransmitReceive_DMA(
         hsd->hspi,
         s_ff_buffer,
-        buffer,
+        hsd->async_buffer,
         SD_BLOCK_SIZE
     );
     
     if (hal_status != HAL_OK) {
         hsd->dma_busy = false;
-        return SD_ERROR;
+        SD_AsyncFail(hsd, SD_ERROR);
     }
-    
-    // Wait for DMA completion
-    uint32_t start = Perf_GetCycles();
-    while (hsd->dma_busy) {
-        if (Perf_CyclesToMicros(Perf_GetCycles() - start) > SD_DMA_TIMEOUT_US) {
-            // Abort DMA on timeout
-            HAL_SPI_DMAStop(hsd->hspi);
-            hsd->dma_busy = false;
-            return SD_ERROR_TIMEOUT;
+}
+
+/**
+ * @brief Poll for the data start token (bounded number of bytes)
+ * @param max_polls Bytes to read before giving up for now
+ */
+static void SD_AsyncStepToken(SD_Handle *hsd, uint32_t max_polls) {
+    for (uint32_t i = 0; i < max_polls; i++) {
+        uint8_t token = SD_ReadByte(hsd);
+        
+        if (token == SD_START_TOKEN) {
+            SD_AsyncStartBlockDMA(hsd);
+            return;
+        }
+        
+        // Error token (0x0X)
+        if ((token & 0xF0) == 0x00) {
+            SD_AsyncFail(hsd, SD_ERROR_READ);
+            return;
         }
     }
     
+    if (Perf_CyclesToMicros(Perf_GetCycles() - hsd->async_phase_start) > SD_DATA_TIMEOUT_US) {
+        SD_AsyncFail(hsd, SD_ERROR_TIMEOUT);
+    }
+}
+
+/**
+ * @brief Finish a block whose DMA completed: CRC, then the next token or the stop
+ */
+static void SD_AsyncStepBlockDone(SD_Handle *hsd) {
     if (hsd->dma_error) {
-        return SD_ERROR;
+        SD_AsyncFail(hsd, SD_ERROR);
+        return;
     }
     
     // Discard CRC (2 bytes) - use polling, it's fast
     SD_ReadByte(hsd);
     SD_ReadByte(hsd);
     
-    return SD_OK;
+    hsd->async_buffer += SD_BLOCK_SIZE;
+    hsd->async_remaining--;
+    hsd->stats.blocks_read++;
+    if (hsd->stream_open) {
+        hsd->stream_next_block++;
+    }
+    
+    if (hsd->async_remaining == 0) {
+        if (hsd->stream_open) {
+            SD_AsyncFinish(hsd, SD_OK);
+        } else if (hsd->async_multi) {
+            hsd->async_status = SD_OK;
+            hsd->async_state = SD_ASYNC_STOPPING;
+        } else {
+            SD_AsyncFinish(hsd, SD_OK);
+        }
+        return;
+    }
+    
+    // Next block of a CMD18 read - token is usually already waiting
+    hsd->async_state = SD_ASYNC_WAIT_TOKEN;
+    hsd->async_phase_start = Perf_GetCycles();
+    SD_AsyncStepToken(hsd, SD_ASYNC_POLL_TOKEN_POLLS);
+}
+
+/**
+ * @brief Send CMD12 to end a multi-block read (R1 follows within 8 bytes)
+ */
+static void SD_SendStop(SD_Handle *hsd) {
+    SD_SendByte(hsd, SD_DUMMY_BYTE);  // Stuff byte
+    SD_SendCommand(hsd, SD_CMD12, 0);
+    SD_GetResponse(hsd);
+}
+
+/**
+ * @brief Send CMD12 and wait out the card's busy period
+ */
+static void SD_StopTransmission(SD_Handle *hsd) {
+    SD_SendStop(hsd);
+    SD_WaitReady(hsd, SD_READY_TIMEOUT_US);
+}
+
+/**
+ * @brief Send CMD12 after a multi-block read (or a stream that hit an error)
+ */
+static void SD_AsyncStepStop(SD_Handle *hsd) {
+    SD_SendStop(hsd);
+    hsd->async_state = SD_ASYNC_STOP_BUSY;
+    hsd->async_phase_start = Perf_GetCycles();
+}
+
+/**
+ * @brief Poll for the end of CMD12 busy (bounded), then release the card
+ */
+static void SD_AsyncStepStopBusy(SD_Handle *hsd) {
+    bool ready = false;
+    
+    for (uint32_t i = 0; i < SD_ASYNC_POLL_BUSY_POLLS && !ready; i++) {
+        ready = (SD_ReadByte(hsd) == 0xFF);
+    }
+    
+    if (!ready) {
+        if (Perf_CyclesToMicros(Perf_GetCycles() - hsd->async_phase_start) <= SD_READY_TIMEOUT_US) {
+            return;
+        }
+        if (hsd->async_status == SD_OK) {
+            hsd->async_status = SD_ERROR_TIMEOUT;
+        }
+    }
+    
+    hsd->stream_open = false;
+    SD_AsyncFinish(hsd, hsd->async_status);
 }
 
 /* ========================== Initialization Sequence ========================== */
@@ -376,41 +520,128 @@ SD_Status SD_Init(SD_Handle *hsd, SPI_HandleTypeDef *hspi,
 SD_Status SD_ReadBlock(SD_Handle *hsd, uint8_t *buffer, uint32_t block) {
     if (!hsd || !hsd->initialized || !buffer) return SD_ERROR;
     
+    SD_Status status = SD_ReadBlocksAsync(hsd, buffer, block, 1, NULL, NULL);
+    if (status != SD_OK) return status;
+    
+    return SD_AsyncWait(hsd);
+}
+
+SD_Status SD_ReadMultipleBlocks(SD_Handle *hsd, uint8_t *buffer,
+                                 uint32_t start_block, uint32_t count) {
+    if (!hsd || !hsd->initialized || !buffer || count == 0) return SD_ERROR;
+    
+    SD_Status status = SD_ReadBlocksAsync(hsd, buffer, start_block, count, NULL, NULL);
+    if (status != SD_OK) return status;
+    
+    return SD_AsyncWait(hsd);
+}
+
+/* ========================== Async API ========================== */
+
+SD_Status SD_ReadBlocksAsync(SD_Handle *hsd, uint8_t *buffer,
+                             uint32_t start_block, uint32_t count,
+                             SD_AsyncCallback callback, void *context) {
+    if (!hsd || !hsd->initialized || !buffer || count == 0) return SD_ERROR;
+    if (SD_IsBusy(hsd)) return SD_ERROR_BUSY;
+    
+    // Random access ends any open stream
+    if (hsd->stream_open) {
+        SD_StreamClose(hsd);
+    }
+    
     // SDHC uses block addressing, standard SD uses byte addressing
-    uint32_t addr = hsd->info.high_capacity ? block : (block * SD_BLOCK_SIZE);
+    uint32_t addr = hsd->info.high_capacity ? start_block : (start_block * SD_BLOCK_SIZE);
     
+    hsd->async_buffer = buffer;
+    hsd->async_remaining = count;
+    hsd->async_multi = (count > 1);
+    hsd->async_status = SD_OK;
+    hsd->async_callback = callback;
+    hsd->async_context = context;
+    
+    // CMD17 - Read Single Block, CMD18 - Read Multiple Blocks
     SD_CS_Select(hsd);
-    SD_SendCommand(hsd, SD_CMD17, addr);
+    SD_SendCommand(hsd, hsd->async_multi ? SD_CMD18 : SD_CMD17, addr);
     
     if (SD_GetResponse(hsd) != 0x00) {
         SD_CS_Deselect(hsd);
+        hsd->async_status = SD_ERROR;
+        hsd->async_state = SD_ASYNC_ERROR;
         return SD_ERROR;
     }
     
-    if (SD_WaitDataToken(hsd) != SD_OK) {
-        SD_CS_Deselect(hsd);
-        return SD_ERROR_TIMEOUT;
+    // Data token arrives after the card's read latency - poll it later
+    hsd->async_state = SD_ASYNC_WAIT_TOKEN;
+    hsd->async_phase_start = Perf_GetCycles();
+    SD_AsyncStepToken(hsd, SD_ASYNC_POLL_TOKEN_POLLS);
+    
+    return SD_OK;
+}
+
+SD_AsyncState SD_AsyncPoll(SD_Handle *hsd) {
+    if (!hsd) return SD_ASYNC_IDLE;
+    
+    switch (hsd->async_state) {
+        case SD_ASYNC_WAIT_TOKEN:
+            SD_AsyncStepToken(hsd, SD_ASYNC_POLL_TOKEN_POLLS);
+            break;
+            
+        case SD_ASYNC_DATA:
+            // Block completion is interrupt-driven - only watch for timeout
+            if (Perf_CyclesToMicros(Perf_GetCycles() - hsd->async_phase_start) > SD_DMA_TIMEOUT_US) {
+                HAL_SPI_DMAStop(hsd->hspi);
+                hsd->dma_busy = false;
+                SD_AsyncFail(hsd, SD_ERROR_TIMEOUT);
+            }
+            break;
+            
+        case SD_ASYNC_BLOCK_DONE:
+            SD_AsyncStepBlockDone(hsd);
+            break;
+            
+        case SD_ASYNC_STOPPING:
+            SD_AsyncStepStop(hsd);
+            break;
+            
+        case SD_ASYNC_STOP_BUSY:
+            SD_AsyncStepStopBusy(hsd);
+            break;
+            
+        default:
+            break;
     }
     
-    // Read block data using DMA
-    SD_Status status = SD_ReadBlockData_DMA(hsd, buffer);
+    return hsd->async_state;
+}
+
+SD_Status SD_AsyncWait(SD_Handle *hsd) {
+    if (!hsd) return SD_ERROR;
     
-    SD_CS_Deselect(hsd);
+    while (SD_IsBusy(hsd)) {
+        SD_AsyncPoll(hsd);
+    }
+    
+    SD_Status status = (hsd->async_state == SD_ASYNC_ERROR) ? hsd->async_status : SD_OK;
+    hsd->async_state = SD_ASYNC_IDLE;
     return status;
 }
 
-SD_Status SD_ReadMultipleBlocks(SD_Handle *hsd, uint8_t *buffer,
-                                 uint32_t start_block, uint32_t count) {
-    if (!hsd || !hsd->initialized || !buffer || count == 0) return SD_ERROR;
+/* ========================== Streaming API ========================== */
+
+SD_Status SD_StreamOpen(SD_Handle *hsd, uint32_t start_block) {
+    if (!hsd || !hsd->initialized) return SD_ERROR;
+    if (SD_IsBusy(hsd)) return SD_ERROR_BUSY;
     
-    // Single block - use simpler function
-    if (count == 1) {
-        return SD_ReadBlock(hsd, buffer, start_block);
+    if (hsd->stream_open) {
+        if (hsd->stream_next_block == start_block) {
+            return SD_OK;   // Already positioned - keep streaming
+        }
+        SD_StreamClose(hsd);
     }
     
     uint32_t addr = hsd->info.high_capacity ? start_block : (start_block * SD_BLOCK_SIZE);
     
-    // CMD18 - Read Multiple Blocks
+    // CMD18 - Read Multiple Blocks, left open until seek or close
     SD_CS_Select(hsd);
     SD_SendCommand(hsd, SD_CMD18, addr);
     
@@ -419,41 +650,76 @@ SD_Status SD_ReadMultipleBlocks(SD_Handle *hsd, uint8_t *buffer,
         return SD_ERROR;
     }
     
-    // Read all blocks
-    SD_Status status = SD_OK;
-    for (uint32_t i = 0; i < count; i++) {
-        if (SD_WaitDataToken(hsd) != SD_OK) {
-            status = SD_ERROR_TIMEOUT;
-            break;
-        }
-        
-        status = SD_ReadBlockData_DMA(hsd, buffer + (i * SD_BLOCK_SIZE));
-        if (status != SD_OK) {
-            break;
-        }
-    }
+    hsd->stream_open = true;
+    hsd->stream_next_block = start_block;
+    hsd->async_multi = true;
+    hsd->async_state = SD_ASYNC_IDLE;
+    hsd->stats.stream_opens++;
     
-    // CMD12 - Stop Transmission
-    SD_SendByte(hsd, SD_DUMMY_BYTE);  // Stuff byte
-    SD_SendCommand(hsd, SD_CMD12, 0);
-    SD_GetResponse(hsd);
-    SD_WaitReady(hsd, SD_READY_TIMEOUT_US);
+    return SD_OK;
+}
+
+SD_Status SD_StreamReadAsync(SD_Handle *hsd, uint8_t *buffer, uint32_t count,
+                             SD_AsyncCallback callback, void *context) {
+    if (!hsd || !hsd->stream_open || !buffer || count == 0) return SD_ERROR;
+    if (SD_IsBusy(hsd)) return SD_ERROR_BUSY;
+    
+    hsd->async_buffer = buffer;
+    hsd->async_remaining = count;
+    hsd->async_multi = true;
+    hsd->async_status = SD_OK;
+    hsd->async_callback = callback;
+    hsd->async_context = context;
+    
+    hsd->async_state = SD_ASYNC_WAIT_TOKEN;
+    hsd->async_phase_start = Perf_GetCycles();
+    SD_AsyncStepToken(hsd, SD_ASYNC_POLL_TOKEN_POLLS);
+    
+    return SD_OK;
+}
+
+SD_Status SD_StreamRead(SD_Handle *hsd, uint8_t *buffer, uint32_t count) {
+    SD_Status status = SD_StreamReadAsync(hsd, buffer, count, NULL, NULL);
+    if (status != SD_OK) return status;
+    
+    return SD_AsyncWait(hsd);
+}
+
+SD_Status SD_StreamClose(SD_Handle *hsd) {
+    if (!hsd) return SD_ERROR;
+    if (!hsd->stream_open) return SD_OK;
     
+    // Let an in-flight stream read finish first
+    SD_AsyncWait(hsd);
+    if (!hsd->stream_open) return SD_OK;   // Closed by an error path
+    
+    SD_StopTransmission(hsd);
+    hsd->stream_open = false;
     SD_CS_Deselect(hsd);
-    return status;
+    
+    return SD_OK;
 }
 
 /* ========================== DMA Callbacks ========================== */
 
+// No SPI traffic here: the CRC, next token and any error handling are
+// polled by SD_AsyncPoll()
+
 void SD_DMA_RxComplete(SD_Handle *hsd) {
-    if (hsd) {
-        hsd->dma_busy = false;
+    if (!hsd) return;
+    
+    hsd->dma_busy = false;
+    if (hsd->async_state == SD_ASYNC_DATA) {
+        hsd->async_state = SD_ASYNC_BLOCK_DONE;
     }
 }
 
 void SD_DMA_Error(SD_Handle *hsd) {
-    if (hsd) {
-        hsd->dma_busy = false;
-        hsd->dma_error = true;
+    if (!hsd) return;
+    
+    hsd->dma_busy = false;
+    hsd->dma_error = true;
+    if (hsd->async_state == SD_ASYNC_DATA) {
+        hsd->async_state = SD_ASYNC_BLOCK_DONE;
     }
 }
@@ -6,6 +6,7 @@
  */
 
 #include "ssd1306.h"
+#include "perf.h"
 #include <string.h>
 
 /* ========================== SSD1306 Commands ========================== */
@@ -34,6 +35,9 @@
 // Internal framebuffer for standalone use (not triple-buffered)
 static uint8_t s_internal_buffer[SSD1306_BUFFER_SIZE];
 
+// Whole display RAM
+static const SSD1306_Window s_full_window = {0, SSD1306_PAGES - 1, 0, SSD1306_WIDTH - 1};
+
 /* ========================== Private Functions ========================== */
 
 /**
@@ -50,22 +54,217 @@ static SSD1306_Status SSD1306_WriteCommand(SSD1306_Handle *hd, uint8_t cmd) {
 }
 
 /**
- * @brief Set address window for full-screen write
+ * @brief Write a window's COLUMNADDR/PAGEADDR command stream
  */
-static SSD1306_Status SSD1306_SetAddressWindow(SSD1306_Handle *hd) {
-    // Column address: 0 to 127
-    if (SSD1306_WriteCommand(hd, SSD1306_COLUMNADDR) != SSD1306_OK) return SSD1306_ERROR;
-    if (SSD1306_WriteCommand(hd, 0x00) != SSD1306_OK) return SSD1306_ERROR;
-    if (SSD1306_WriteCommand(hd, SSD1306_WIDTH - 1) != SSD1306_OK) return SSD1306_ERROR;
+static void SSD1306_BuildAddressCommands(uint8_t *cmds, const SSD1306_Window *w) {
+    cmds[0] = SSD1306_COLUMNADDR;
+    cmds[1] = w->col_start;
+    cmds[2] = w->col_end;
+    cmds[3] = SSD1306_PAGEADDR;
+    cmds[4] = w->page_start;
+    cmds[5] = w->page_end;
+}
+
+/**
+ * @brief Set the display RAM window the next data bytes are written to
+ * 
+ * All six commands go in one transaction behind a single command-stream
+ * control byte.
+ */
+static SSD1306_Status SSD1306_SetAddressWindow(SSD1306_Handle *hd, const SSD1306_Window *w) {
+    uint8_t data[1 + SSD1306_ADDR_CMD_BYTES];
+    data[0] = 0x00;     // Command stream (Co = 0, D/C# = 0)
+    SSD1306_BuildAddressCommands(&data[1], w);
     
-    // Page address: 0 to 7 (64 pixels / 8 pixels per page)
-    if (SSD1306_WriteCommand(hd, SSD1306_PAGEADDR) != SSD1306_OK) return SSD1306_ERROR;
-    if (SSD1306_WriteCommand(hd, 0x00) != SSD1306_OK) return SSD1306_ERROR;
-    if (SSD1306_WriteCommand(hd, (SSD1306_HEIGHT / 8) - 1) != SSD1306_OK) return SSD1306_ERROR;
+    if (HAL_I2C_Master_Transmit(hd->hi2c, SSD1306_I2C_ADDR, data, sizeof(data), SSD1306_TIMEOUT) != HAL_OK) {
+        hd->last_error = SSD1306_ERROR_I2C;
+        return SSD1306_ERROR_I2C;
+    }
+    return SSD1306_OK;
+}
+
+/**
+ * @brief Split a frame into windows covering its differences from the panel
+ * @return Window count in hd->windows (0 if the panel already shows the frame)
+ * 
+ * One window per changed page, from its first to its last changed column.
+ * A single full-screen window is used instead when that is fewer bus bytes
+ * or the panel contents are unknown. The shadow is updated to the frame.
+ */
+static uint8_t SSD1306_PlanWindows(SSD1306_Handle *hd, const uint8_t *frame) {
+#if SSD1306_PARTIAL_UPDATES
+    if (hd->shadow_valid) {
+        uint8_t count = 0;
+        uint32_t cost = 0;
+        
+        for (uint8_t page = 0; page < SSD1306_PAGES; page++) {
+            const uint8_t *a = &frame[page * SSD1306_WIDTH];
+            const uint8_t *b = &hd->shadow[page * SSD1306_WIDTH];
+            const uint32_t *wa = (const uint32_t*)a;   // Frames and shadow are word aligned
+            const uint32_t *wb = (const uint32_t*)b;
+            
+            // Compare words in from each end, then narrow to bytes
+            int32_t first = 0;
+            int32_t last = SSD1306_WIDTH / 4 - 1;
+            while (first <= last && wa[first] == wb[first]) first++;
+            if (first > last) continue;
+            while (wa[last] == wb[last]) last--;
+            
+            uint32_t col_start = (uint32_t)first * 4;
+            uint32_t col_end = (uint32_t)last * 4 + 3;
+            while (a[col_start] == b[col_start]) col_start++;
+            while (a[col_end] == b[col_end]) col_end--;
+            
+            hd->windows[count++] = (SSD1306_Window){page, page, (uint8_t)col_start, (uint8_t)col_end};
+            cost += col_end - col_start + 1 + SSD1306_WINDOW_SETUP_BYTES;
+        }
+        
+        if (cost < SSD1306_BUFFER_SIZE + SSD1306_WINDOW_SETUP_BYTES) {
+            for (uint8_t i = 0; i < count; i++) {
+                const SSD1306_Window *w = &hd->windows[i];
+                uint32_t offset = w->page_start * SSD1306_WIDTH + w->col_start;
+                memcpy(&hd->shadow[offset], &frame[offset], w->col_end - w->col_start + 1);
+            }
+            return count;
+        }
+    }
     
+    memcpy(hd->shadow, frame, SSD1306_BUFFER_SIZE);
+    hd->shadow_valid = true;
+#endif
+    
+    hd->windows[0] = s_full_window;
+    hd->stats.full_frames++;
+    return 1;
+}
+
+/**
+ * @brief Start the command phase of the frame's next window (DMA)
+ */
+static SSD1306_Status SSD1306_StartWindow(SSD1306_Handle *hd) {
+    SSD1306_BuildAddressCommands(hd->cmd_buffer, &hd->windows[hd->window_next]);
+    hd->window_started = Perf_GetCycles();
+    hd->data_phase = false;
+    
+    if (HAL_I2C_Mem_Write_DMA(hd->hi2c, SSD1306_I2C_ADDR,
+                              0x00,                 // Command stream
+                              I2C_MEMADD_SIZE_8BIT,
+                              hd->cmd_buffer, SSD1306_ADDR_CMD_BYTES) != HAL_OK) {
+        hd->last_error = SSD1306_ERROR_I2C;
+        return SSD1306_ERROR_I2C;
+    }
+    return SSD1306_OK;
+}
+
+/**
+ * @brief Start the data phase of the current window (DMA)
+ */
+static SSD1306_Status SSD1306_StartWindowData(SSD1306_Handle *hd) {
+    const SSD1306_Window *w = &hd->windows[hd->window_next];
+    uint32_t offset = w->page_start * SSD1306_WIDTH + w->col_start;
+    uint32_t len = (uint32_t)(w->page_end - w->page_start + 1) * (w->col_end - w->col_start + 1);
+    
+    hd->data_phase = true;
+    
+    // Start DMA transfer using HAL memory write
+    HAL_StatusTypeDef result = HAL_I2C_Mem_Write_DMA(
+        hd->hi2c,
+        SSD1306_I2C_ADDR,
+        0x40,                       // Data mode register
+        I2C_MEMADD_SIZE_8BIT,
+        &hd->tx_frame[offset],
+        (uint16_t)len
+    );
+    
+    if (result != HAL_OK) {
+        hd->last_error = SSD1306_ERROR_I2C;
+        return SSD1306_ERROR_I2C;
+    }
+    
+    hd->stats.windows++;
+    hd->stats.wire_bytes += len + SSD1306_WINDOW_SETUP_BYTES;
     return SSD1306_OK;
 }
 
+/**
+ * @brief Give up on the frame in flight (ISR)
+ * 
+ * The panel holds part of it, so the shadow is invalid and the next frame
+ * is sent whole.
+ */
+static void SSD1306_AbortFrame(SSD1306_Handle *hd) {
+    hd->shadow_valid = false;
+    hd->window_count = 0;
+    hd->window_next = 0;
+    hd->last_error = SSD1306_ERROR_I2C;
+    hd->dma_busy = false;
+    FrameQueue_Release();
+}
+
+/**
+ * @brief Get a character's glyph columns (unprintable characters map to '?')
+ */
+static const uint8_t* SSD1306_GetGlyph(const SSD1306_Font *font, char c) {
+    if (c < 32 || c > 126) c = '?';
+    return &font->data[(c - 32) * font->width];
+}
+
+/**
+ * @brief Draw one glyph into a framebuffer, a byte per column
+ * 
+ * Each glyph column is one byte of rows 0-7, the same layout as a display
+ * page. On a page boundary (y % 8 == 0) a column is a single masked byte
+ * write; otherwise it is shifted across two pages and written as two.
+ * The set/clear masks are fixed per glyph and mode:
+ *   - Opaque: the glyph box is cleared, then the glyph bits set (WHITE)
+ *     or left clear (BLACK)
+ *   - Transparent: only the glyph bits change, set (WHITE) or cleared
+ *     (BLACK); the background shows through
+ * Columns past the right edge and rows past the bottom are clipped.
+ */
+static void SSD1306_BlitGlyph(uint8_t *fb, uint32_t x, uint32_t y, const uint8_t *glyph,
+                              const SSD1306_Font *font, SSD1306_Color color,
+                              SSD1306_TextMode mode) {
+    if (x >= SSD1306_WIDTH || y >= SSD1306_HEIGHT) return;
+    
+    uint32_t width = font->width;
+    if (x + width > SSD1306_WIDTH) width = SSD1306_WIDTH - x;
+    
+    // Rows the glyph covers (glyph columns are one byte)
+    uint32_t height = font->height > 8 ? 8 : font->height;
+    uint32_t box = (1u << height) - 1;
+    
+    bool white = (color == SSD1306_COLOR_WHITE);
+    bool opaque = (mode == SSD1306_TEXT_OPAQUE);
+    uint32_t shift = y % 8;
+    uint8_t *dst = &fb[(y / 8) * SSD1306_WIDTH + x];
+    
+    if (shift == 0) {
+        for (uint32_t col = 0; col < width; col++) {
+            uint32_t bits = glyph[col] & box;
+            uint32_t clear = opaque ? box : (white ? 0 : bits);
+            uint32_t set = white ? bits : 0;
+            dst[col] = (uint8_t)((dst[col] & ~clear) | set);
+        }
+        return;
+    }
+    
+    // Straddles two pages; the lower one may be off the bottom edge
+    bool lower = (y / 8) + 1 < SSD1306_PAGES;
+    
+    for (uint32_t col = 0; col < width; col++) {
+        uint32_t bits = (glyph[col] & box) << shift;
+        uint32_t clear = opaque ? (box << shift) : (white ? 0 : bits);
+        uint32_t set = white ? bits : 0;
+        
+        dst[col] = (uint8_t)((dst[col] & ~clear) | set);
+        if (lower) {
+            dst[col + SSD1306_WIDTH] = (uint8_t)((dst[col + SSD1306_WIDTH] & ~(clear >> 8)) |
+                                                 (set >> 8));
+        }
+    }
+}
+
 /* ========================== Core API ========================== */
 
 SSD1306_Status SSD1306_Init(SSD1306_Handle *hd, I2C_HandleTypeDef *hi2c, uint8_t *buffer) {
@@ -164,6 +363,11 @@ void SSD1306_SetCursor(SSD1306_Handle *hd, uint8_t x, uint8_t y) {
     hd->cursor_y = y;
 }
 
+void SSD1306_SetTextMode(SSD1306_Handle *hd, SSD1306_TextMode mode) {
+    if (!hd) return;
+    hd->text_mode = mode;
+}
+
 void SSD1306_WriteString(SSD1306_Handle *hd, const char *str, 
                           const SSD1306_Font *font, SSD1306_Color color) {
     if (!hd || !hd->framebuffer || !str || !font) return;
@@ -171,35 +375,8 @@ void SSD1306_WriteString(SSD1306_Handle *hd, const char *str,
     while (*str) {
         char c = *str++;
         
-        // Map unprintable characters to '?'
-        if (c < 32 || c > 126) c = '?';
-        
-        // Get glyph data
-        const uint8_t *glyph = &font->data[(c - 32) * font->width];
-        
-        // Render glyph column by column
-        for (uint8_t col = 0; col < font->width; col++) {
-            uint8_t line = glyph[col];
-            
-            for (uint8_t row = 0; row < font->height; row++) {
-                uint8_t px = hd->cursor_x + col;
-                uint8_t py = hd->cursor_y + row;
-                
-                // Bounds check
-                if (px >= SSD1306_WIDTH || py >= SSD1306_HEIGHT) continue;
-                
-                // Calculate buffer position
-                uint16_t idx = px + (py / 8) * SSD1306_WIDTH;
-                uint8_t bit = 1 << (py % 8);
-                
-                // Set or clear pixel
-                if ((line & (1 << row)) && color == SSD1306_COLOR_WHITE) {
-                    hd->framebuffer[idx] |= bit;
-                } else {
-                    hd->framebuffer[idx] &= ~bit;
-                }
-            }
-        }
+        SSD1306_BlitGlyph(hd->framebuffer, hd->cursor_x, hd->cursor_y,
+                          SSD1306_GetGlyph(font, c), font, color, hd->text_mode);
         
         // Advance cursor
         hd->cursor_x += font->width + 1;
@@ -212,13 +389,40 @@ void SSD1306_WriteString(SSD1306_Handle *hd, const char *str,
     }
 }
 
+uint32_t SSD1306_DrawText(uint8_t *buffer, uint32_t x, uint32_t y, const char *str,
+                          const SSD1306_Font *font, SSD1306_Color color,
+                          SSD1306_TextMode mode) {
+    if (!buffer || !str || !font) return x;
+    
+    while (*str && x < SSD1306_WIDTH) {
+        SSD1306_BlitGlyph(buffer, x, y, SSD1306_GetGlyph(font, *str++), font, color, mode);
+        x += font->width + 1;
+    }
+    return x;
+}
+
+void SSD1306_DrawPixel(uint8_t *buffer, uint32_t x, uint32_t y, SSD1306_Color color) {
+    if (!buffer || x >= SSD1306_WIDTH || y >= SSD1306_HEIGHT) return;
+    
+    uint8_t *dst = &buffer[(y / 8) * SSD1306_WIDTH + x];
+    uint8_t bit = (uint8_t)(1u << (y % 8));
+    
+    if (color == SSD1306_COLOR_WHITE) {
+        *dst |= bit;
+    } else {
+        *dst &= (uint8_t)~bit;
+    }
+}
+
 /* ========================== Screen Update (Polling) ========================== */
 
 SSD1306_Status SSD1306_UpdateScreen(SSD1306_Handle *hd) {
     if (!hd || !hd->initialized || !hd->framebuffer) return SSD1306_ERROR;
+    if (hd->dma_busy) return SSD1306_ERROR_BUSY;
     
     // Set address window for full screen
-    if (SSD1306_SetAddressWindow(hd) != SSD1306_OK) return SSD1306_ERROR;
+    hd->shadow_valid = false;
+    if (SSD1306_SetAddressWindow(hd, &s_full_window) != SSD1306_OK) return SSD1306_ERROR;
     
     // Send framebuffer in chunks
     for (uint16_t offset = 0; offset < SSD1306_BUFFER_SIZE; offset += SSD1306_CHUNK_SIZE) {
@@ -240,6 +444,11 @@ SSD1306_Status SSD1306_UpdateScreen(SSD1306_Handle *hd) {
         }
     }
     
+#if SSD1306_PARTIAL_UPDATES
+    memcpy(hd->shadow, hd->framebuffer, SSD1306_BUFFER_SIZE);
+    hd->shadow_valid = true;
+#endif
+    
     return SSD1306_OK;
 }
 
@@ -249,33 +458,34 @@ SSD1306_Status SSD1306_UpdateScreen_DMA(SSD1306_Handle *hd) {
     if (!hd || !hd->initialized) return SSD1306_ERROR;
     if (hd->dma_busy) return SSD1306_ERROR_BUSY;
     
-    // Get buffer from triple-buffer system
-    if (!Display_StartTransfer()) {
+    // Oldest queued frame (stays queued until the transfer completes)
+    uint8_t *frame = FrameQueue_Consume(NULL);
+    if (!frame) {
         return SSD1306_ERROR;  // No frame ready
     }
     
-    // Set address window (blocking, but fast)
-    if (SSD1306_SetAddressWindow(hd) != SSD1306_OK) {
-        Display_TransferComplete();
-        return SSD1306_ERROR;
+    uint8_t count = SSD1306_PlanWindows(hd, frame);
+    if (count == 0) {
+        // Panel already shows it - presented with nothing to send
+        hd->stats.unchanged_frames++;
+        FrameQueue_Release();
+        if (hd->transfer_hook) {
+            hd->transfer_hook(hd->transfer_hook_ctx);
+        }
+        return SSD1306_OK;
     }
     
+    hd->tx_frame = frame;
+    hd->window_next = 0;
+    hd->window_count = count;
     hd->dma_busy = true;
     
-    // Start DMA transfer using HAL memory write
-    HAL_StatusTypeDef result = HAL_I2C_Mem_Write_DMA(
-        hd->hi2c,
-        SSD1306_I2C_ADDR,
-        0x40,                       // Data mode register
-        I2C_MEMADD_SIZE_8BIT,
-        Display_GetTransferBuffer(),
-        SSD1306_BUFFER_SIZE
-    );
-    
-    if (result != HAL_OK) {
+    // The completion callbacks chain the rest of the frame
+    if (SSD1306_StartWindow(hd) != SSD1306_OK) {
+        // Frame stays queued for a retry, sent whole
+        hd->shadow_valid = false;
+        hd->window_count = 0;
         hd->dma_busy = false;
-        hd->last_error = SSD1306_ERROR_I2C;
-        Display_TransferComplete();
         return SSD1306_ERROR_I2C;
     }
     
@@ -287,21 +497,50 @@ bool SSD1306_IsDMABusy(SSD1306_Handle *hd) {
     return hd->dma_busy;
 }
 
+void SSD1306_SetTransferHook(SSD1306_Handle *hd, SSD1306_TransferHook hook, void *ctx) {
+    if (!hd) return;
+    hd->transfer_hook = hook;
+    hd->transfer_hook_ctx = ctx;
+}
+
 void SSD1306_DMA_CompleteCallback(SSD1306_Handle *hd, I2C_HandleTypeDef *hi2c) {
     (void)hi2c;  // Unused - could verify handle match if needed
-    if (!hd) return;
+    if (!hd || !hd->dma_busy) return;
+    
+    // Address set - send the window's data
+    if (!hd->data_phase) {
+        if (SSD1306_StartWindowData(hd) != SSD1306_OK) {
+            SSD1306_AbortFrame(hd);
+        }
+        return;
+    }
+    
+    hd->stats.bus_cycles += Perf_GetCycles() - hd->window_started;
     
+    // Next window's address commands
+    if (++hd->window_next < hd->window_count) {
+        if (SSD1306_StartWindow(hd) != SSD1306_OK) {
+            SSD1306_AbortFrame(hd);
+        }
+        return;
+    }
+    
+    hd->window_count = 0;
+    hd->window_next = 0;
+    hd->stats.frames++;
     hd->dma_busy = false;
-    Display_TransferComplete();
+    FrameQueue_Release();
+    
+    if (hd->transfer_hook) {
+        hd->transfer_hook(hd->transfer_hook_ctx);
+    }
 }
 
 void SSD1306_DMA_ErrorCallback(SSD1306_Handle *hd, I2C_HandleTypeDef *hi2c) {
     (void)hi2c;
     if (!hd) return;
     
-    hd->dma_busy = false;
-    hd->last_error = SSD1306_ERROR_I2C;
-    Display_TransferComplete();
+    SSD1306_AbortFrame(hd);
 }
 
 /* ========================== Font Data ========================== */
@@ -374,7 +613,7 @@ static const uint8_t Font5x7_Data[] = {
     0x07, 0x08, 0x70, 0x08, 0x07,  // Y
     0x61, 0x51, 0x49, 0x45, 0x43,  // Z
     0x00, 0x7F, 0x41, 0x41, 0x00,  // [
-    0x02, 0x04, 0x08, 0x10, 0x20,  // \
+    0x02, 0x04, 0x08, 0x10, 0x20,  // Backslash
     0x00, 0x41, 0x41, 0x7F, 0x00,  // ]
     0x04, 0x02, 0x01, 0x02, 0x04,  // ^
     0x40, 0x40, 0x40, 0x40, 0x40,  // _
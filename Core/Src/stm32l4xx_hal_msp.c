@@ -3,6 +3,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
 /* USER CODE BEGIN Includes */
+#include "audio_dac.h"
 
 /* USER CODE END Includes */
 extern DMA_HandleTypeDef hdma_dac_ch1;
@@ -104,8 +105,14 @@ void HAL_DAC_MspInit(DAC_HandleTypeDef* hdac)
     hdma_dac_ch1.Init.Direction = DMA_MEMORY_TO_PERIPH;
     hdma_dac_ch1.Init.PeriphInc = DMA_PINC_DISABLE;
     hdma_dac_ch1.Init.MemInc = DMA_MINC_ENABLE;
+#if AUDIO_DAC_PACKED
+    /* Packed L|R words to DHR12RD */
+    hdma_dac_ch1.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+    hdma_dac_ch1.Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+#else
     hdma_dac_ch1.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
     hdma_dac_ch1.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+#endif
     hdma_dac_ch1.Init.Mode = DMA_CIRCULAR;
     hdma_dac_ch1.Init.Priority = DMA_PRIORITY_VERY_HIGH;
     if (HAL_DMA_Init(&hdma_dac_ch1) != HAL_OK)
@@ -115,6 +122,7 @@ void HAL_DAC_MspInit(DAC_HandleTypeDef* hdac)
 
     __HAL_LINKDMA(hdac,DMA_Handle1,hdma_dac_ch1);
 
+#if !AUDIO_DAC_PACKED
     /* DAC_CH2 Init */
     hdma_dac_ch2.Instance = DMA2_Channel5;
     hdma_dac_ch2.Init.Request = DMA_REQUEST_3;
@@ -131,6 +139,7 @@ void HAL_DAC_MspInit(DAC_HandleTypeDef* hdac)
     }
 
     __HAL_LINKDMA(hdac,DMA_Handle2,hdma_dac_ch2);
+#endif
 
     /* DAC1 interrupt Init */
     HAL_NVIC_SetPriority(TIM6_DAC_IRQn, 0, 0);
@@ -167,7 +176,9 @@ void HAL_DAC_MspDeInit(DAC_HandleTypeDef* hdac)
 
     /* DAC1 DMA DeInit */
     HAL_DMA_DeInit(hdac->DMA_Handle1);
+#if !AUDIO_DAC_PACKED
     HAL_DMA_DeInit(hdac->DMA_Handle2);
+#endif
 
     /* DAC1 interrupt DeInit */
     /* USER CODE BEGIN DAC1:TIM6_DAC_IRQn disable */
@@ -0,0 +1,11 @@
+/**
+ * @file    host.c
+ * @brief   Host stand-in state shared by the host tests
+ * @author  David Leathers
+ * @date    November 2025
+ */
+
+#include "stm32l4xx.h"
+
+DWT_Type g_host_dwt;
+void (*g_host_irq)(void);
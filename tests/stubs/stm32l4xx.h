@@ -0,0 +1,63 @@
+/**
+ * @file    stm32l4xx.h
+ * @brief   Host stand-in for the CMSIS device header (host tests only)
+ * @author  David Leathers
+ * @date    November 2025
+ * 
+ * Provides only what the modules under test touch: the DWT cycle counter
+ * and the Cortex-M intrinsics, in portable C. Every read of DWT advances
+ * the cycle counter, so Perf_DelayMicros() and other busy-waits finish,
+ * and then runs g_host_irq if a test set one. Driver code waits on DWT, so
+ * that is where a test delivers its simulated interrupts (e.g. DMA
+ * complete).
+ */
+
+#ifndef STM32L4XX_H
+#define STM32L4XX_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define __IO    volatile
+
+/* ========================== Core Peripherals ========================== */
+
+typedef struct {
+    __IO uint32_t CTRL;
+    __IO uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+    uint32_t pin_state;
+} GPIO_TypeDef;
+
+// Defined in stubs/host.c
+extern DWT_Type g_host_dwt;
+extern void (*g_host_irq)(void);
+
+static inline DWT_Type* Host_DWT(void) {
+    g_host_dwt.CYCCNT++;
+    if (g_host_irq) g_host_irq();
+    return &g_host_dwt;
+}
+
+#define DWT     (Host_DWT())
+
+/* ========================== Intrinsics ========================== */
+
+static inline void __NOP(void) {}
+
+static inline void __DMB(void) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline int32_t Host_SSAT(int32_t value, uint32_t bits) {
+    int32_t max = (int32_t)((1u << (bits - 1)) - 1);
+    return (value > max) ? max : (value < -max - 1) ? -max - 1 : value;
+}
+
+#define __SSAT(value, bits)     Host_SSAT((value), (bits))
+#define __PKHBT(a, b, shift)    (((uint32_t)(a) & 0x0000FFFFu) | \
+                                 (((uint32_t)(b) << (shift)) & 0xFFFF0000u))
+
+#endif // STM32L4XX_H
@@ -0,0 +1,441 @@
+/**
+ * @file    test_adpcm.c
+ * @brief   IMA ADPCM decoder against a reference decoder (host)
+ * @author  David Leathers
+ * @date    November 2025
+ * 
+ * Encodes a synthetic stereo track into 512-byte blocks with a C port of
+ * the process_audio.py encoder, and decodes it once with a textbook IMA
+ * (DVI) reference decoder. media_file_reader.c is included to reach
+ * Media_AdpcmDecode() and the refill path; the SD and FAT calls it makes
+ * are served from an in-memory disk.
+ * 
+ * Checks Media_AdpcmDecode() on whole blocks and on blocks split at odd
+ * sample positions (including the state-only advance), then the refill:
+ * sequential reads of odd sizes that end mid-block and continue from the
+ * held tail (each block must be read from the card exactly once), split
+ * and packed outputs, seeks into the middle of a block, and the partial
+ * last block followed by silence. DAC codes must match the reference
+ * exactly.
+ */
+
+#include "../Core/Src/media_file_reader.c"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1); \
+    } \
+} while (0)
+
+/* ========================== Track ========================== */
+
+#define TRACK_BLOCKS        12
+#define TRACK_SAMPLES       ((TRACK_BLOCKS - 1) * MEDIA_ADPCM_BLOCK_SAMPLES + 317)  // Odd tail
+#define DATA_SECTOR         16          // Cluster 2
+#define SECTORS_PER_CLUSTER 4
+#define DISK_SECTORS        (DATA_SECTOR + 1 + TRACK_BLOCKS + SECTORS_PER_CLUSTER)
+#define MAX_READ            MAX_AUDIO_READ_SAMPLES
+
+static int16_t s_pcm[TRACK_SAMPLES][2];
+static int16_t s_ref[TRACK_SAMPLES][2];
+static uint8_t s_disk[DISK_SECTORS][SD_BLOCK_SIZE] __attribute__((aligned(4)));
+
+static uint16_t s_left[MAX_READ], s_right[MAX_READ];
+static uint32_t s_packed[MAX_READ];
+
+static uint32_t s_rng = 0x2468ACE1;
+
+static uint32_t Rand32(void) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+/* ========================== Reference Codec ========================== */
+
+// IMA/DVI tables, as published (independent of the firmware's copies)
+static const int16_t s_ref_step[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
+    34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143,
+    157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+    724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
+    3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+static const int8_t s_ref_index[16] = { -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8 };
+
+typedef struct {
+    int32_t valpred;
+    int32_t index;
+} Ref_State;
+
+// One code, in the form of the IMA reference implementation
+static int16_t Ref_Decode(Ref_State *st, uint32_t delta) {
+    int32_t step = s_ref_step[st->index];
+    int32_t vpdiff = step >> 3;
+    
+    if (delta & 4) vpdiff += step;
+    if (delta & 2) vpdiff += step >> 1;
+    if (delta & 1) vpdiff += step >> 2;
+    
+    st->valpred += (delta & 8) ? -vpdiff : vpdiff;
+    if (st->valpred > 32767) st->valpred = 32767;
+    if (st->valpred < -32768) st->valpred = -32768;
+    
+    st->index += s_ref_index[delta];
+    if (st->index < 0) st->index = 0;
+    if (st->index > 88) st->index = 88;
+    return (int16_t)st->valpred;
+}
+
+// process_audio.py ima_encode_sample(): code chosen against the decoder state
+static uint32_t Ref_Encode(Ref_State *st, int32_t sample) {
+    int32_t step = s_ref_step[st->index];
+    int32_t diff = sample - st->valpred;
+    uint32_t code = 0;
+    
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+    if (diff >= step) {
+        code |= 4;
+        diff -= step;
+    }
+    if (diff >= step >> 1) {
+        code |= 2;
+        diff -= step >> 1;
+    }
+    if (diff >= step >> 2) {
+        code |= 1;
+    }
+    
+    Ref_Decode(st, code);
+    return code;
+}
+
+/**
+ * @brief Synthesize the track: ramps, noise and full-scale squares (clipping)
+ */
+static void Track_Generate(void) {
+    for (uint32_t i = 0; i < TRACK_SAMPLES; i++) {
+        uint32_t section = (i / 700) % 4;
+        int32_t l, r;
+        
+        switch (section) {
+            case 0:
+                l = (int32_t)((i * 97) % 4096) * 8 - 16384;
+                r = -l / 2;
+                break;
+            case 1:
+                l = (int16_t)Rand32();
+                r = (int16_t)Rand32() / 16;
+                break;
+            case 2:
+                l = ((i / 9) & 1) ? 32767 : -32768;
+                r = ((i / 31) & 1) ? 30000 : -30000;
+                break;
+            default:
+                l = (int32_t)(i % 3) - 1;
+                r = 0;
+                break;
+        }
+        s_pcm[i][0] = (int16_t)l;
+        s_pcm[i][1] = (int16_t)r;
+    }
+}
+
+/**
+ * @brief Encode the track into the disk image, then reference-decode it
+ * 
+ * Block layout as combine_files.py writes it: per-channel header, one
+ * byte per stereo sample (low nibble left), last block zero padded.
+ */
+static void Track_Encode(void) {
+    Ref_State enc[2] = { { 0, 0 }, { 0, 0 } };
+    
+    for (uint32_t b = 0; b < TRACK_BLOCKS; b++) {
+        uint8_t *block = s_disk[DATA_SECTOR + 1 + b];
+        
+        for (int ch = 0; ch < 2; ch++) {
+            block[ch * 4 + 0] = (uint8_t)enc[ch].valpred;
+            block[ch * 4 + 1] = (uint8_t)(enc[ch].valpred >> 8);
+            block[ch * 4 + 2] = (uint8_t)enc[ch].index;
+            block[ch * 4 + 3] = 0;
+        }
+        
+        for (uint32_t i = 0; i < MEDIA_ADPCM_BLOCK_SAMPLES; i++) {
+            uint32_t sample = b * MEDIA_ADPCM_BLOCK_SAMPLES + i;
+            uint8_t byte = 0;
+            
+            if (sample < TRACK_SAMPLES) {
+                byte = (uint8_t)(Ref_Encode(&enc[0], s_pcm[sample][0]) |
+                                 (Ref_Encode(&enc[1], s_pcm[sample][1]) << 4));
+            }
+            block[MEDIA_ADPCM_BLOCK_HEADER + i] = byte;
+        }
+    }
+    
+    for (uint32_t b = 0; b < TRACK_BLOCKS; b++) {
+        const uint8_t *block = s_disk[DATA_SECTOR + 1 + b];
+        Ref_State dec[2];
+        
+        for (int ch = 0; ch < 2; ch++) {
+            dec[ch].valpred = (int16_t)(block[ch * 4] | (block[ch * 4 + 1] << 8));
+            dec[ch].index = block[ch * 4 + 2];
+        }
+        for (uint32_t i = 0; i < MEDIA_ADPCM_BLOCK_SAMPLES; i++) {
+            uint32_t sample = b * MEDIA_ADPCM_BLOCK_SAMPLES + i;
+            if (sample == TRACK_SAMPLES) break;
+            
+            uint8_t byte = block[MEDIA_ADPCM_BLOCK_HEADER + i];
+            s_ref[sample][0] = Ref_Decode(&dec[0], byte & 0x0F);
+            s_ref[sample][1] = Ref_Decode(&dec[1], byte >> 4);
+        }
+    }
+}
+
+// Reference sample -> 12-bit DAC code at gain (DAC_SILENCE past the track)
+static uint16_t Ref_Dac(uint32_t sample, int ch, int32_t gain) {
+    if (sample >= TRACK_SAMPLES) return DAC_SILENCE;
+    return (uint16_t)((((s_ref[sample][ch] * gain) >> 16) + 32768) >> 4);
+}
+
+/* ========================== SD / FAT ========================== */
+
+static SD_Handle s_sd;
+static FAT_Volume s_vol;
+static MediaFile s_media;
+static uint32_t s_stream_block;
+static uint32_t s_sectors_read;
+
+SD_Status SD_StreamOpen(SD_Handle *hsd, uint32_t start_block) {
+    (void)hsd;
+    s_stream_block = start_block;
+    return SD_OK;
+}
+
+SD_Status SD_StreamRead(SD_Handle *hsd, uint8_t *buffer, uint32_t count) {
+    (void)hsd;
+    CHECK(s_stream_block + count <= DISK_SECTORS);
+    memcpy(buffer, s_disk[s_stream_block], count * SD_BLOCK_SIZE);
+    s_stream_block += count;
+    s_sectors_read += count;
+    return SD_OK;
+}
+
+// The ADPCM path never reaches these
+SD_Status SD_StreamReadAsync(SD_Handle *hsd, uint8_t *buffer, uint32_t count,
+                             SD_AsyncCallback callback, void *context) {
+    (void)hsd; (void)buffer; (void)count; (void)callback; (void)context;
+    CHECK(0);
+    return SD_ERROR;
+}
+
+SD_Status SD_StreamClose(SD_Handle *hsd) {
+    (void)hsd;
+    return SD_OK;
+}
+
+SD_Status SD_ReadBlock(SD_Handle *hsd, uint8_t *buffer, uint32_t block) {
+    (void)hsd; (void)buffer; (void)block;
+    CHECK(0);
+    return SD_ERROR;
+}
+
+SD_AsyncState SD_AsyncPoll(SD_Handle *hsd) {
+    (void)hsd;
+    CHECK(0);
+    return SD_ASYNC_ERROR;
+}
+
+SD_Status SD_AsyncWait(SD_Handle *hsd) {
+    (void)hsd;
+    CHECK(0);
+    return SD_ERROR;
+}
+
+uint32_t FAT_ClusterToSector(FAT_Volume *vol, uint32_t cluster) {
+    return vol->boot.data_start_sector + (cluster - 2) * vol->boot.sectors_per_cluster;
+}
+
+uint32_t FAT_GetNextCluster(FAT_Volume *vol, uint32_t cluster) {
+    (void)vol; (void)cluster;
+    CHECK(0);
+    return 0;
+}
+
+FAT_Status FAT_ScanChain(FAT_Volume *vol, uint32_t first_cluster, uint32_t max_clusters,
+                         FAT_RunCallback callback, void *ctx, FAT_ScanResult *result) {
+    (void)vol; (void)first_cluster; (void)max_clusters; (void)callback; (void)ctx; (void)result;
+    CHECK(0);
+    return FAT_ERROR;
+}
+
+// One contiguous file: a header sector, then the ADPCM blocks
+static void Media_Setup(uint8_t volume) {
+    memset(&s_vol, 0, sizeof(s_vol));
+    s_vol.hsd = &s_sd;
+    s_vol.mounted = true;
+    s_vol.boot.sectors_per_cluster = SECTORS_PER_CLUSTER;
+    s_vol.boot.data_start_sector = DATA_SECTOR;
+    
+    memset(&s_media, 0, sizeof(s_media));
+    s_media.vol = &s_vol;
+    s_media.is_open = true;
+    s_media.first_cluster = 2;
+    s_media.audio_codec = MEDIA_AUDIO_ADPCM;
+    s_media.audio_offset = SD_BLOCK_SIZE;
+    s_media.audio_size = TRACK_BLOCKS * MEDIA_ADPCM_BLOCK_SIZE;
+    s_media.audio_samples = TRACK_SAMPLES;
+    s_media.file_size = s_media.audio_offset + s_media.audio_size;
+    s_media.extents[0] = (Media_Extent){ .file_cluster = 0, .start_cluster = 2,
+                                         .length = (DISK_SECTORS - DATA_SECTOR) / SECTORS_PER_CLUSTER };
+    s_media.extent_count = 1;
+    s_media.adpcm_block = MEDIA_NO_BLOCK;
+    Media_SetVolume(&s_media, volume);
+}
+
+/* ========================== Checks ========================== */
+
+static void Check_Split(uint32_t first, uint32_t count) {
+    int32_t gain = s_media.gain_q16;
+    
+    for (uint32_t i = 0; i < count; i++) {
+        CHECK(s_left[i] == Ref_Dac(first + i, 0, gain));
+        CHECK(s_right[i] == Ref_Dac(first + i, 1, gain));
+    }
+}
+
+static void Check_Packed(uint32_t first, uint32_t count) {
+    int32_t gain = s_media.gain_q16;
+    
+    for (uint32_t i = 0; i < count; i++) {
+        CHECK((s_packed[i] & 0xFFFF) == Ref_Dac(first + i, 0, gain));
+        CHECK((s_packed[i] >> 16) == Ref_Dac(first + i, 1, gain));
+    }
+}
+
+/* ========================== Tests ========================== */
+
+// Direct decode: whole blocks, and blocks split at odd positions
+static void Test_Decode(void) {
+    static const uint32_t splits[] = { 1, 2, 3, 251, 252, 253, 502, 503 };
+    int32_t gain = s_media.gain_q16;
+    
+    for (uint32_t b = 0; b < TRACK_BLOCKS; b++) {
+        const uint8_t *block = s_disk[DATA_SECTOR + 1 + b];
+        uint32_t first = b * MEDIA_ADPCM_BLOCK_SAMPLES;
+        
+        Media_AdpcmDecode(&s_media, block, 0, MEDIA_ADPCM_BLOCK_SAMPLES, s_left, s_right, 1, gain);
+        Check_Split(first, (first + MEDIA_ADPCM_BLOCK_SAMPLES <= TRACK_SAMPLES) ?
+                           MEDIA_ADPCM_BLOCK_SAMPLES : TRACK_SAMPLES - first);
+        
+        for (uint32_t s = 0; s < sizeof(splits) / sizeof(splits[0]); s++) {
+            uint32_t at = splits[s];
+            uint32_t rest = MEDIA_ADPCM_BLOCK_SAMPLES - at;
+            
+            // Decode the head, then the rest from the carried state
+            memset(s_left, 0, sizeof(s_left));
+            Media_AdpcmDecode(&s_media, block, 0, at, s_left, s_right, 1, gain);
+            Media_AdpcmDecode(&s_media, block, at, rest, &s_left[at], &s_right[at], 1, gain);
+            if (first + MEDIA_ADPCM_BLOCK_SAMPLES <= TRACK_SAMPLES) {
+                Check_Split(first, MEDIA_ADPCM_BLOCK_SAMPLES);
+            }
+            
+            // State-only advance (seek), then decode the rest
+            memset(s_left, 0, sizeof(s_left));
+            Media_AdpcmDecode(&s_media, block, 0, at, NULL, NULL, 0, gain);
+            Media_AdpcmDecode(&s_media, block, at, rest, s_left, s_right, 1, gain);
+            if (first + MEDIA_ADPCM_BLOCK_SAMPLES <= TRACK_SAMPLES) {
+                Check_Split(first + at, rest);
+            }
+        }
+    }
+}
+
+// Sequential refills of odd sizes: held tails, each block read once
+static void Test_Sequential(void) {
+    static const uint32_t counts[] = { 1, 2, 501, 503, 504, 505, 7, 1009, MAX_READ, 3, 333 };
+    uint32_t pos = 0;
+    uint32_t held = 0;
+    
+    s_sectors_read = 0;
+    for (uint32_t r = 0; pos < TRACK_SAMPLES; r++) {
+        uint32_t count = counts[r % (sizeof(counts) / sizeof(counts[0]))];
+        
+        CHECK(Media_ReadAudioStereo(&s_media, s_left, s_right, count) == FAT_OK);
+        Check_Split(pos, count);
+        
+        pos = (pos + count < TRACK_SAMPLES) ? pos + count : TRACK_SAMPLES;
+        CHECK(s_media.current_sample == pos);
+        if (s_media.adpcm_block != MEDIA_NO_BLOCK) held++;
+    }
+    
+    // Past the end: silence, no reads
+    CHECK(Media_ReadAudioStereo(&s_media, s_left, s_right, 600) == FAT_OK);
+    Check_Split(TRACK_SAMPLES, 600);
+    
+    CHECK(held > 0);
+    CHECK(s_sectors_read == TRACK_BLOCKS);
+}
+
+// Packed output, including a refill that spans several whole blocks
+static void Test_Packed(void) {
+    static const uint32_t counts[] = { 333, 1511, 5, MAX_READ };
+    uint32_t pos = 0;
+    
+    s_media.current_sample = 0;
+    s_media.adpcm_block = MEDIA_NO_BLOCK;
+    for (uint32_t r = 0; pos < TRACK_SAMPLES; r++) {
+        uint32_t count = counts[r % (sizeof(counts) / sizeof(counts[0]))];
+        
+        CHECK(Media_ReadAudioPacked(&s_media, s_packed, count) == FAT_OK);
+        Check_Packed(pos, count);
+        pos = (pos + count < TRACK_SAMPLES) ? pos + count : TRACK_SAMPLES;
+    }
+}
+
+// Seeks into a block: the held tail is dropped and the state rebuilt
+static void Test_Seek(void) {
+    const uint32_t seeks[] = { 1, 503, 504, 505, 1511, 2 * MEDIA_ADPCM_BLOCK_SAMPLES - 1,
+                               TRACK_SAMPLES - 317, TRACK_SAMPLES - 2, TRACK_SAMPLES - 1, 0 };
+    
+    for (uint32_t s = 0; s < sizeof(seeks) / sizeof(seeks[0]); s++) {
+        s_media.current_sample = seeks[s];
+        CHECK(Media_ReadAudioStereo(&s_media, s_left, s_right, 700) == FAT_OK);
+        Check_Split(seeks[s], 700);
+        
+        // Continue from what the seek left held
+        uint32_t pos = s_media.current_sample;
+        CHECK(Media_ReadAudioStereo(&s_media, s_left, s_right, 211) == FAT_OK);
+        Check_Split(pos, 211);
+    }
+}
+
+/* ========================== Main ========================== */
+
+int main(void) {
+    static const uint8_t volumes[] = { 100, 77, 0 };
+    
+    Track_Generate();
+    Track_Encode();
+    
+    for (uint32_t v = 0; v < sizeof(volumes); v++) {
+        Media_Setup(volumes[v]);
+        Test_Decode();
+        
+        Media_Setup(volumes[v]);
+        Test_Sequential();
+        Test_Packed();
+        Test_Seek();
+    }
+    
+    printf("test_adpcm: %u samples in %u blocks, decoder and refills match reference OK\n",
+           (unsigned)TRACK_SAMPLES, (unsigned)TRACK_BLOCKS);
+    return 0;
+}
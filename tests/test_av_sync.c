@@ -0,0 +1,169 @@
+/**
+ * @file    test_av_sync.c
+ * @brief   A/V sync timebase over an hour of playback (host)
+ * @author  David Leathers
+ * @date    November 2025
+ * 
+ * Drives av_sync.c from a sample-exact clock source and walks every audio
+ * sample of SIM_SECONDS of playback at 32 kHz, for 30/1 and 30000/1001
+ * fps. At each sample AVSync_GetCurrentFrame() must equal the exact floor
+ * of samples * fps_num / (sample_rate * fps_den), computed here in
+ * 128-bit, so the frame clock never gains or loses against the audio. Each
+ * frame boundary must fall on AVSync_GetFrameDueSample(), which must lie
+ * within one sample of the ideal (real-valued) due time, and converting
+ * frame -> sample -> frame must give back the same frame.
+ * 
+ * Also plays the hour through AVSync_AudioTick() in half-ring ticks with
+ * a main loop following AVSync_GetFrameDecision(), and checks that video
+ * holds a fixed lead on the audio frame from start to end.
+ */
+
+#include "av_sync.h"
+#include "buffers.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1); \
+    } \
+} while (0)
+
+#define SAMPLE_RATE         32000
+#define SIM_SECONDS         3660        // One hour, plus a minute
+#define SIM_SAMPLES         ((uint32_t)SAMPLE_RATE * SIM_SECONDS)
+
+typedef struct {
+    uint32_t num;
+    uint32_t den;
+} Rate;
+
+static const Rate s_rates[] = { { 30, 1 }, { 30000, 1001 } };
+
+/* ========================== Clock ========================== */
+
+static uint32_t s_clock;
+
+static uint32_t Host_Clock(void *ctx) {
+    return *(const uint32_t*)ctx;
+}
+
+// Independent reference: floor(samples * num / (rate * den))
+static uint32_t Ref_Frame(uint32_t samples, const Rate *r) {
+    unsigned __int128 n = (unsigned __int128)samples * r->num;
+    return (uint32_t)(n / ((unsigned __int128)SAMPLE_RATE * r->den));
+}
+
+/* ========================== Tests ========================== */
+
+// Every sample of the hour: exact frame, frame boundaries on the due samples
+static void Test_Timebase(const Rate *r) {
+    AVSync_Handle sync;
+    uint32_t frame = 0;
+    
+    AVSync_InitRational(&sync, SAMPLE_RATE, r->num, r->den, 0);
+    s_clock = 1000;                             // Arbitrary DMA position at start
+    AVSync_SetClockSource(&sync, Host_Clock, &s_clock);
+    AVSync_Start(&sync);
+    
+    CHECK(AVSync_GetFrameDueSample(&sync, 0) == 0);
+    CHECK(AVSync_GetCurrentFrame(&sync) == 0);
+    
+    for (uint32_t pos = 1; pos <= SIM_SAMPLES; pos++) {
+        s_clock = 1000 + pos;
+        uint32_t now = AVSync_GetCurrentFrame(&sync);
+        
+        CHECK(now == Ref_Frame(pos, r));
+        if (now != frame) {
+            CHECK(now == frame + 1);
+            CHECK(AVSync_GetFrameDueSample(&sync, now) == pos);
+            frame = now;
+        }
+    }
+    
+    // No cumulative drift: the hour ends on the exact frame count
+    CHECK(frame == (uint32_t)((uint64_t)SIM_SAMPLES * r->num / ((uint64_t)SAMPLE_RATE * r->den)));
+    CHECK(AVSync_GetCurrentDrift(&sync) == -(int32_t)frame);
+}
+
+// Frame -> sample -> frame for every frame of the hour
+static void Test_RoundTrip(const Rate *r) {
+    AVSync_Handle sync;
+    uint32_t frames = Ref_Frame(SIM_SAMPLES, r);
+    
+    AVSync_InitRational(&sync, SAMPLE_RATE, r->num, r->den, 0);
+    s_clock = 0;
+    AVSync_SetClockSource(&sync, Host_Clock, &s_clock);
+    AVSync_Start(&sync);
+    
+    for (uint32_t f = 1; f <= frames; f++) {
+        uint32_t due = AVSync_GetFrameDueSample(&sync, f);
+        
+        // Within one sample of f * rate * den / num, rounded up
+        uint64_t ideal = (uint64_t)f * SAMPLE_RATE * r->den;
+        CHECK((uint64_t)due * r->num >= ideal);
+        CHECK((uint64_t)(due - 1) * r->num < ideal);
+        
+        s_clock = due;
+        CHECK(AVSync_GetCurrentFrame(&sync) == f);
+        s_clock = due - 1;
+        CHECK(AVSync_GetCurrentFrame(&sync) == f - 1);
+    }
+}
+
+// Half-ring ticks and a main loop that follows the decisions
+static void Test_Playback(const Rate *r) {
+    AVSync_Handle sync;
+    uint32_t tick = AUDIO_SEGMENT_COUNT * AUDIO_SEGMENT_SAMPLES / 2;
+    
+    AVSync_InitRational(&sync, SAMPLE_RATE, r->num, r->den, 0);
+    AVSync_Start(&sync);
+    
+    for (uint32_t pos = 0; pos + tick <= SIM_SAMPLES; pos += tick) {
+        AVSync_AudioTick(&sync, tick);
+        
+        // Render until video is as far ahead as the sync allows
+        for (;;) {
+            AVSync_Decision decision = AVSync_GetFrameDecision(&sync);
+            if (decision == AVSYNC_REPEAT_FRAME) break;
+            CHECK(decision != AVSYNC_NOT_STARTED);
+            
+            if (decision == AVSYNC_SKIP_FRAME) {
+                AVSync_FrameSkipped(&sync);
+            } else {
+                AVSync_FrameRendered(&sync);
+            }
+        }
+        
+        // The lead is fixed, so video tracks the audio frame exactly
+        CHECK(sync.video_frames_rendered ==
+              AVSync_GetPresentFrame(&sync) + sync.max_drift_frames + 1);
+    }
+    
+    CHECK(AVSync_GetAudioPosition(&sync) == SIM_SAMPLES / tick * tick);
+    CHECK(AVSync_GetCurrentFrame(&sync) == Ref_Frame(AVSync_GetAudioPosition(&sync), r));
+    CHECK(sync.stats.frames_skipped == 0);
+}
+
+/* ========================== Main ========================== */
+
+int main(void) {
+    for (uint32_t i = 0; i < sizeof(s_rates) / sizeof(s_rates[0]); i++) {
+        const Rate *r = &s_rates[i];
+        uint32_t frames = Ref_Frame(SIM_SAMPLES, r);
+        
+        Test_Timebase(r);
+        Test_RoundTrip(r);
+        Test_Playback(r);
+        
+        // What a truncated samples-per-frame would have drifted by
+        uint32_t truncated = SIM_SAMPLES / (SAMPLE_RATE * r->den / r->num);
+        
+        printf("test_av_sync: %lu/%lu fps, %lu frames in %u s, no drift "
+               "(truncated samples/frame: %+ld frames) OK\n",
+               (unsigned long)r->num, (unsigned long)r->den, (unsigned long)frames,
+               (unsigned)SIM_SECONDS, (long)truncated - (long)frames);
+    }
+    return 0;
+}
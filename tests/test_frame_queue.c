@@ -0,0 +1,125 @@
+/**
+ * @file    test_frame_queue.c
+ * @brief   Two-thread stress test of the frame queue (host)
+ * @author  David Leathers
+ * @date    November 2025
+ * 
+ * A producer thread plays the renderer and a consumer thread plays the
+ * display DMA, both spinning on the buffers.h inline API with its own
+ * __atomic loads and stores. Each frame fills its slot with a pattern
+ * derived from its number; the consumer checks that frames arrive in
+ * order, that no slot is handed out while still queued, and that every
+ * byte it reads was written before the frame was published.
+ * 
+ * Usage: test_frame_queue [frames]
+ */
+
+#include "buffers.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define DEFAULT_FRAMES      2000000u
+
+static uint32_t s_frames = DEFAULT_FRAMES;
+static uint32_t s_full_spins;
+static uint32_t s_empty_spins;
+
+/* ========================== Frame Pattern ========================== */
+
+static inline uint8_t Pattern_Byte(uint32_t frame, uint32_t i) {
+    return (uint8_t)(frame * 31u + i);
+}
+
+static void Pattern_Write(uint8_t *buffer, uint32_t frame) {
+    for (uint32_t i = 0; i < FRAMEBUFFER_SIZE; i++) {
+        buffer[i] = Pattern_Byte(frame, i);
+    }
+}
+
+static int Pattern_Check(const uint8_t *buffer, uint32_t frame) {
+    for (uint32_t i = 0; i < FRAMEBUFFER_SIZE; i++) {
+        if (buffer[i] != Pattern_Byte(frame, i)) return (int)i;
+    }
+    return -1;
+}
+
+/* ========================== Threads ========================== */
+
+static void* Producer(void *arg) {
+    (void)arg;
+    
+    for (uint32_t frame = 0; frame < s_frames; frame++) {
+        uint8_t *slot;
+        
+        while ((slot = FrameQueue_AcquireRender()) == NULL) {
+            s_full_spins++;
+            sched_yield();
+        }
+        
+        Pattern_Write(slot, frame);
+        FrameQueue_Publish(frame);
+    }
+    return NULL;
+}
+
+static void* Consumer(void *arg) {
+    (void)arg;
+    
+    for (uint32_t expected = 0; expected < s_frames; expected++) {
+        uint8_t *slot;
+        uint32_t frame;
+        
+        while ((slot = FrameQueue_Consume(&frame)) == NULL) {
+            s_empty_spins++;
+            sched_yield();
+        }
+        
+        uint32_t queued = FrameQueue_Count();
+        if (queued == 0 || queued > FRAMEBUFFER_COUNT) {
+            fprintf(stderr, "FAIL: %u frames queued at frame %u\n", queued, expected);
+            exit(1);
+        }
+        if (frame != expected) {
+            fprintf(stderr, "FAIL: consumed frame %u, expected %u\n", frame, expected);
+            exit(1);
+        }
+        if (slot != g_framebuffer[expected % FRAMEBUFFER_COUNT]) {
+            fprintf(stderr, "FAIL: frame %u in the wrong slot\n", expected);
+            exit(1);
+        }
+        
+        int bad = Pattern_Check(slot, frame);
+        if (bad >= 0) {
+            fprintf(stderr, "FAIL: frame %u byte %d overwritten before release\n", frame, bad);
+            exit(1);
+        }
+        
+        FrameQueue_Release();
+    }
+    return NULL;
+}
+
+/* ========================== Main ========================== */
+
+int main(int argc, char **argv) {
+    if (argc > 1) s_frames = (uint32_t)strtoul(argv[1], NULL, 0);
+    
+    Buffers_Init();
+    
+    pthread_t producer, consumer;
+    pthread_create(&consumer, NULL, Consumer, NULL);
+    pthread_create(&producer, NULL, Producer, NULL);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+    
+    if (FrameQueue_Count() != 0 || FrameQueue_Consume(NULL) != NULL) {
+        fprintf(stderr, "FAIL: queue not empty after %u frames\n", s_frames);
+        return 1;
+    }
+    
+    printf("test_frame_queue: %u frames through %u slots OK (%u full, %u empty spins)\n",
+           s_frames, FRAMEBUFFER_COUNT, s_full_spins, s_empty_spins);
+    return 0;
+}
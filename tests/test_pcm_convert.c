@@ -0,0 +1,136 @@
+/**
+ * @file    test_pcm_convert.c
+ * @brief   SIMD vs scalar PCM conversion, word for word (host)
+ * @author  David Leathers
+ * @date    November 2025
+ * 
+ * Includes media_file_reader.c to reach its static kernels and runs
+ * Media_ConvertPcmSimd() and Media_ConvertPcmScalar() over the same input:
+ * random words and the edge values (INT16_MIN/MAX, 0, +-1) in every
+ * left/right pairing, odd and even counts, stride 1 (separate left/right)
+ * and stride 2 (packed), at several volumes. The outputs, including the
+ * words past count, must match exactly.
+ * 
+ * On the host the SMULWB/SMULWT helpers use their C model, so this checks
+ * the kernel's arithmetic, packing and indexing, not the instructions.
+ */
+
+#include "../Core/Src/media_file_reader.c"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAX_SAMPLES         (AUDIO_SEGMENT_SAMPLES + 3)
+#define GUARD               8
+#define GUARD_FILL          0xA5A5
+
+static int16_t s_pcm[MAX_SAMPLES * 2] __attribute__((aligned(4)));
+static uint16_t s_simd[2][MAX_SAMPLES * 2 + GUARD] __attribute__((aligned(4)));
+static uint16_t s_scalar[2][MAX_SAMPLES * 2 + GUARD] __attribute__((aligned(4)));
+static uint32_t s_cases;
+
+static const int16_t s_edges[] = { INT16_MIN, INT16_MIN + 1, -1, 0, 1, INT16_MAX - 1, INT16_MAX };
+#define EDGE_COUNT          (sizeof(s_edges) / sizeof(s_edges[0]))
+
+static const uint32_t s_volumes[] = { 0, 1, 33, 50, 99, 100 };
+static const uint32_t s_counts[] = { 0, 1, 2, 3, 7, 127, 128, 129, 511, AUDIO_SEGMENT_SAMPLES,
+                                     MAX_SAMPLES };
+
+/* ========================== Input ========================== */
+
+static uint32_t s_rng = 0x12345678;
+
+static uint32_t Rand32(void) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static void Fill_Random(void) {
+    for (uint32_t i = 0; i < MAX_SAMPLES * 2; i++) {
+        s_pcm[i] = (int16_t)Rand32();
+    }
+}
+
+// Every (left, right) pairing of the edge values, repeated
+static void Fill_Edges(void) {
+    for (uint32_t i = 0; i < MAX_SAMPLES; i++) {
+        s_pcm[i * 2] = s_edges[i % EDGE_COUNT];
+        s_pcm[i * 2 + 1] = s_edges[(i / EDGE_COUNT) % EDGE_COUNT];
+    }
+}
+
+/* ========================== Comparison ========================== */
+
+static void Run_Case(const char *input, int32_t gain, uint32_t stride, uint32_t count) {
+    uint16_t *simd_left = s_simd[0];
+    uint16_t *simd_right = (stride == 2) ? s_simd[0] + 1 : s_simd[1];
+    uint16_t *scalar_left = s_scalar[0];
+    uint16_t *scalar_right = (stride == 2) ? s_scalar[0] + 1 : s_scalar[1];
+    
+    for (uint32_t c = 0; c < 2; c++) {
+        for (uint32_t i = 0; i < MAX_SAMPLES * 2 + GUARD; i++) {
+            s_simd[c][i] = GUARD_FILL;
+            s_scalar[c][i] = GUARD_FILL;
+        }
+    }
+    
+    Media_ConvertPcmSimd(gain, s_pcm, simd_left, simd_right, stride, count);
+    Media_ConvertPcmScalar(gain, s_pcm, scalar_left, scalar_right, stride, count);
+    s_cases++;
+    
+    for (uint32_t c = 0; c < 2; c++) {
+        for (uint32_t i = 0; i < MAX_SAMPLES * 2 + GUARD; i++) {
+            if (s_simd[c][i] == s_scalar[c][i]) continue;
+            
+            fprintf(stderr, "FAIL: %s input, gain 0x%05lx, stride %lu, count %lu: "
+                    "buffer %lu word %lu simd 0x%04x scalar 0x%04x\n",
+                    input, (unsigned long)gain, (unsigned long)stride, (unsigned long)count,
+                    (unsigned long)c, (unsigned long)i, s_simd[c][i], s_scalar[c][i]);
+            exit(1);
+        }
+    }
+}
+
+static void Run_Input(const char *input) {
+    for (uint32_t v = 0; v < sizeof(s_volumes) / sizeof(s_volumes[0]); v++) {
+        int32_t gain = ((int32_t)s_volumes[v] << 16) / 100;
+        
+        for (uint32_t n = 0; n < sizeof(s_counts) / sizeof(s_counts[0]); n++) {
+            Run_Case(input, gain, 1, s_counts[n]);
+            Run_Case(input, gain, 2, s_counts[n]);
+        }
+    }
+    
+    // Gains between the volume steps
+    for (uint32_t k = 0; k < 64; k++) {
+        int32_t gain = (int32_t)(Rand32() % 65537);
+        Run_Case(input, gain, 1 + (k & 1), MAX_SAMPLES - (k & 3));
+    }
+}
+
+/* ========================== Main ========================== */
+
+int main(void) {
+    Fill_Edges();
+    Run_Input("edge");
+    
+    for (uint32_t round = 0; round < 16; round++) {
+        Fill_Random();
+        Run_Input("random");
+    }
+    
+    // Full-scale edges map to the DAC code range ends at 100%
+    uint16_t left, right;
+    s_pcm[0] = INT16_MIN;
+    s_pcm[1] = INT16_MAX;
+    Media_ConvertPcmSimd(65536, s_pcm, &left, &right, 1, 1);
+    if (left != 0x000 || right != 0xFFF) {
+        fprintf(stderr, "FAIL: full scale gave 0x%03x/0x%03x\n", left, right);
+        return 1;
+    }
+    
+    printf("test_pcm_convert: %lu cases, SIMD and scalar outputs identical\n",
+           (unsigned long)s_cases);
+    return 0;
+}
@@ -0,0 +1,753 @@
+/**
+ * @file    test_sd_async.c
+ * @brief   SD card read state machine against a simulated card (host)
+ * @author  David Leathers
+ * @date    November 2025
+ * 
+ * The HAL SPI calls are backed by a byte-level SD card model: it parses
+ * commands clocked in on MOSI and answers on MISO with R1 responses, data
+ * tokens, 512-byte blocks and CMD12 busy. HAL_SPI_TransmitReceive_DMA()
+ * only records the transfer; the block lands, and SD_DMA_RxComplete() is
+ * called, from the g_host_irq hook after CARD_DMA_TICKS cycle counter reads,
+ * the way the SPI DMA interrupt preempts the driver while it polls.
+ * 
+ * Covers SD_Init(), CMD17 and CMD18 + CMD12 reads (blocking and driven by
+ * SD_AsyncPoll()), the interrupt doing no polled SPI, bounded poll steps,
+ * CMD12 busy, streams, slow data tokens, error tokens, DMA errors and
+ * timeouts, and the raw PCM refill in media_file_reader.c, which converts
+ * each batch under the next transfer and polls for late tokens meanwhile.
+ */
+
+#include "../Core/Src/media_file_reader.c"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1); \
+    } \
+} while (0)
+
+/* ========================== Card Model ========================== */
+
+#define CARD_BLOCKS         128
+#define CARD_DMA_TICKS      64          // Cycle counter reads per block DMA
+#define CARD_ACMD41_BUSY    2           // ACMD41 calls answered "still idle"
+#define CARD_NO_FAULT       0xFFFFFFFF
+#define CARD_ERROR_TOKEN    0x08        // Data error token: out of range
+#define CARD_STOP_BUSY      3           // Default busy bytes after CMD12
+#define CARD_DMA_MARKS      64
+
+typedef struct {
+    bool selected;                      // CS low
+    bool idle;                          // Until ACMD41 completes
+    bool app_cmd;                       // Last command was CMD55
+    uint32_t acmd41_calls;
+    
+    // Command being clocked in
+    uint8_t cmd[6];
+    uint32_t cmd_len;
+    
+    // Bytes queued on MISO
+    uint8_t out[SD_BLOCK_SIZE + 256];
+    uint32_t out_pos;
+    uint32_t out_len;
+    
+    // Read in progress
+    bool reading;
+    bool multi;
+    uint32_t next_block;
+    
+    // Block DMA in flight
+    uint8_t *dma_rx;
+    uint32_t dma_ticks;
+    uint32_t dma_count;                 // Transfers started
+    uint32_t dma_stops;                 // HAL_SPI_DMAStop() calls
+    uint32_t tx_not_ff;                 // Transfers that clocked out anything but 0xFF
+    
+    // Polled SPI traffic
+    uint32_t exchanges;                 // Bytes clocked by HAL_SPI_TransmitReceive()
+    uint32_t irq_exchanges;             // ... of which from the DMA interrupt
+    
+    // Fault injection
+    uint32_t token_delay;               // 0xFF bytes before each data token
+    uint32_t stop_busy;                 // Busy bytes after CMD12
+    uint32_t error_block;               // Block answered with an error token
+    uint32_t dma_error_at;              // Transfer number ended by SD_DMA_Error()
+    uint32_t dma_reject_at;             // Transfer number the HAL refuses to start
+    bool dma_hang;                      // Transfers never complete
+    
+    uint32_t cmd_count[64];
+} Card;
+
+static Card s_card;
+static uint8_t s_blocks[CARD_BLOCKS][SD_BLOCK_SIZE] __attribute__((aligned(4)));
+
+static SD_Handle g_sd;
+static SPI_HandleTypeDef s_hspi;
+static GPIO_TypeDef s_cs_port;
+
+static inline uint8_t Card_Byte(uint32_t block, uint32_t i) {
+    return (uint8_t)(block * 7 + i * 13 + (i >> 8));
+}
+
+static void Card_Put(uint8_t byte) {
+    CHECK(s_card.out_len < sizeof(s_card.out));
+    s_card.out[s_card.out_len++] = byte;
+}
+
+static void Card_Flush(void) {
+    s_card.out_pos = 0;
+    s_card.out_len = 0;
+}
+
+/**
+ * @brief Queue the next block of the current read: latency, token, data, CRC
+ */
+static void Card_QueueBlock(void) {
+    Card_Flush();
+    for (uint32_t i = 0; i < s_card.token_delay; i++) {
+        Card_Put(0xFF);
+    }
+    
+    if (s_card.next_block == s_card.error_block || s_card.next_block >= CARD_BLOCKS) {
+        Card_Put(CARD_ERROR_TOKEN);
+        s_card.reading = false;
+        return;
+    }
+    
+    Card_Put(SD_START_TOKEN);
+    for (uint32_t i = 0; i < SD_BLOCK_SIZE; i++) {
+        Card_Put(s_blocks[s_card.next_block][i]);
+    }
+    Card_Put(0x12);
+    Card_Put(0x34);
+    
+    s_card.next_block++;
+    s_card.reading = s_card.multi;
+}
+
+static void Card_Command(void) {
+    uint8_t cmd = s_card.cmd[0] & 0x3F;
+    uint32_t arg = ((uint32_t)s_card.cmd[1] << 24) | ((uint32_t)s_card.cmd[2] << 16) |
+                   ((uint32_t)s_card.cmd[3] << 8) | s_card.cmd[4];
+    bool app = s_card.app_cmd;
+    uint8_t r1 = s_card.idle ? SD_R1_IDLE_STATE : SD_R1_READY;
+    
+    s_card.app_cmd = false;
+    s_card.cmd_count[cmd]++;
+    
+    // Any command ends the current read; the response follows one NCR byte
+    s_card.reading = false;
+    Card_Flush();
+    Card_Put(0xFF);
+    
+    switch (cmd) {
+        case SD_CMD0:
+            s_card.idle = true;
+            Card_Put(SD_R1_IDLE_STATE);
+            break;
+        
+        case SD_CMD8:
+            Card_Put(r1);
+            Card_Put(0x00);
+            Card_Put(0x00);
+            Card_Put(0x01);
+            Card_Put((uint8_t)arg);
+            break;
+        
+        case SD_CMD55:
+            s_card.app_cmd = true;
+            Card_Put(r1);
+            break;
+        
+        case SD_ACMD41:
+            if (app && ++s_card.acmd41_calls > CARD_ACMD41_BUSY) {
+                s_card.idle = false;
+            }
+            Card_Put(s_card.idle ? SD_R1_IDLE_STATE : SD_R1_READY);
+            break;
+        
+        case SD_CMD58:
+            Card_Put(r1);
+            Card_Put(0xC0);                 // Powered up, CCS (SDHC)
+            Card_Put(0xFF);
+            Card_Put(0x80);
+            Card_Put(0x00);
+            break;
+        
+        case SD_CMD9:
+            Card_Put(r1);
+            Card_Put(0xFF);
+            Card_Put(SD_START_TOKEN);
+            for (uint32_t i = 0; i < 16; i++) {
+                Card_Put((i == 0) ? 0x40 : (i == 9) ? 0x7F : 0x00);  // CSD v2, C_SIZE 127
+            }
+            Card_Put(0x00);
+            Card_Put(0x00);
+            break;
+        
+        case SD_CMD12:
+            Card_Put(SD_R1_READY);
+            for (uint32_t i = 0; i < s_card.stop_busy; i++) {
+                Card_Put(0x00);             // Busy
+            }
+            break;
+        
+        case SD_CMD17:
+        case SD_CMD18:
+            if (arg >= CARD_BLOCKS) {
+                Card_Put(0x40);             // Parameter error
+                break;
+            }
+            Card_Put(SD_R1_READY);
+            s_card.reading = true;
+            s_card.multi = (cmd == SD_CMD18);
+            s_card.next_block = arg;
+            break;
+        
+        default:
+            Card_Put(0x04);                 // Illegal command
+            break;
+    }
+}
+
+static uint8_t Card_Exchange(uint8_t tx) {
+    if (!s_card.selected) return 0xFF;
+    
+    if (s_card.out_pos == s_card.out_len && s_card.reading) {
+        Card_QueueBlock();
+    }
+    uint8_t rx = (s_card.out_pos < s_card.out_len) ? s_card.out[s_card.out_pos++] : 0xFF;
+    
+    if (s_card.cmd_len > 0 || (tx & 0xC0) == 0x40) {
+        s_card.cmd[s_card.cmd_len++] = tx;
+        if (s_card.cmd_len == sizeof(s_card.cmd)) {
+            s_card.cmd_len = 0;
+            Card_Command();
+        }
+    }
+    return rx;
+}
+
+static void Card_ClearFaults(void) {
+    s_card.token_delay = 0;
+    s_card.stop_busy = CARD_STOP_BUSY;
+    s_card.error_block = CARD_NO_FAULT;
+    s_card.dma_error_at = CARD_NO_FAULT;
+    s_card.dma_reject_at = CARD_NO_FAULT;
+    s_card.dma_hang = false;
+}
+
+/* ========================== HAL ========================== */
+
+static bool s_in_irq;
+
+// Media refill under test: convert_samples at each block DMA start
+static MediaFile s_media;
+static bool s_media_watch;
+static uint32_t s_dma_marks;
+static uint32_t s_dma_mark[CARD_DMA_MARKS];
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state) {
+    (void)port;
+    (void)pin;
+    s_card.selected = (state == GPIO_PIN_RESET);
+    s_card.cmd_len = 0;
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive(SPI_HandleTypeDef *hspi, uint8_t *tx, uint8_t *rx,
+                                          uint16_t size, uint32_t timeout) {
+    (void)hspi;
+    (void)timeout;
+    for (uint32_t i = 0; i < size; i++) {
+        rx[i] = Card_Exchange(tx[i]);
+    }
+    s_card.exchanges += size;
+    if (s_in_irq) s_card.irq_exchanges += size;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_DMA(SPI_HandleTypeDef *hspi, uint8_t *tx, uint8_t *rx,
+                                              uint16_t size) {
+    (void)hspi;
+    CHECK(s_card.dma_rx == NULL);
+    CHECK(size == SD_BLOCK_SIZE);
+    
+    for (uint32_t i = 0; i < size; i++) {
+        if (tx[i] != 0xFF) {
+            s_card.tx_not_ff++;
+            break;
+        }
+    }
+    
+    if (++s_card.dma_count == s_card.dma_reject_at) return HAL_ERROR;
+    
+    if (s_media_watch && s_dma_marks < CARD_DMA_MARKS) {
+        s_dma_mark[s_dma_marks++] = s_media.convert_samples;
+    }
+    
+    s_card.dma_rx = rx;
+    s_card.dma_ticks = 0;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_DMAStop(SPI_HandleTypeDef *hspi) {
+    (void)hspi;
+    s_card.dma_rx = NULL;
+    s_card.dma_stops++;
+    return HAL_OK;
+}
+
+/* ========================== Interrupts ========================== */
+
+// Conversions that finished while a read was in flight
+static uint32_t s_media_seen;
+static uint32_t s_media_overlapped;
+
+static void Media_Watch(void) {
+    if (!s_media_watch || s_media.convert_samples == s_media_seen) return;
+    
+    s_media_seen = s_media.convert_samples;
+    if (SD_IsBusy(&g_sd)) s_media_overlapped++;
+}
+
+// SPI DMA interrupt: completes the transfer CARD_DMA_TICKS reads after it started
+static void Host_Irq(void) {
+    if (s_in_irq) return;
+    s_in_irq = true;
+    
+    Media_Watch();
+    
+    if (s_card.dma_rx && !s_card.dma_hang && ++s_card.dma_ticks >= CARD_DMA_TICKS) {
+        uint8_t *rx = s_card.dma_rx;
+        s_card.dma_rx = NULL;
+        
+        if (s_card.dma_count == s_card.dma_error_at) {
+            SD_DMA_Error(&g_sd);
+        } else {
+            for (uint32_t i = 0; i < SD_BLOCK_SIZE; i++) {
+                rx[i] = Card_Exchange(0xFF);
+            }
+            SD_DMA_RxComplete(&g_sd);
+        }
+    }
+    
+    s_in_irq = false;
+}
+
+/* ========================== Helpers ========================== */
+
+static uint8_t s_buffer[8][SD_BLOCK_SIZE] __attribute__((aligned(4)));
+
+static uint32_t s_callbacks;
+static SD_Status s_callback_status;
+static void *s_callback_context;
+
+static void On_ReadDone(SD_Handle *hsd, SD_Status status, void *context) {
+    CHECK(hsd == &g_sd);
+    s_callbacks++;
+    s_callback_status = status;
+    s_callback_context = context;
+}
+
+static bool Blocks_Match(const uint8_t *buffer, uint32_t first, uint32_t count) {
+    return memcmp(buffer, s_blocks[first], count * SD_BLOCK_SIZE) == 0;
+}
+
+static void Buffer_Clear(void) {
+    memset(s_buffer, 0, sizeof(s_buffer));
+}
+
+/* ========================== Tests ========================== */
+
+static void Test_Init(void) {
+    CHECK(SD_Init(&g_sd, &s_hspi, &s_cs_port, 1) == SD_OK);
+    CHECK(g_sd.info.type == SD_TYPE_V2HC);
+    CHECK(g_sd.info.high_capacity);
+    CHECK(g_sd.info.capacity == 128 * 1024);
+    CHECK(s_card.cmd_count[SD_ACMD41] == CARD_ACMD41_BUSY + 1);
+    CHECK(!s_card.selected);
+}
+
+static void Test_SingleBlock(void) {
+    uint32_t cmd12 = s_card.cmd_count[SD_CMD12];
+    
+    Buffer_Clear();
+    CHECK(SD_ReadBlock(&g_sd, s_buffer[0], 5) == SD_OK);
+    CHECK(Blocks_Match(s_buffer[0], 5, 1));
+    CHECK(s_card.cmd_count[SD_CMD12] == cmd12);
+    CHECK(g_sd.async_state == SD_ASYNC_IDLE);
+    CHECK(!s_card.selected);
+}
+
+static void Test_MultiBlock(void) {
+    uint32_t cmd12 = s_card.cmd_count[SD_CMD12];
+    uint32_t blocks = g_sd.stats.blocks_read;
+    
+    Buffer_Clear();
+    CHECK(SD_ReadMultipleBlocks(&g_sd, s_buffer[0], 20, 6) == SD_OK);
+    CHECK(Blocks_Match(s_buffer[0], 20, 6));
+    CHECK(s_card.cmd_count[SD_CMD12] == cmd12 + 1);
+    CHECK(g_sd.stats.blocks_read == blocks + 6);
+    CHECK(!s_card.selected);
+}
+
+// Slow card: the token outlasts the submit and per-poll budgets
+static void Test_AsyncSlowToken(void) {
+    uint32_t polls = 0;
+    
+    Buffer_Clear();
+    s_callbacks = 0;
+    s_card.token_delay = 40;
+    
+    CHECK(SD_ReadBlocksAsync(&g_sd, s_buffer[0], 30, 3, On_ReadDone, &s_callbacks) == SD_OK);
+    CHECK(g_sd.async_state == SD_ASYNC_WAIT_TOKEN);
+    
+    while (SD_IsBusy(&g_sd)) {
+        SD_AsyncPoll(&g_sd);
+        polls++;
+    }
+    
+    CHECK(polls > 3 * (40 / 8));
+    CHECK(g_sd.async_state == SD_ASYNC_DONE);
+    CHECK(s_callbacks == 1 && s_callback_status == SD_OK && s_callback_context == &s_callbacks);
+    CHECK(SD_AsyncWait(&g_sd) == SD_OK);
+    CHECK(g_sd.async_state == SD_ASYNC_IDLE);
+    CHECK(Blocks_Match(s_buffer[0], 30, 3));
+    CHECK(!s_card.selected);
+    
+    Card_ClearFaults();
+}
+
+// The interrupt only marks a block received; each poll is one bounded step
+static void Test_AsyncPolledSteps(void) {
+    uint32_t cmd12 = s_card.cmd_count[SD_CMD12];
+    uint32_t stop_polls = 0;
+    uint32_t max_step = 0;
+    
+    Buffer_Clear();
+    s_callbacks = 0;
+    s_card.stop_busy = 40;
+    
+    CHECK(SD_ReadBlocksAsync(&g_sd, s_buffer[0], 40, 4, On_ReadDone, NULL) == SD_OK);
+    CHECK(g_sd.async_state == SD_ASYNC_DATA);
+    
+    // Main loop busy elsewhere: only time passes, no SD_AsyncPoll()
+    for (uint32_t i = 0; i < 100000 && g_sd.async_state == SD_ASYNC_DATA; i++) {
+        (void)Perf_GetCycles();
+    }
+    
+    CHECK(g_sd.async_state == SD_ASYNC_BLOCK_DONE);
+    CHECK(SD_IsBusy(&g_sd));
+    CHECK(Blocks_Match(s_buffer[0], 40, 1));
+    CHECK(s_card.irq_exchanges == 0);
+    
+    while (SD_IsBusy(&g_sd)) {
+        uint32_t before = s_card.exchanges;
+        
+        if (g_sd.async_state == SD_ASYNC_STOP_BUSY) stop_polls++;
+        SD_AsyncPoll(&g_sd);
+        
+        if (s_card.exchanges - before > max_step) max_step = s_card.exchanges - before;
+        CHECK(s_callbacks == 0 || !SD_IsBusy(&g_sd));
+    }
+    
+    // CMD12 busy is polled across calls, a few bytes at a time
+    CHECK(stop_polls >= 40 / 8);
+    CHECK(max_step <= 16);
+    CHECK(g_sd.async_state == SD_ASYNC_DONE);
+    CHECK(Blocks_Match(s_buffer[0], 40, 4));
+    CHECK(s_card.cmd_count[SD_CMD12] == cmd12 + 1);
+    CHECK(s_callbacks == 1 && s_callback_status == SD_OK);
+    CHECK(SD_AsyncWait(&g_sd) == SD_OK);
+    CHECK(!s_card.selected);
+    
+    Card_ClearFaults();
+}
+
+static void Test_Busy(void) {
+    s_card.token_delay = 40;
+    
+    CHECK(SD_ReadBlocksAsync(&g_sd, s_buffer[0], 50, 1, NULL, NULL) == SD_OK);
+    CHECK(SD_IsBusy(&g_sd));
+    CHECK(SD_ReadBlocksAsync(&g_sd, s_buffer[1], 51, 1, NULL, NULL) == SD_ERROR_BUSY);
+    CHECK(SD_StreamOpen(&g_sd, 51) == SD_ERROR_BUSY);
+    CHECK(SD_AsyncWait(&g_sd) == SD_OK);
+    CHECK(Blocks_Match(s_buffer[0], 50, 1));
+    
+    Card_ClearFaults();
+}
+
+static void Test_Stream(void) {
+    uint32_t cmd12 = s_card.cmd_count[SD_CMD12];
+    uint32_t cmd18 = s_card.cmd_count[SD_CMD18];
+    uint32_t opens = g_sd.stats.stream_opens;
+    
+    Buffer_Clear();
+    s_callbacks = 0;
+    
+    CHECK(SD_StreamOpen(&g_sd, 60) == SD_OK);
+    CHECK(SD_StreamRead(&g_sd, s_buffer[0], 3) == SD_OK);
+    CHECK(Blocks_Match(s_buffer[0], 60, 3));
+    CHECK(s_card.selected);                         // Card held between reads
+    CHECK(g_sd.stream_next_block == 63);
+    
+    CHECK(SD_StreamReadAsync(&g_sd, s_buffer[3], 2, On_ReadDone, NULL) == SD_OK);
+    CHECK(SD_AsyncWait(&g_sd) == SD_OK);
+    CHECK(s_callbacks == 1 && s_callback_status == SD_OK);
+    CHECK(Blocks_Match(s_buffer[3], 63, 2));
+    
+    // Sequential reopen continues the same CMD18
+    CHECK(SD_StreamOpen(&g_sd, 65) == SD_OK);
+    CHECK(SD_StreamRead(&g_sd, s_buffer[0], 1) == SD_OK);
+    CHECK(Blocks_Match(s_buffer[0], 65, 1));
+    CHECK(s_card.cmd_count[SD_CMD18] == cmd18 + 1);
+    CHECK(g_sd.stats.stream_opens == opens + 1);
+    CHECK(s_card.cmd_count[SD_CMD12] == cmd12);
+    
+    // Seek: CMD12, then a new CMD18
+    CHECK(SD_StreamOpen(&g_sd, 90) == SD_OK);
+    CHECK(SD_StreamRead(&g_sd, s_buffer[0], 2) == SD_OK);
+    CHECK(Blocks_Match(s_buffer[0], 90, 2));
+    CHECK(s_card.cmd_count[SD_CMD12] == cmd12 + 1);
+    CHECK(s_card.cmd_count[SD_CMD18] == cmd18 + 2);
+    
+    // Random access ends the stream
+    CHECK(SD_ReadBlock(&g_sd, s_buffer[0], 7) == SD_OK);
+    CHECK(Blocks_Match(s_buffer[0], 7, 1));
+    CHECK(!g_sd.stream_open);
+    CHECK(s_card.cmd_count[SD_CMD12] == cmd12 + 2);
+    CHECK(!s_card.selected);
+    
+    CHECK(SD_StreamOpen(&g_sd, 100) == SD_OK);
+    CHECK(SD_StreamRead(&g_sd, s_buffer[0], 1) == SD_OK);
+    CHECK(SD_StreamClose(&g_sd) == SD_OK);
+    CHECK(!g_sd.stream_open);
+    CHECK(s_card.cmd_count[SD_CMD12] == cmd12 + 3);
+    CHECK(!s_card.selected);
+}
+
+static void Test_ErrorToken(void) {
+    uint32_t cmd12 = s_card.cmd_count[SD_CMD12];
+    
+    // CMD17: fails without CMD12, card usable afterwards
+    s_card.error_block = 9;
+    CHECK(SD_ReadBlock(&g_sd, s_buffer[0], 9) == SD_ERROR_READ);
+    CHECK(g_sd.async_state == SD_ASYNC_IDLE);
+    CHECK(s_card.cmd_count[SD_CMD12] == cmd12);
+    CHECK(!s_card.selected);
+    
+    // CMD18: blocks before the error land, then CMD12
+    s_card.error_block = 23;
+    Buffer_Clear();
+    CHECK(SD_ReadMultipleBlocks(&g_sd, s_buffer[0], 20, 6) == SD_ERROR_READ);
+    CHECK(Blocks_Match(s_buffer[0], 20, 3));
+    CHECK(s_card.cmd_count[SD_CMD12] == cmd12 + 1);
+    CHECK(!s_card.selected);
+    
+    // Stream: closed by the error
+    s_card.error_block = 82;
+    CHECK(SD_StreamOpen(&g_sd, 80) == SD_OK);
+    CHECK(SD_StreamRead(&g_sd, s_buffer[0], 4) == SD_ERROR_READ);
+    CHECK(!g_sd.stream_open);
+    CHECK(s_card.cmd_count[SD_CMD12] == cmd12 + 2);
+    CHECK(!s_card.selected);
+    
+    Card_ClearFaults();
+    CHECK(SD_ReadBlock(&g_sd, s_buffer[0], 9) == SD_OK);
+    CHECK(Blocks_Match(s_buffer[0], 9, 1));
+}
+
+static void Test_DmaFaults(void) {
+    uint32_t cmd12 = s_card.cmd_count[SD_CMD12];
+    uint32_t stops = s_card.dma_stops;
+    
+    // Second block's transfer errors: CMD12, card released
+    s_card.dma_error_at = s_card.dma_count + 2;
+    CHECK(SD_ReadMultipleBlocks(&g_sd, s_buffer[0], 10, 4) == SD_ERROR);
+    CHECK(s_card.cmd_count[SD_CMD12] == cmd12 + 1);
+    CHECK(!s_card.selected);
+    Card_ClearFaults();
+    
+    // HAL refuses to start the transfer
+    s_card.dma_reject_at = s_card.dma_count + 1;
+    CHECK(SD_ReadBlock(&g_sd, s_buffer[0], 3) == SD_ERROR);
+    CHECK(g_sd.async_state == SD_ASYNC_IDLE);
+    CHECK(!s_card.selected);
+    Card_ClearFaults();
+    
+    // Transfer never completes: SD_AsyncPoll() times it out and stops the DMA
+    s_card.dma_hang = true;
+    CHECK(SD_ReadBlock(&g_sd, s_buffer[0], 3) == SD_ERROR_TIMEOUT);
+    CHECK(s_card.dma_stops == stops + 1);
+    CHECK(!s_card.selected);
+    
+    CHECK(SD_ReadMultipleBlocks(&g_sd, s_buffer[0], 3, 2) == SD_ERROR_TIMEOUT);
+    CHECK(s_card.dma_stops == stops + 2);
+    CHECK(s_card.cmd_count[SD_CMD12] == cmd12 + 2);
+    CHECK(!s_card.selected);
+    Card_ClearFaults();
+    
+    s_card.dma_rx = NULL;
+    CHECK(SD_ReadMultipleBlocks(&g_sd, s_buffer[0], 3, 2) == SD_OK);
+    CHECK(Blocks_Match(s_buffer[0], 3, 2));
+}
+
+/* ========================== Media PCM Refill ========================== */
+
+#define MEDIA_DATA_SECTOR   16          // Cluster 2
+#define MEDIA_CLUSTERS      20
+#define MEDIA_REFILL        2048
+
+static FAT_Volume s_vol;
+static uint16_t s_left[MEDIA_REFILL], s_right[MEDIA_REFILL];
+static uint16_t s_expect[2][MEDIA_REFILL * 2];
+static uint32_t s_packed[MEDIA_REFILL];
+
+static void Media_Setup(void) {
+    memset(&s_vol, 0, sizeof(s_vol));
+    s_vol.hsd = &g_sd;
+    s_vol.mounted = true;
+    s_vol.boot.sectors_per_cluster = 4;
+    s_vol.boot.data_start_sector = MEDIA_DATA_SECTOR;
+    
+    // One extent, audio from the second sector
+    memset(&s_media, 0, sizeof(s_media));
+    s_media.vol = &s_vol;
+    s_media.is_open = true;
+    s_media.first_cluster = 2;
+    s_media.file_size = MEDIA_CLUSTERS * 4 * SD_BLOCK_SIZE;
+    s_media.audio_offset = SD_BLOCK_SIZE;
+    s_media.audio_samples = (s_media.file_size - s_media.audio_offset) / 4;
+    s_media.extents[0] = (Media_Extent){ .file_cluster = 0, .start_cluster = 2,
+                                         .length = MEDIA_CLUSTERS };
+    s_media.extent_count = 1;
+    Media_SetVolume(&s_media, 77);
+}
+
+// Expected DAC codes for samples [first, first + count), from the card image
+static void Media_Expect(uint32_t first, uint32_t count, uint32_t stride) {
+    const uint8_t *bytes = s_blocks[MEDIA_DATA_SECTOR] + s_media.audio_offset + first * 4;
+    uint16_t *left = s_expect[0];
+    uint16_t *right = (stride == 2) ? s_expect[0] + 1 : s_expect[1];
+    
+    Media_ConvertPcmScalar(s_media.gain_q16, (const int16_t*)bytes, left, right, stride, count);
+}
+
+static void Test_MediaPcmRefill(void) {
+    uint32_t batches = MEDIA_REFILL / PCM_SECTOR_SAMPLES / MEDIA_PCM_BATCH_SECTORS;
+    
+    Media_Setup();
+    
+    // Separate outputs: every batch but the last converts under a transfer
+    s_media_seen = 0;
+    s_media_overlapped = 0;
+    s_media_watch = true;
+    CHECK(Media_ReadAudioStereo(&s_media, s_left, s_right, MEDIA_REFILL) == FAT_OK);
+    s_media_watch = false;
+    
+    Media_Expect(0, MEDIA_REFILL, 1);
+    CHECK(memcmp(s_left, s_expect[0], sizeof(s_left)) == 0);
+    CHECK(memcmp(s_right, s_expect[1], sizeof(s_right)) == 0);
+    CHECK(s_media_overlapped >= batches - 1);
+    CHECK(s_media.current_sample == MEDIA_REFILL);
+    CHECK(g_sd.stream_open);
+    
+    // Packed output, continuing the same stream
+    uint32_t cmd18 = s_card.cmd_count[SD_CMD18];
+    CHECK(Media_ReadAudioPacked(&s_media, s_packed, MEDIA_REFILL) == FAT_OK);
+    Media_Expect(MEDIA_REFILL, MEDIA_REFILL, 2);
+    CHECK(memcmp(s_packed, s_expect[0], sizeof(s_packed)) == 0);
+    CHECK(s_card.cmd_count[SD_CMD18] == cmd18);
+    
+    // Unaligned position: one read, then convert
+    s_media.current_sample = 5;
+    s_media_seen = s_media.convert_samples;
+    s_media_overlapped = 0;
+    s_media_watch = true;
+    CHECK(Media_ReadAudioStereo(&s_media, s_left, s_right, MEDIA_REFILL) == FAT_OK);
+    s_media_watch = false;
+    
+    Media_Expect(5, MEDIA_REFILL, 1);
+    CHECK(memcmp(s_left, s_expect[0], sizeof(s_left)) == 0);
+    CHECK(memcmp(s_right, s_expect[1], sizeof(s_right)) == 0);
+    CHECK(s_media_overlapped == 0);
+    
+    // Error token partway: the whole segment is silence
+    s_media.current_sample = 0;
+    s_card.error_block = MEDIA_DATA_SECTOR + 1 + 5;
+    CHECK(Media_ReadAudioStereo(&s_media, s_left, s_right, MEDIA_REFILL) == FAT_ERROR_READ);
+    for (uint32_t i = 0; i < MEDIA_REFILL; i++) {
+        CHECK(s_left[i] == DAC_SILENCE && s_right[i] == DAC_SILENCE);
+    }
+    CHECK(s_media.current_sample == 0);
+    CHECK(!g_sd.stream_open);
+    Card_ClearFaults();
+    
+    CHECK(Media_ReadAudioStereo(&s_media, s_left, s_right, MEDIA_REFILL) == FAT_OK);
+    Media_Expect(0, MEDIA_REFILL, 1);
+    CHECK(memcmp(s_left, s_expect[0], sizeof(s_left)) == 0);
+    
+    CHECK(SD_StreamClose(&g_sd) == SD_OK);
+}
+
+// Late data tokens: each batch's first block starts mid-conversion of the previous one
+static void Test_MediaPcmLateToken(void) {
+    uint32_t batch_samples = MEDIA_PCM_BATCH_SECTORS * PCM_SECTOR_SAMPLES;
+    uint32_t batches = MEDIA_REFILL / batch_samples;
+    
+    Media_Setup();
+    s_card.token_delay = 40;
+    
+    s_dma_marks = 0;
+    s_media_watch = true;
+    CHECK(Media_ReadAudioStereo(&s_media, s_left, s_right, MEDIA_REFILL) == FAT_OK);
+    s_media_watch = false;
+    
+    Media_Expect(0, MEDIA_REFILL, 1);
+    CHECK(memcmp(s_left, s_expect[0], sizeof(s_left)) == 0);
+    CHECK(memcmp(s_right, s_expect[1], sizeof(s_right)) == 0);
+    CHECK(s_dma_marks == batches * MEDIA_PCM_BATCH_SECTORS);
+    
+    for (uint32_t b = 1; b < batches; b++) {
+        uint32_t converted = s_dma_mark[b * MEDIA_PCM_BATCH_SECTORS] - (b - 1) * batch_samples;
+        CHECK(converted > 0 && converted < batch_samples);
+    }
+    
+    CHECK(SD_StreamClose(&g_sd) == SD_OK);
+    Card_ClearFaults();
+}
+
+/* ========================== Main ========================== */
+
+int main(void) {
+    for (uint32_t block = 0; block < CARD_BLOCKS; block++) {
+        for (uint32_t i = 0; i < SD_BLOCK_SIZE; i++) {
+            s_blocks[block][i] = Card_Byte(block, i);
+        }
+    }
+    Card_ClearFaults();
+    g_host_irq = Host_Irq;
+    
+    Test_Init();
+    Test_SingleBlock();
+    Test_MultiBlock();
+    Test_AsyncSlowToken();
+    Test_AsyncPolledSteps();
+    Test_Busy();
+    Test_Stream();
+    Test_ErrorToken();
+    Test_DmaFaults();
+    Test_MediaPcmRefill();
+    Test_MediaPcmLateToken();
+    
+    CHECK(s_card.tx_not_ff == 0);
+    CHECK(s_card.irq_exchanges == 0);
+    
+    printf("test_sd_async: %lu commands, %lu blocks, %lu DMA transfers OK\n",
+           (unsigned long)g_sd.stats.commands, (unsigned long)g_sd.stats.blocks_read,
+           (unsigned long)s_card.dma_count);
+    return 0;
+}
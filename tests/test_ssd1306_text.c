@@ -0,0 +1,191 @@
+/**
+ * @file    test_ssd1306_text.c
+ * @brief   Glyph blitter vs per-pixel text rendering (host)
+ * @author  David Leathers
+ * @date    November 2025
+ * 
+ * Includes ssd1306.c to reach SSD1306_BlitGlyph() and renders the same
+ * text twice on random backgrounds: through SSD1306_DrawText() and
+ * SSD1306_WriteString() (byte-per-column blits), and through a reference
+ * that sets each glyph pixel with SSD1306_DrawPixel(). The buffers must be
+ * byte-identical for every y from 0 to past the bottom edge (page-aligned
+ * and not), x up to past the right edge, both colours and both text modes.
+ * 
+ * Then times both renderers on a 21-character line, aligned (y = 8) and
+ * unaligned (y = 3), and reports chars/ms. The I2C and frame queue paths
+ * are not reached and are dropped at link time.
+ */
+
+#include "../Core/Src/ssd1306.c"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1); \
+    } \
+} while (0)
+
+#define MAX_Y               (SSD1306_HEIGHT + 6)
+#define BENCH_LINES         20000
+
+static uint8_t s_blit[SSD1306_BUFFER_SIZE];
+static uint8_t s_ref[SSD1306_BUFFER_SIZE];
+static uint32_t s_cases;
+
+static const uint32_t s_xs[] = { 0, 1, 3, 7, 64, 100, 119, 122, 123, 126, 127, 128, 200 };
+
+// Printable ASCII, plus characters that map to '?'
+static const char s_text[] = " !09AZaz~{|}\x7F\x01?Hello";
+static const char s_line[] = "FPS 30.0 BUF 12 SD OK";     // 21 chars, one full line
+
+static uint32_t s_rng = 0x9E3779B9;
+
+static uint32_t Rand32(void) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static void Fill_Random(void) {
+    for (uint32_t i = 0; i < SSD1306_BUFFER_SIZE; i++) {
+        s_blit[i] = (uint8_t)Rand32();
+    }
+    memcpy(s_ref, s_blit, sizeof(s_ref));
+}
+
+/* ========================== Reference ========================== */
+
+/**
+ * @brief Draw one glyph a pixel at a time
+ * 
+ * Opaque: every pixel of the glyph box is written, WHITE glyph bits set
+ * and the rest cleared. Transparent: only glyph bits change.
+ */
+static void Ref_DrawGlyph(uint8_t *buffer, uint32_t x, uint32_t y, char c,
+                          const SSD1306_Font *font, SSD1306_Color color, SSD1306_TextMode mode) {
+    if (c < 32 || c > 126) c = '?';
+    const uint8_t *glyph = &font->data[(c - 32) * font->width];
+    
+    for (uint32_t col = 0; col < font->width; col++) {
+        for (uint32_t row = 0; row < font->height; row++) {
+            bool on = (glyph[col] >> row) & 1;
+            
+            if (on) {
+                SSD1306_DrawPixel(buffer, x + col, y + row, color);
+            } else if (mode == SSD1306_TEXT_OPAQUE) {
+                SSD1306_DrawPixel(buffer, x + col, y + row, SSD1306_COLOR_BLACK);
+            }
+        }
+    }
+}
+
+static uint32_t Ref_DrawText(uint8_t *buffer, uint32_t x, uint32_t y, const char *str,
+                             const SSD1306_Font *font, SSD1306_Color color, SSD1306_TextMode mode) {
+    while (*str && x < SSD1306_WIDTH) {
+        Ref_DrawGlyph(buffer, x, y, *str++, font, color, mode);
+        x += font->width + 1;
+    }
+    return x;
+}
+
+/* ========================== Tests ========================== */
+
+static void Test_DrawText(void) {
+    for (uint32_t y = 0; y < MAX_Y; y++) {
+        for (uint32_t i = 0; i < sizeof(s_xs) / sizeof(s_xs[0]); i++) {
+            for (int color = 0; color < 2; color++) {
+                for (int mode = 0; mode < 2; mode++) {
+                    Fill_Random();
+                    uint32_t end = SSD1306_DrawText(s_blit, s_xs[i], y, s_text, &Font_5x7,
+                                                    (SSD1306_Color)color, (SSD1306_TextMode)mode);
+                    uint32_t ref = Ref_DrawText(s_ref, s_xs[i], y, s_text, &Font_5x7,
+                                                (SSD1306_Color)color, (SSD1306_TextMode)mode);
+                    
+                    CHECK(end == ref);
+                    CHECK(memcmp(s_blit, s_ref, SSD1306_BUFFER_SIZE) == 0);
+                    s_cases++;
+                }
+            }
+        }
+    }
+}
+
+// Handle path: cursor advance and line wrap, as the old per-pixel loop did them
+static void Test_WriteString(void) {
+    SSD1306_Handle hd;
+    
+    for (uint32_t y = 0; y < MAX_Y; y++) {
+        for (int mode = 0; mode < 2; mode++) {
+            memset(&hd, 0, sizeof(hd));
+            hd.framebuffer = s_blit;
+            hd.text_mode = (SSD1306_TextMode)mode;
+            Fill_Random();
+            
+            SSD1306_SetCursor(&hd, 90, (uint8_t)y);
+            SSD1306_WriteString(&hd, "wrap across the line", &Font_5x7, SSD1306_COLOR_WHITE);
+            
+            // Reference: same cursor walk, glyphs drawn per pixel
+            uint32_t cx = 90, cy = y;
+            for (const char *p = "wrap across the line"; *p; p++) {
+                Ref_DrawGlyph(s_ref, cx, cy, *p, &Font_5x7, SSD1306_COLOR_WHITE,
+                              (SSD1306_TextMode)mode);
+                cx += Font_5x7.width + 1;
+                if (cx >= SSD1306_WIDTH - (uint32_t)Font_5x7.width) {
+                    cx = 0;
+                    cy += Font_5x7.height + 1;
+                }
+            }
+            
+            CHECK(memcmp(s_blit, s_ref, SSD1306_BUFFER_SIZE) == 0);
+            CHECK(hd.cursor_x == cx && hd.cursor_y == (uint8_t)cy);
+            s_cases++;
+        }
+    }
+}
+
+/* ========================== Benchmark ========================== */
+
+static double Now_Ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// Chars/ms for one renderer drawing s_line at y
+static double Bench(uint32_t (*draw)(uint8_t*, uint32_t, uint32_t, const char*,
+                                     const SSD1306_Font*, SSD1306_Color, SSD1306_TextMode),
+                    uint32_t y) {
+    uint32_t chars = (uint32_t)strlen(s_line);
+    double start = Now_Ms();
+    
+    for (uint32_t i = 0; i < BENCH_LINES; i++) {
+        draw(s_blit, i & 1, y, s_line, &Font_5x7, SSD1306_COLOR_WHITE, SSD1306_TEXT_OPAQUE);
+        __asm__ volatile("" ::: "memory");      // Keep every line's stores
+    }
+    
+    double ms = Now_Ms() - start;
+    return (ms > 0) ? (double)chars * BENCH_LINES / ms : 0;
+}
+
+/* ========================== Main ========================== */
+
+int main(void) {
+    // One glyph per printable character, none lost to a stray line splice
+    CHECK(sizeof(Font5x7_Data) == (126 - 32 + 1) * 5);
+    CHECK(Font5x7_Data[('\\' - 32) * 5] == 0x02 && Font5x7_Data[(']' - 32) * 5 + 1] == 0x41);
+    
+    Test_DrawText();
+    Test_WriteString();
+    
+    printf("test_ssd1306_text: %lu cases, blit and per-pixel output identical\n",
+           (unsigned long)s_cases);
+    printf("test_ssd1306_text: aligned (y=8) %.1fk chars/ms blit, %.1fk per-pixel\n",
+           Bench(SSD1306_DrawText, 8) / 1000, Bench(Ref_DrawText, 8) / 1000);
+    printf("test_ssd1306_text: unaligned (y=3) %.1fk chars/ms blit, %.1fk per-pixel OK\n",
+           Bench(SSD1306_DrawText, 3) / 1000, Bench(Ref_DrawText, 3) / 1000);
+    return 0;
+}
@@ -2,10 +2,13 @@
 """
 Bad Apple File Analyzer
 Analyzes and validates the generated media files
+Supports format v2 (20-byte header) and v3 (sector-aligned container),
+with raw or XOR/RLE delta video, PCM or IMA ADPCM audio, and separate
+or interleaved A/V layout
 
 Author: David Leathers
 Date: November 2025
-Version: 2.0.0
+Version: 3.4.0
 """
 
 import struct
@@ -16,9 +19,46 @@ import sys
 # CONSTANTS
 # ============================================================================
 
-HEADER_SIZE = 20
+HEADER_SIZE = 20         # v2 header size
 FRAME_SIZE = 1024
 
+SECTOR_SIZE = 512        # SD block size
+V3_MAGIC = b'BAV3'
+V3_MIN_HEADER = 40       # Bytes of v3 header with defined fields
+
+CODEC_RAW = 0
+CODEC_DELTA = 1
+DELTA_RECORD_HEADER = 3  # uint16 length + uint8 flags
+DELTA_FLAG_KEYFRAME = 0x01
+
+AUDIO_PCM = 0
+AUDIO_ADPCM = 1
+ADPCM_BLOCK_SIZE = 512
+ADPCM_BLOCK_HEADER = 8
+ADPCM_BLOCK_SAMPLES = ADPCM_BLOCK_SIZE - ADPCM_BLOCK_HEADER  # 504
+
+IMA_STEP_TABLE = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
+    34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143,
+    157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+    724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
+    3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+]
+IMA_INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8]
+
+LAYOUT_SEPARATE = 0
+LAYOUT_INTERLEAVED = 1
+
+DEFAULT_FPS = 30         # v2 files and v3 headers without a frame rate
+SYNC_SIM_SECONDS = 3600  # Length of the long-run A/V sync simulation
+
+DISPLAY_WIDTH = 128      # SSD1306 columns (bytes per page)
+DISPLAY_PAGES = 8        # SSD1306 pages (8 pixel rows each)
+WINDOW_SETUP_BYTES = 10  # Bus bytes per window beyond its data (ssd1306.h)
+I2C_HZ = 1000000         # Display bus clock (Fast-mode Plus)
+I2C_BITS_PER_BYTE = 9    # 8 data bits + ACK
+
 # ============================================================================
 # ANALYSIS FUNCTIONS
 # ============================================================================
@@ -44,22 +84,135 @@ def analyze_header(filename):
         return None
     
     with open(filename, 'rb') as f:
-        header_data = f.read(HEADER_SIZE)
+        header_data = f.read(SECTOR_SIZE)
     
-    # Unpack header (little-endian)
-    frame_count, audio_size, sample_rate, channels, bits_per_sample = \
-        struct.unpack('<5I', header_data)
+    if header_data[0:4] == V3_MAGIC:
+        if len(header_data) < V3_MIN_HEADER:
+            print(f"ERROR: Truncated v3 header ({len(header_data)} bytes)")
+            return None
+        
+        (version, header_size, frame_count, audio_size, sample_rate, channels,
+         bits_per_sample, video_offset, audio_offset) = \
+            struct.unpack('<9I', header_data[4:40])
+        
+        # Codec fields (zero in older v3 files = raw)
+        (video_codec, video_size, keyframe_interval, keyframe_count,
+         keyframe_table_offset) = struct.unpack('<5I', header_data[40:60])
+        if video_codec == CODEC_RAW:
+            video_size = frame_count * FRAME_SIZE
+        
+        audio_codec, audio_samples, layout, chunk_samples, chunk_fps = \
+            struct.unpack('<5I', header_data[60:80])
+        
+        # Rational frame rate (zero in older v3 files = 30 fps)
+        fps_num, fps_den = struct.unpack('<2I', header_data[80:88])
+        if fps_num == 0:
+            fps_num, fps_den = DEFAULT_FPS, 1
+    else:
+        # v2: no magic, first word is the frame count (little-endian)
+        frame_count, audio_size, sample_rate, channels, bits_per_sample = \
+            struct.unpack('<5I', header_data[0:HEADER_SIZE])
+        version = 2
+        header_size = HEADER_SIZE
+        video_offset = HEADER_SIZE
+        audio_offset = HEADER_SIZE + frame_count * FRAME_SIZE
+        video_codec = CODEC_RAW
+        video_size = frame_count * FRAME_SIZE
+        keyframe_interval = keyframe_count = keyframe_table_offset = 0
+        audio_codec = AUDIO_PCM
+        layout = LAYOUT_SEPARATE
+        chunk_samples = chunk_fps = 0
+        fps_num, fps_den = DEFAULT_FPS, 1
+    
+    if audio_codec == AUDIO_PCM:
+        bytes_per_sample = (bits_per_sample // 8) * channels
+        audio_samples = audio_size // bytes_per_sample if bytes_per_sample else 0
     
     return {
+        'version': version,
+        'header_size': header_size,
         'frame_count': frame_count,
         'audio_size': audio_size,
         'sample_rate': sample_rate,
         'channels': channels,
         'bits_per_sample': bits_per_sample,
+        'video_offset': video_offset,
+        'audio_offset': audio_offset,
+        'video_codec': video_codec,
+        'video_size': video_size,
+        'keyframe_interval': keyframe_interval,
+        'keyframe_count': keyframe_count,
+        'keyframe_table_offset': keyframe_table_offset,
+        'audio_codec': audio_codec,
+        'audio_samples': audio_samples,
+        'layout': layout,
+        'chunk_samples': chunk_samples,
+        'chunk_fps': chunk_fps,
+        'fps_num': fps_num,
+        'fps_den': fps_den,
         'file_size': file_size
     }
 
 
+def frame_rate(header):
+    """Frame rate in fps (0 if the header has an invalid denominator)"""
+    return header['fps_num'] / header['fps_den'] if header['fps_den'] else 0
+
+
+def simulate_sync(sample_rate, fps_num, fps_den, seconds):
+    """
+    Long-run simulation of the firmware's audio-master frame clock
+    
+    For every frame, finds the audio sample at which the player's current
+    frame reaches it, using both the old truncated samples-per-frame
+    (sample_rate // fps) and the rational timebase in av_sync.c
+    (samples * fps_num // (sample_rate * fps_den)). Compares each against
+    the frame's exact presentation time.
+    
+    Returns:
+        dict: timebase name -> (max |error| in ms, final error in frames)
+    """
+    frames = seconds * fps_num // fps_den
+    divisor = sample_rate * fps_den
+    spf_truncated = sample_rate * fps_den // fps_num
+    results = {}
+    
+    for name in ('truncated', 'rational'):
+        max_error = 0.0
+        error = 0.0
+        for n in range(frames + 1):
+            if name == 'truncated':
+                switch = n * spf_truncated
+            else:
+                # First sample with samples * num // divisor >= n
+                switch = -(-n * divisor // fps_num)
+            error = switch - n * divisor / fps_num    # samples (negative = early)
+            max_error = max(max_error, abs(error))
+        results[name] = (max_error * 1000 / sample_rate, error * fps_num / divisor)
+    
+    return results
+
+
+def chunk_first_frame(header, chunk):
+    """First frame carried by an interleaved chunk (mirrors the firmware)"""
+    frame = -(-chunk * header['chunk_samples'] * header['chunk_fps'] // header['sample_rate'])
+    return min(frame, header['frame_count'])
+
+
+def chunk_offset(header, chunk):
+    """File offset of an interleaved chunk"""
+    return (header['video_offset'] + chunk * header['chunk_samples'] * 4 +
+            chunk_first_frame(header, chunk) * FRAME_SIZE)
+
+
+def interleaved_chunk_count(header):
+    """Chunks needed to carry every sample and every frame"""
+    count = -(-header['audio_samples'] // header['chunk_samples'])
+    while chunk_first_frame(header, count) < header['frame_count']:
+        count += 1
+    return count
+
+
 def validate_file(filename):
     """
     Validate file structure and consistency
@@ -85,6 +238,46 @@ def validate_file(filename):
     channels = header['channels']
     bits_per_sample = header['bits_per_sample']
     file_size = header['file_size']
+    video_offset = header['video_offset']
+    audio_offset = header['audio_offset']
+    
+    # Validate container version and v3 alignment
+    if header['version'] not in [2, 3]:
+        errors.append(f"Unsupported format version ({header['version']})")
+    if header['version'] == 3:
+        if header['header_size'] < V3_MIN_HEADER or header['header_size'] > SECTOR_SIZE:
+            errors.append(f"Invalid v3 header size ({header['header_size']})")
+        if video_offset % SECTOR_SIZE != 0:
+            errors.append(f"Video offset {video_offset} not sector-aligned")
+        if audio_offset % SECTOR_SIZE != 0:
+            errors.append(f"Audio offset {audio_offset} not sector-aligned")
+        if video_offset < header['header_size']:
+            errors.append("Video region overlaps header")
+        if header['layout'] == LAYOUT_INTERLEAVED:
+            if header['video_codec'] != CODEC_RAW or header['audio_codec'] != AUDIO_PCM:
+                errors.append("Interleaved layout requires raw video and PCM audio")
+            if header['chunk_samples'] == 0 or (header['chunk_samples'] * 4) % SECTOR_SIZE:
+                errors.append(f"Chunk size {header['chunk_samples']} samples not sector-aligned")
+            if header['chunk_fps'] == 0 or sample_rate == 0:
+                errors.append("Interleaved layout needs chunk fps and sample rate")
+        elif header['layout'] != LAYOUT_SEPARATE:
+            errors.append(f"Unknown layout ({header['layout']})")
+        elif audio_offset < video_offset + header['video_size']:
+            errors.append("Audio region overlaps video region")
+        if header['video_codec'] not in [CODEC_RAW, CODEC_DELTA]:
+            errors.append(f"Unknown video codec ({header['video_codec']})")
+    
+    # Validate delta keyframe table
+    if header['video_codec'] == CODEC_DELTA:
+        interval = header['keyframe_interval']
+        table_offset = header['keyframe_table_offset']
+        table_end = table_offset + header['keyframe_count'] * 4
+        if interval == 0 or header['keyframe_count'] < (frame_count + interval - 1) // interval:
+            errors.append("Keyframe table does not cover every frame")
+        if table_offset % SECTOR_SIZE != 0:
+            errors.append(f"Keyframe table offset {table_offset} not sector-aligned")
+        if table_offset < video_offset + header['video_size'] or table_end > audio_offset:
+            errors.append("Keyframe table overlaps video or audio region")
     
     # Validate frame count
     if frame_count == 0:
@@ -107,20 +300,34 @@ def validate_file(filename):
         errors.append(f"Invalid bit depth ({bits_per_sample})")
     
     # Validate audio size alignment
-    if channels in [1, 2] and bits_per_sample in [8, 16, 24, 32]:
+    if header['audio_codec'] == AUDIO_ADPCM:
+        blocks = (header['audio_samples'] + ADPCM_BLOCK_SAMPLES - 1) // ADPCM_BLOCK_SAMPLES
+        if channels != 2:
+            errors.append("ADPCM audio must be stereo")
+        if audio_size != blocks * ADPCM_BLOCK_SIZE:
+            errors.append(f"ADPCM size {audio_size} does not match "
+                          f"{header['audio_samples']} samples ({blocks} blocks)")
+    elif header['audio_codec'] != AUDIO_PCM:
+        errors.append(f"Unknown audio codec ({header['audio_codec']})")
+    elif channels in [1, 2] and bits_per_sample in [8, 16, 24, 32]:
         bytes_per_sample = (bits_per_sample // 8) * channels
         if audio_size % bytes_per_sample != 0:
             errors.append(f"Audio size not aligned to sample boundary "
                          f"({audio_size} % {bytes_per_sample} != 0)")
     
     # Validate file size
-    expected_size = HEADER_SIZE + (frame_count * FRAME_SIZE) + audio_size
+    expected_size = audio_offset + audio_size
+    if header['layout'] == LAYOUT_INTERLEAVED and not errors:
+        chunks = interleaved_chunk_count(header)
+        expected_size = chunk_offset(header, chunks)
     if file_size != expected_size:
         errors.append(f"File size mismatch: expected {expected_size:,}, got {file_size:,}")
     
     # Calculate durations
-    video_duration = frame_count / 30.0  # Assuming 30 FPS
-    audio_samples = audio_size // ((bits_per_sample // 8) * channels)
+    if header['fps_den'] == 0:
+        errors.append("Frame rate denominator is zero")
+    video_duration = frame_count / frame_rate(header) if frame_rate(header) else 0
+    audio_samples = header['audio_samples']
     audio_duration = audio_samples / sample_rate if sample_rate > 0 else 0
     
     duration_diff = abs(video_duration - audio_duration)
@@ -128,16 +335,93 @@ def validate_file(filename):
         warnings.append(f"Video/audio duration differs by {duration_diff:.2f}s")
     
     # Check for data sections
-    video_size = frame_count * FRAME_SIZE
-    if HEADER_SIZE + video_size > file_size:
+    video_size = header['video_size']
+    if video_offset + video_size > file_size:
         errors.append("Video data extends beyond file")
-    if HEADER_SIZE + video_size + audio_size > file_size:
+    if audio_offset + audio_size > file_size:
         errors.append("Audio data extends beyond file")
     
     is_valid = len(errors) == 0
     return is_valid, warnings, errors
 
 
+def apply_delta_record(ref, flags, payload):
+    """
+    Apply one delta record (keyframe or XOR/RLE runs) to the reference frame
+    
+    Returns:
+        bool: False if the record is malformed
+    """
+    length = len(payload)
+    if flags & DELTA_FLAG_KEYFRAME:
+        if length != FRAME_SIZE:
+            return False
+        ref[:] = payload
+        return True
+    
+    p = 0
+    pos = 0
+    while p + 2 <= length:
+        skip, run = payload[p], payload[p + 1]
+        pos += skip
+        p += 2
+        if pos + run > FRAME_SIZE or p + run > length:
+            return False
+        for i in range(run):
+            ref[pos + i] ^= payload[p + i]
+        pos += run
+        p += run
+    return True
+
+
+def read_frame(f, header, idx):
+    """
+    Read one frame, decoding from the nearest keyframe for delta video
+    
+    Args:
+        f: Open file
+        header: Parsed header
+        idx: Frame index
+    
+    Returns:
+        bytes: Frame data, or None if it could not be read or decoded
+    """
+    if header['layout'] == LAYOUT_INTERLEAVED:
+        chunk = idx * header['sample_rate'] // (header['chunk_samples'] * header['chunk_fps'])
+        f.seek(chunk_offset(header, chunk) + header['chunk_samples'] * 4 +
+               (idx - chunk_first_frame(header, chunk)) * FRAME_SIZE)
+        data = f.read(FRAME_SIZE)
+        return data if len(data) == FRAME_SIZE else None
+    
+    if header['video_codec'] != CODEC_DELTA:
+        f.seek(header['video_offset'] + idx * FRAME_SIZE)
+        data = f.read(FRAME_SIZE)
+        return data if len(data) == FRAME_SIZE else None
+    
+    # Locate the keyframe at or before idx
+    keyframe = idx // header['keyframe_interval']
+    f.seek(header['keyframe_table_offset'] + keyframe * 4)
+    entry = f.read(4)
+    if len(entry) != 4:
+        return None
+    f.seek(header['video_offset'] + struct.unpack('<I', entry)[0])
+    
+    ref = bytearray(FRAME_SIZE)
+    for n in range(keyframe * header['keyframe_interval'], idx + 1):
+        record_header = f.read(DELTA_RECORD_HEADER)
+        if len(record_header) != DELTA_RECORD_HEADER:
+            return None
+        length, flags = struct.unpack('<HB', record_header)
+        payload = f.read(length)
+        if len(payload) != length or length > FRAME_SIZE:
+            return None
+        
+        if not apply_delta_record(ref, flags, payload):
+            return None
+    
+    return bytes(ref)
+
+
 def sample_frames(filename, num_samples=5):
     """
     Sample and analyze video frames
@@ -163,11 +447,9 @@ def sample_frames(filename, num_samples=5):
     
     with open(filename, 'rb') as f:
         for idx in frame_indices:
-            offset = HEADER_SIZE + (idx * FRAME_SIZE)
-            f.seek(offset)
-            frame_data = f.read(FRAME_SIZE)
+            frame_data = read_frame(f, header, idx)
             
-            if len(frame_data) != FRAME_SIZE:
+            if frame_data is None:
                 continue
             
             # Calculate statistics
@@ -191,6 +473,134 @@ def sample_frames(filename, num_samples=5):
     return results
 
 
+def read_adpcm_sample(f, header, idx):
+    """
+    Decode one stereo sample from its IMA ADPCM block
+    
+    Returns:
+        tuple: (left, right), or None if the block is truncated
+    """
+    f.seek(header['audio_offset'] + (idx // ADPCM_BLOCK_SAMPLES) * ADPCM_BLOCK_SIZE)
+    block = f.read(ADPCM_BLOCK_SIZE)
+    if len(block) != ADPCM_BLOCK_SIZE:
+        return None
+    
+    states = []
+    for ch in range(2):
+        predictor, index, _ = struct.unpack('<hBB', block[ch * 4:ch * 4 + 4])
+        states.append([predictor, min(index, 88)])
+    
+    for byte in block[ADPCM_BLOCK_HEADER:ADPCM_BLOCK_HEADER + idx % ADPCM_BLOCK_SAMPLES + 1]:
+        for ch, nibble in enumerate((byte & 0x0F, byte >> 4)):
+            state = states[ch]
+            step = IMA_STEP_TABLE[state[1]]
+            diff = step >> 3
+            if nibble & 4:
+                diff += step
+            if nibble & 2:
+                diff += step >> 1
+            if nibble & 1:
+                diff += step >> 2
+            if nibble & 8:
+                diff = -diff
+            state[0] = max(-32768, min(32767, state[0] + diff))
+            state[1] = max(0, min(88, state[1] + IMA_INDEX_TABLE[nibble & 7]))
+    
+    return states[0][0], states[1][0]
+
+
+def iter_frames(f, header):
+    """
+    Yield every frame in order (delta video is decoded sequentially)
+    
+    Stops early at the first frame that cannot be read or decoded.
+    """
+    if header['video_codec'] != CODEC_DELTA or header['layout'] == LAYOUT_INTERLEAVED:
+        for idx in range(header['frame_count']):
+            frame = read_frame(f, header, idx)
+            if frame is None:
+                return
+            yield frame
+        return
+    
+    f.seek(header['video_offset'])
+    ref = bytearray(FRAME_SIZE)
+    for _ in range(header['frame_count']):
+        record_header = f.read(DELTA_RECORD_HEADER)
+        if len(record_header) != DELTA_RECORD_HEADER:
+            return
+        length, flags = struct.unpack('<HB', record_header)
+        payload = f.read(length)
+        if len(payload) != length or length > FRAME_SIZE:
+            return
+        if not apply_delta_record(ref, flags, payload):
+            return
+        yield bytes(ref)
+
+
+def plan_windows(frame, shadow):
+    """
+    Window bytes the display driver would send for a frame (ssd1306.c)
+    
+    One window per changed page, from its first to its last changed column;
+    the whole frame when that is fewer bus bytes or there is no shadow yet.
+    
+    Returns:
+        tuple: (bus bytes, windows, sent whole)
+    """
+    full = FRAME_SIZE + WINDOW_SETUP_BYTES
+    if shadow is None:
+        return full, 1, True
+    
+    cost = 0
+    windows = 0
+    for page in range(DISPLAY_PAGES):
+        base = page * DISPLAY_WIDTH
+        changed = [c for c in range(DISPLAY_WIDTH) if frame[base + c] != shadow[base + c]]
+        if changed:
+            cost += changed[-1] - changed[0] + 1 + WINDOW_SETUP_BYTES
+            windows += 1
+    
+    if cost < full:
+        return cost, windows, False
+    return full, 1, True
+
+
+def simulate_display(filename):
+    """
+    Replay every frame through the partial-update planner
+    
+    Returns:
+        dict: Totals, or None if the header is unreadable
+    """
+    header = analyze_header(filename)
+    if header is None:
+        return None
+    
+    totals = {'frames': 0, 'bytes': 0, 'windows': 0, 'full': 0, 'unchanged': 0,
+              'over_budget': 0}
+    shadow = None
+    
+    # Bus bytes that fit in one frame period
+    fps = frame_rate(header)
+    budget = I2C_HZ / I2C_BITS_PER_BYTE / fps if fps else float('inf')
+    
+    with open(filename, 'rb') as f:
+        for frame in iter_frames(f, header):
+            cost, windows, whole = plan_windows(frame, shadow)
+            totals['frames'] += 1
+            if not whole and windows == 0:
+                totals['unchanged'] += 1
+                continue
+            totals['bytes'] += cost
+            totals['windows'] += windows
+            totals['full'] += 1 if whole else 0
+            totals['over_budget'] += 1 if cost > budget else 0
+            shadow = frame
+    
+    return totals
+
+
 def sample_audio(filename, num_samples=5):
     """
     Sample and analyze audio data
@@ -210,13 +620,12 @@ def sample_audio(filename, num_samples=5):
     channels = header['channels']
     bits_per_sample = header['bits_per_sample']
     
-    # Calculate audio section offset
-    video_size = header['frame_count'] * FRAME_SIZE
-    audio_offset = HEADER_SIZE + video_size
+    # Audio section offset (explicit in v3, derived in v2)
+    audio_offset = header['audio_offset']
     
     # Sample positions (evenly distributed)
     bytes_per_sample = (bits_per_sample // 8) * channels
-    total_samples = audio_size // bytes_per_sample
+    total_samples = header['audio_samples']
     
     sample_indices = [int(i * total_samples / num_samples) 
                       for i in range(num_samples)]
@@ -225,7 +634,25 @@ def sample_audio(filename, num_samples=5):
     
     with open(filename, 'rb') as f:
         for idx in sample_indices:
+            if header['audio_codec'] == AUDIO_ADPCM:
+                decoded = read_adpcm_sample(f, header, idx)
+                if decoded is None:
+                    continue
+                left, right = decoded
+                results.append({
+                    'sample': idx,
+                    'left': left,
+                    'right': right,
+                    'left_percent': (left / 32768.0) * 100,
+                    'right_percent': (right / 32768.0) * 100
+                })
+                continue
+            
             offset = audio_offset + (idx * bytes_per_sample)
+            if header['layout'] == LAYOUT_INTERLEAVED:
+                chunk = idx // header['chunk_samples']
+                offset = chunk_offset(header, chunk) + \
+                         (idx % header['chunk_samples']) * bytes_per_sample
             f.seek(offset)
             sample_data = f.read(bytes_per_sample)
             
@@ -261,7 +688,7 @@ def analyze_file(filename):
         filename: Path to .bin file
     """
     print("=" * 70)
-    print(f"BAD APPLE FILE ANALYZER v2.0.1")
+    print(f"BAD APPLE FILE ANALYZER v3.4.0")
     print(f"Analyzing: {filename}")
     print("=" * 70)
     print()
@@ -276,6 +703,22 @@ def analyze_file(filename):
     
     print("[HEADER] FILE HEADER")
     print("-" * 70)
+    print(f"Format version:   v{header['version']} ({header['header_size']}-byte header)")
+    print(f"Video offset:     {header['video_offset']:,}"
+          f"{' (sector-aligned)' if header['video_offset'] % SECTOR_SIZE == 0 else ''}")
+    print(f"Audio offset:     {header['audio_offset']:,}"
+          f"{' (sector-aligned)' if header['audio_offset'] % SECTOR_SIZE == 0 else ''}")
+    if header['layout'] == LAYOUT_INTERLEAVED:
+        print(f"Layout:           interleaved, {header['chunk_samples']} samples per chunk "
+              f"@ {header['chunk_fps']} fps")
+    if header['video_codec'] == CODEC_DELTA:
+        raw_size = header['frame_count'] * FRAME_SIZE
+        print(f"Video codec:      XOR/RLE delta, {header['video_size']:,} bytes "
+              f"({header['video_size'] / raw_size * 100:.1f}% of raw)")
+        print(f"Keyframes:        {header['keyframe_count']} every "
+              f"{header['keyframe_interval']} frames, table at {header['keyframe_table_offset']:,}")
+    else:
+        print(f"Video codec:      raw")
     print(f"Frame count:      {header['frame_count']:,}")
     print(f"Audio size:       {header['audio_size']:,} bytes ({header['audio_size']/1024/1024:.2f} MB)")
     print(f"Sample rate:      {header['sample_rate']:,} Hz")
@@ -317,22 +760,22 @@ def analyze_file(filename):
     print("-" * 70)
     
     # Video
-    video_size = header['frame_count'] * FRAME_SIZE
-    video_duration = header['frame_count'] / 30.0
-    video_fps = 30
+    video_size = header['video_size']
+    video_fps = frame_rate(header)
+    video_duration = header['frame_count'] / video_fps if video_fps else 0
     
     print(f"Video section:")
     print(f"  Size:        {video_size:,} bytes ({video_size/1024:.1f} KB)")
     print(f"  Duration:    {int(video_duration//60)}:{int(video_duration%60):02d}")
-    print(f"  Frame rate:  {video_fps} FPS")
+    print(f"  Frame rate:  {video_fps:.3f} FPS ({header['fps_num']}/{header['fps_den']})")
     
     # Audio
-    bytes_per_sample = (header['bits_per_sample'] // 8) * header['channels']
-    total_samples = header['audio_size'] // bytes_per_sample
+    total_samples = header['audio_samples']
     audio_duration = total_samples / header['sample_rate']
-    data_rate = header['sample_rate'] * bytes_per_sample / 1024
+    data_rate = header['audio_size'] / audio_duration / 1024 if audio_duration > 0 else 0
     
     print(f"\nAudio section:")
+    print(f"  Codec:           {'IMA ADPCM' if header['audio_codec'] == AUDIO_ADPCM else 'PCM'}")
     print(f"  Total samples:   {total_samples:,}")
     print(f"  Duration:        {int(audio_duration//60)}:{int(audio_duration%60):02d}")
     print(f"  Data rate:       {data_rate:.1f} KB/s")
@@ -348,6 +791,43 @@ def analyze_file(filename):
     else:
         print(f"  Status:          [WARNING] May have sync issues")
     
+    # Frame clock over a long run (firmware integer math)
+    if header['sample_rate'] and header['fps_num'] and header['fps_den']:
+        sim = simulate_sync(header['sample_rate'], header['fps_num'], header['fps_den'],
+                            SYNC_SIM_SECONDS)
+        print(f"\nFrame clock over {SYNC_SIM_SECONDS // 60} min (max error, drift at end):")
+        for name, (max_ms, end_frames) in sim.items():
+            print(f"  {name.capitalize() + ':':<16} {max_ms:8.3f} ms {end_frames:+8.3f} frames")
+    
+    print()
+    
+    # ========================================================================
+    # DISPLAY BUS
+    # ========================================================================
+    
+    print("[DISPLAY] PARTIAL UPDATE SIMULATION")
+    print("-" * 70)
+    
+    display = simulate_display(filename)
+    if display and display['frames']:
+        frames = display['frames']
+        per_frame = display['bytes'] / frames
+        busy = per_frame * I2C_BITS_PER_BYTE / I2C_HZ * video_fps
+        full_bytes = FRAME_SIZE + WINDOW_SETUP_BYTES
+        print(f"Frames replayed:  {frames:,}")
+        print(f"Bytes per frame:  {per_frame:.0f} on the bus "
+              f"({per_frame / full_bytes * 100:.1f}% of full updates)")
+        print(f"Windows:          {display['windows']:,}, "
+              f"{display['full']:,} frames sent whole, {display['unchanged']:,} unchanged")
+        print(f"I2C idle:         {max(0.0, 1 - busy) * 100:.1f}% at {I2C_HZ // 1000} kHz "
+              f"(full updates: "
+              f"{max(0.0, 1 - full_bytes * I2C_BITS_PER_BYTE / I2C_HZ * video_fps) * 100:.1f}%)")
+        if video_fps:
+            print(f"Over budget:      {display['over_budget']:,} frames longer than "
+                  f"{1000 / video_fps:.1f} ms on the bus")
+    else:
+        print("Could not replay frames")
+    
     print()
     
     # ========================================================================
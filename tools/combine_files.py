@@ -3,7 +3,64 @@
 Bad Apple File Combiner for STM32L476RG
 Combines video and audio into single binary file for SD card
 
-File Format v2.0:
+File Format v3.0 (default, sector-aligned):
++------------------------------------------------------------+
+| HEADER (512 bytes, zero padded to one SD sector)           |
++------------------------------------------------------------+
+| Offset  0: Magic "BAV3"       (4 bytes)                    |
+| Offset  4: Version (3)        (4 bytes uint32 LE)          |
+| Offset  8: Header size (512)  (4 bytes uint32 LE)          |
+| Offset 12: Frame count        (4 bytes uint32 LE)          |
+| Offset 16: Audio size (bytes) (4 bytes uint32 LE)          |
+| Offset 20: Sample rate (Hz)   (4 bytes uint32 LE)          |
+| Offset 24: Channels           (4 bytes uint32 LE)          |
+| Offset 28: Bits per sample    (4 bytes uint32 LE)          |
+| Offset 32: Video offset       (4 bytes uint32 LE)          |
+| Offset 36: Audio offset       (4 bytes uint32 LE)          |
+| Offset 40: Video codec        (0 = raw, 1 = XOR/RLE delta) |
+| Offset 44: Video size (bytes) (4 bytes uint32 LE)          |
+| Offset 48: Keyframe interval  (delta only)                 |
+| Offset 52: Keyframe count     (delta only)                 |
+| Offset 56: Keyframe table offset (delta only)              |
+| Offset 60: Audio codec        (0 = PCM, 1 = IMA ADPCM)     |
+| Offset 64: Audio samples      (stereo samples, ADPCM only) |
+| Offset 68: Layout             (0 = separate, 1 = chunks)   |
+| Offset 72: Chunk samples      (interleaved only)           |
+| Offset 76: Chunk fps          (interleaved only)           |
+| Offset 80: Frame rate numerator   (e.g. 30 or 30000)     |
+| Offset 84: Frame rate denominator (e.g. 1 or 1001)       |
++------------------------------------------------------------+
+| VIDEO DATA at video offset (multiple of 512)               |
++------------------------------------------------------------+
+| (zero padding up to next 512-byte boundary)                |
++------------------------------------------------------------+
+| KEYFRAME TABLE (delta only, uint32 LE record offsets)      |
++------------------------------------------------------------+
+| (zero padding up to next 512-byte boundary)                |
++------------------------------------------------------------+
+| AUDIO DATA at audio offset (multiple of 512)               |
++------------------------------------------------------------+
+
+Raw video: every 1024-byte frame starts on a sector boundary, so the
+player reads frames and audio refills by DMA directly into their
+destination buffers.
+
+Delta video: the video region holds the record stream written by
+process_video.py (badapple_video.dlt); see that script for the record
+layout. Keyframe table offsets are relative to the video offset.
+
+ADPCM audio: the audio region holds the 512-byte IMA ADPCM blocks written
+by process_audio.py (badapple_audio.adpcm), 504 stereo samples per block.
+
+Interleaved layout (LAYOUT = LAYOUT_INTERLEAVED; raw video + PCM only):
+the region at the video offset (= audio offset) is a sequence of chunks.
+Chunk i is CHUNK_SAMPLES of PCM (zero padded past the end of the track)
+followed by frames [F(i), F(i+1)), F(i) = ceil(i * CHUNK_SAMPLES * fps /
+SAMPLE_RATE) clamped to the frame count. Chunk offsets follow from F(i),
+so there are no per-chunk headers; the player reads the file strictly
+sequentially.
+
+File Format v2.0 (legacy, FORMAT_VERSION = 2):
 +------------------------------------------------------------+
 | HEADER (20 bytes)                                          |
 +------------------------------------------------------------+
@@ -21,7 +78,7 @@ File Format v2.0:
 
 Author: David Leathers
 Date: November 2025
-Version: 2.0.0
+Version: 3.4.0
 """
 
 import struct
@@ -34,6 +91,8 @@ import sys
 
 VIDEO_FILE = "output/badapple_video.bin"
 AUDIO_FILE = "output/badapple_audio.raw"
+DELTA_FILE = "output/badapple_video.dlt"
+ADPCM_FILE = "output/badapple_audio.adpcm"
 OUTPUT_FILE = "output/badapple.bin"
 
 # Audio parameters (must match process_audio.py)
@@ -42,18 +101,43 @@ CHANNELS = 2             # Stereo
 BITS_PER_SAMPLE = 16     # 16-bit
 
 # Video parameters (must match process_video.py)
-VIDEO_FPS = 30           # 30 FPS target
+VIDEO_FPS_NUM = 30       # Frame rate numerator (30000 for 29.97 fps, 60 for the 60 fps mode)
+VIDEO_FPS_DEN = 1        # Frame rate denominator (1001 for 29.97 fps)
+VIDEO_FPS = -(-VIDEO_FPS_NUM // VIDEO_FPS_DEN)  # Whole fps (interleaved chunk assignment)
 
 # File format version
-FORMAT_VERSION = 2       # Version 2.0 with stereo support
+FORMAT_VERSION = 3       # 3 = sector-aligned (default), 2 = legacy 20-byte header
+
+# Video codec (v3 only; falls back to raw if DELTA_FILE is missing)
+CODEC_RAW = 0
+CODEC_DELTA = 1
+VIDEO_CODEC = CODEC_DELTA
+
+# Audio codec (v3 only; falls back to PCM if ADPCM_FILE is missing)
+AUDIO_PCM = 0
+AUDIO_ADPCM = 1
+AUDIO_CODEC = AUDIO_ADPCM
+ADPCM_BLOCK_SIZE = 512
+ADPCM_BLOCK_SAMPLES = 504
+
+# A/V layout (v3 only). Interleaving forces raw video and PCM audio.
+LAYOUT_SEPARATE = 0
+LAYOUT_INTERLEAVED = 1
+LAYOUT = LAYOUT_SEPARATE
+CHUNK_SAMPLES = 2048     # Must match AUDIO_SEGMENT_SAMPLES (one ring segment) in buffers.h
 
 # ============================================================================
 # HEADER STRUCTURE
 # ============================================================================
 
-HEADER_SIZE = 20         # Total header size in bytes
+HEADER_SIZE = 20         # v2 header size in bytes
 FRAMEBUFFER_SIZE = 1024  # Each video frame is 1024 bytes
 
+# v3 container
+SECTOR_SIZE = 512        # SD block size - v3 regions are aligned to this
+V3_MAGIC = b'BAV3'       # Identifies v3 (v2 starts with the frame count)
+V3_HEADER_SIZE = 512     # One full sector
+
 # Header field offsets
 OFFSET_FRAME_COUNT = 0
 OFFSET_AUDIO_SIZE = 4
@@ -98,6 +182,38 @@ def validate_video_file(video_data):
     return True, frame_count, None
 
 
+def read_delta_file(filename, frame_count):
+    """
+    Read and validate process_video.py delta output
+    
+    Args:
+        filename: Delta file path
+        frame_count: Frame count from the raw video file
+    
+    Returns:
+        tuple: (stream, keyframe_interval, keyframe_offsets, error_message)
+    """
+    with open(filename, 'rb') as f:
+        data = f.read()
+    
+    if len(data) < 16:
+        return None, 0, None, "Delta file too small"
+    
+    frames, interval, keyframe_count, stream_size = struct.unpack('<4I', data[0:16])
+    table_end = 16 + keyframe_count * 4
+    
+    if frames != frame_count:
+        return None, 0, None, f"Delta has {frames} frames, raw video has {frame_count}"
+    if interval == 0 or keyframe_count < (frame_count + interval - 1) // interval:
+        return None, 0, None, "Keyframe table does not cover every frame"
+    if len(data) != table_end + stream_size:
+        return None, 0, None, \
+               f"Size mismatch: expected {table_end + stream_size}, got {len(data)}"
+    
+    keyframe_offsets = list(struct.unpack(f'<{keyframe_count}I', data[16:table_end]))
+    return data[table_end:], interval, keyframe_offsets, None
+
+
 def validate_audio_file(audio_data):
     """
     Validate audio file structure
@@ -124,6 +240,96 @@ def validate_audio_file(audio_data):
     return True, None
 
 
+# ============================================================================
+# HEADER BUILDERS
+# ============================================================================
+
+def align_up(value, alignment=SECTOR_SIZE):
+    """Round value up to the next multiple of alignment"""
+    return (value + alignment - 1) // alignment * alignment
+
+
+def chunk_first_frame(chunk, frame_count):
+    """First frame carried by an interleaved chunk"""
+    frame = -(-chunk * CHUNK_SAMPLES * VIDEO_FPS // SAMPLE_RATE)
+    return min(frame, frame_count)
+
+
+def build_interleaved(video_frames, frame_count, audio_data):
+    """
+    Interleave PCM audio and raw frames into chunks
+    
+    Returns:
+        tuple: (chunk data bytes, chunk count)
+    """
+    bytes_per_chunk = CHUNK_SAMPLES * (BITS_PER_SAMPLE // 8) * CHANNELS
+    audio_chunks = -(-len(audio_data) // bytes_per_chunk)
+    
+    # Enough chunks to carry every sample and every frame
+    chunk_count = audio_chunks
+    while chunk_first_frame(chunk_count, frame_count) < frame_count:
+        chunk_count += 1
+    
+    data = bytearray()
+    for chunk in range(chunk_count):
+        audio = audio_data[chunk * bytes_per_chunk:(chunk + 1) * bytes_per_chunk]
+        data += audio.ljust(bytes_per_chunk, b'\0')
+        
+        first = chunk_first_frame(chunk, frame_count)
+        last = chunk_first_frame(chunk + 1, frame_count)
+        data += video_frames[first * FRAMEBUFFER_SIZE:last * FRAMEBUFFER_SIZE]
+    
+    return bytes(data), chunk_count
+
+
+def build_header_v2(frame_count, audio_size):
+    """
+    Build legacy 20-byte header
+    
+    Returns:
+        bytes: Header
+    """
+    return struct.pack('<5I', frame_count, audio_size,
+                       SAMPLE_RATE, CHANNELS, BITS_PER_SAMPLE)
+
+
+def build_header_v3(frame_count, audio_size, video_offset, audio_offset,
+                    video_codec=CODEC_RAW, video_size=0, keyframe_interval=0,
+                    keyframe_count=0, keyframe_table_offset=0,
+                    audio_codec=AUDIO_PCM, audio_samples=0,
+                    layout=LAYOUT_SEPARATE, chunk_samples=0, chunk_fps=0,
+                    fps_num=VIDEO_FPS_NUM, fps_den=VIDEO_FPS_DEN):
+    """
+    Build sector-sized v3 header
+    
+    Returns:
+        bytes: Header, zero padded to V3_HEADER_SIZE
+    """
+    header = V3_MAGIC + struct.pack('<21I',
+                                    3,                 # Version
+                                    V3_HEADER_SIZE,    # Header size
+                                    frame_count,
+                                    audio_size,
+                                    SAMPLE_RATE,
+                                    CHANNELS,
+                                    BITS_PER_SAMPLE,
+                                    video_offset,
+                                    audio_offset,
+                                    video_codec,
+                                    video_size,
+                                    keyframe_interval,
+                                    keyframe_count,
+                                    keyframe_table_offset,
+                                    audio_codec,
+                                    audio_samples,
+                                    layout,
+                                    chunk_samples,
+                                    chunk_fps,
+                                    fps_num,
+                                    fps_den)
+    return header.ljust(V3_HEADER_SIZE, b'\0')
+
+
 # ============================================================================
 # FILE COMBINATION
 # ============================================================================
@@ -136,7 +342,7 @@ def combine_files():
         bool: True if successful, False otherwise
     """
     print("=" * 70)
-    print("BAD APPLE FILE COMBINER v2.0.1")
+    print("BAD APPLE FILE COMBINER v3.4.0")
     print("Creating final SD card file with stereo audio")
     print("=" * 70)
     print()
@@ -177,9 +383,34 @@ def combine_files():
     print(f"  Frame size:  {FRAMEBUFFER_SIZE} bytes")
     print(f"  Video size:  {len(video_frames):,} bytes ({len(video_frames)/1024:.1f} KB)")
     
+    # Delta stream replaces the raw frames when available (v3 only)
+    video_codec = CODEC_RAW
+    keyframe_interval = 0
+    keyframe_offsets = []
+    
+    interleaved = FORMAT_VERSION == 3 and LAYOUT == LAYOUT_INTERLEAVED
+    
+    if interleaved and VIDEO_CODEC != CODEC_RAW:
+        print("  [INFO] Interleaved layout - packing raw frames")
+    elif FORMAT_VERSION == 3 and VIDEO_CODEC == CODEC_DELTA:
+        if os.path.exists(DELTA_FILE):
+            stream, keyframe_interval, keyframe_offsets, error = \
+                read_delta_file(DELTA_FILE, frame_count)
+            if error:
+                print(f"ERROR: Invalid delta file - {error}")
+                return False
+            video_codec = CODEC_DELTA
+            print(f"  Delta:       {len(stream):,} bytes "
+                  f"({len(stream) / len(video_frames) * 100:.1f}% of raw), "
+                  f"{len(keyframe_offsets)} keyframes every {keyframe_interval} frames")
+            video_frames = stream
+        else:
+            print(f"  [WARNING] {DELTA_FILE} not found - packing raw frames")
+    
     # Calculate video duration
-    video_duration = frame_count / VIDEO_FPS
-    print(f"  Duration:    {int(video_duration//60)}:{int(video_duration%60):02d} @ {VIDEO_FPS} fps")
+    video_duration = frame_count * VIDEO_FPS_DEN / VIDEO_FPS_NUM
+    print(f"  Duration:    {int(video_duration//60)}:{int(video_duration%60):02d} "
+          f"@ {VIDEO_FPS_NUM / VIDEO_FPS_DEN:.2f} fps")
     
     # ========================================================================
     # READ AUDIO FILE
@@ -211,6 +442,31 @@ def combine_files():
     print(f"  Bit depth:   {BITS_PER_SAMPLE} bits")
     print(f"  Data rate:   {data_rate:.1f} KB/s")
     
+    # ADPCM blocks replace the PCM track when available (v3 only)
+    audio_codec = AUDIO_PCM
+    
+    if interleaved and AUDIO_CODEC != AUDIO_PCM:
+        print("  [INFO] Interleaved layout - packing PCM")
+    elif FORMAT_VERSION == 3 and AUDIO_CODEC == AUDIO_ADPCM:
+        if os.path.exists(ADPCM_FILE):
+            with open(ADPCM_FILE, 'rb') as f:
+                adpcm_data = f.read()
+            
+            expected_blocks = (total_samples + ADPCM_BLOCK_SAMPLES - 1) // ADPCM_BLOCK_SAMPLES
+            if len(adpcm_data) != expected_blocks * ADPCM_BLOCK_SIZE:
+                print(f"ERROR: ADPCM file has {len(adpcm_data)} bytes, expected "
+                      f"{expected_blocks * ADPCM_BLOCK_SIZE} for {total_samples} samples")
+                print("\nPlease run: python process_audio.py --verify-adpcm")
+                return False
+            
+            audio_codec = AUDIO_ADPCM
+            audio_data = adpcm_data
+            data_rate = len(adpcm_data) / audio_duration / 1024
+            print(f"  ADPCM:       {len(adpcm_data):,} bytes ({expected_blocks} blocks, "
+                  f"{data_rate:.1f} KB/s)")
+        else:
+            print(f"  [WARNING] {ADPCM_FILE} not found - packing PCM")
+    
     # ========================================================================
     # CHECK AUDIO/VIDEO SYNC
     # ========================================================================
@@ -239,19 +495,50 @@ def combine_files():
     print()
     print(f"[OUTPUT] Creating combined file: {OUTPUT_FILE}")
     
+    keyframe_table = struct.pack(f'<{len(keyframe_offsets)}I', *keyframe_offsets)
+    
+    if interleaved:
+        # One region of chunks; nothing follows it
+        chunk_data, chunk_count = build_interleaved(video_frames, frame_count, audio_data)
+        video_offset = audio_offset = table_offset = V3_HEADER_SIZE
+        header = build_header_v3(frame_count, len(audio_data), video_offset, audio_offset,
+                                 CODEC_RAW, len(video_frames), 0, 0, 0,
+                                 AUDIO_PCM, total_samples,
+                                 LAYOUT_INTERLEAVED, CHUNK_SAMPLES, VIDEO_FPS)
+    elif FORMAT_VERSION == 3:
+        video_offset = V3_HEADER_SIZE
+        table_offset = align_up(video_offset + len(video_frames))
+        audio_offset = align_up(table_offset + len(keyframe_table))
+        header = build_header_v3(frame_count, len(audio_data), video_offset, audio_offset,
+                                 video_codec, len(video_frames), keyframe_interval,
+                                 len(keyframe_offsets),
+                                 table_offset if keyframe_offsets else 0,
+                                 audio_codec, total_samples)
+    else:
+        video_offset = HEADER_SIZE
+        table_offset = HEADER_SIZE + len(video_frames)
+        audio_offset = HEADER_SIZE + len(video_frames)
+        header = build_header_v2(frame_count, len(audio_data))
+    
     with open(OUTPUT_FILE, 'wb') as f:
-        # Write header (20 bytes total)
-        f.write(struct.pack('<I', frame_count))        # Frame count
-        f.write(struct.pack('<I', len(audio_data)))    # Audio size in bytes
-        f.write(struct.pack('<I', SAMPLE_RATE))        # Sample rate
-        f.write(struct.pack('<I', CHANNELS))           # Number of channels
-        f.write(struct.pack('<I', BITS_PER_SAMPLE))    # Bits per sample
-        
-        # Write video data
-        f.write(video_frames)
+        f.write(header)
         
-        # Write audio data (interleaved stereo: L-R-L-R...)
-        f.write(audio_data)
+        if interleaved:
+            # Chunks carry both tracks
+            f.write(chunk_data)
+        else:
+            # Write video data (raw frames or delta record stream)
+            f.write(video_frames)
+            
+            # Keyframe table (delta only), sector-aligned
+            f.write(b'\0' * (table_offset - video_offset - len(video_frames)))
+            f.write(keyframe_table)
+            
+            # Pad to audio region (v3 keeps audio sector-aligned)
+            f.write(b'\0' * (audio_offset - table_offset - len(keyframe_table)))
+            
+            # Write audio data (interleaved stereo: L-R-L-R...)
+            f.write(audio_data)
     
     # ========================================================================
     # FINAL STATISTICS
@@ -267,9 +554,18 @@ def combine_files():
     print(f"Total size:   {total_size:,} bytes ({total_size/1024/1024:.2f} MB)")
     print()
     print("File Structure:")
-    print(f"  Header:     {HEADER_SIZE} bytes (format v{FORMAT_VERSION})")
-    print(f"  Video:      {len(video_frames):,} bytes ({frame_count} frames)")
-    print(f"  Audio:      {len(audio_data):,} bytes ({total_samples:,} samples)")
+    print(f"  Header:     {len(header)} bytes (format v{FORMAT_VERSION})")
+    if interleaved:
+        print(f"  Chunks:     {len(chunk_data):,} bytes ({chunk_count} chunks of "
+              f"{CHUNK_SAMPLES} samples + frames) at offset {video_offset}")
+        print(f"  Video:      {frame_count} raw frames, Audio: {total_samples:,} PCM samples")
+    else:
+        print(f"  Video:      {len(video_frames):,} bytes ({frame_count} frames, "
+              f"{'delta' if video_codec == CODEC_DELTA else 'raw'}) at offset {video_offset}")
+        if keyframe_offsets:
+            print(f"  Keyframes:  {len(keyframe_table)} bytes at offset {table_offset}")
+        print(f"  Audio:      {len(audio_data):,} bytes ({total_samples:,} samples, "
+              f"{'ADPCM' if audio_codec == AUDIO_ADPCM else 'PCM'}) at offset {audio_offset}")
     print()
     
     # Calculate SD card performance requirements
@@ -280,7 +576,7 @@ def combine_files():
     print("Playback Requirements:")
     print(f"  Average bitrate: {avg_bitrate:.1f} kbps")
     print(f"  SD read rate:    {sd_read_rate:.1f} KB/s")
-    print(f"  Video bandwidth: {VIDEO_FPS * FRAMEBUFFER_SIZE / 1024:.1f} KB/s")
+    print(f"  Video bandwidth: {len(video_frames) / video_duration / 1024:.1f} KB/s")
     print(f"  Audio bandwidth: {data_rate:.1f} KB/s")
     
     if sd_read_rate > 400:
@@ -9,9 +9,18 @@ Target System:
 - Target: 32 kHz sampling rate, 16-bit stereo
 - Triple buffering, 512 samples per buffer
 
+IMA ADPCM Output (badapple_audio.adpcm, optional):
+- 512-byte blocks (one SD sector), 504 stereo samples each
+- Block header: per channel int16 LE predictor, uint8 step index, uint8 pad
+- Sample bytes: low nibble = left, high nibble = right
+- Header holds the decoder state before the block's first sample, so each
+  block decodes independently
+- Verify an existing PCM file without re-running FFmpeg:
+    python process_audio.py --verify-adpcm
+
 Author: David Leathers
 Date: November 2025
-Version: 2.0.0
+Version: 2.1.0
 """
 
 import subprocess
@@ -26,12 +35,16 @@ import struct
 # Input/Output
 VIDEO_FILE = "BadApple.mp4"
 OUTPUT_FILE = "output/badapple_audio.raw"
+ADPCM_OUTPUT_FILE = "output/badapple_audio.adpcm"
 
 # Audio settings (matches STM32 hardware)
 SAMPLE_RATE = 32000      # 32 kHz (matches AUDIO_SAMPLE_RATE in buffers.h)
 BITS_PER_SAMPLE = 16     # 16-bit signed
 CHANNELS = 2             # Stereo (matches dual DAC hardware)
 
+# IMA ADPCM track (4 bits per sample, packed by combine_files.py)
+ENCODE_ADPCM = True
+
 # STM32 buffer configuration (for reference)
 STM32_BUFFER_SAMPLES = 512  # Audio buffer size
 STM32_BUFFER_MS = (STM32_BUFFER_SAMPLES * 1000) / SAMPLE_RATE  # ~16 ms
@@ -104,6 +117,235 @@ def get_audio_duration(video_file):
         return None
 
 
+# ============================================================================
+# IMA ADPCM CODEC
+# ============================================================================
+
+ADPCM_BLOCK_SIZE = 512                  # One SD sector
+ADPCM_BLOCK_HEADER = 8                  # Predictor + index per channel
+ADPCM_BLOCK_SAMPLES = ADPCM_BLOCK_SIZE - ADPCM_BLOCK_HEADER  # 504
+
+IMA_STEP_TABLE = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
+    34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143,
+    157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+    724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
+    3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+]
+IMA_INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8]
+
+
+def ima_decode_nibble(state, nibble):
+    """
+    Decode one nibble (standard shift-add form, matches the firmware)
+    
+    Args:
+        state: [predictor, index], updated in place
+        nibble: 4-bit code
+    
+    Returns:
+        int: Decoded sample
+    """
+    step = IMA_STEP_TABLE[state[1]]
+    diff = step >> 3
+    if nibble & 4:
+        diff += step
+    if nibble & 2:
+        diff += step >> 1
+    if nibble & 1:
+        diff += step >> 2
+    if nibble & 8:
+        diff = -diff
+    
+    state[0] = max(-32768, min(32767, state[0] + diff))
+    state[1] = max(0, min(88, state[1] + IMA_INDEX_TABLE[nibble & 7]))
+    return state[0]
+
+
+def ima_encode_sample(state, sample):
+    """
+    Encode one sample against the decoder state
+    
+    Args:
+        state: [predictor, index], advanced exactly as the decoder will
+        sample: 16-bit signed input
+    
+    Returns:
+        int: 4-bit code
+    """
+    step = IMA_STEP_TABLE[state[1]]
+    diff = sample - state[0]
+    nibble = 0
+    if diff < 0:
+        nibble = 8
+        diff = -diff
+    if diff >= step:
+        nibble |= 4
+        diff -= step
+    if diff >= step >> 1:
+        nibble |= 2
+        diff -= step >> 1
+    if diff >= step >> 2:
+        nibble |= 1
+    
+    ima_decode_nibble(state, nibble)
+    return nibble
+
+
+def encode_adpcm(pcm_data):
+    """
+    Encode 16-bit stereo interleaved PCM into IMA ADPCM blocks
+    
+    Args:
+        pcm_data: Raw s16le stereo bytes
+    
+    Returns:
+        tuple: (block bytes, stereo sample count)
+    """
+    total = len(pcm_data) // 4
+    samples = struct.unpack(f'<{total * 2}h', pcm_data[:total * 4])
+    states = [[0, 0], [0, 0]]
+    out = bytearray()
+    
+    for start in range(0, total, ADPCM_BLOCK_SAMPLES):
+        for state in states:
+            out += struct.pack('<hBB', state[0], state[1], 0)
+        
+        end = min(start + ADPCM_BLOCK_SAMPLES, total)
+        for i in range(start, end):
+            lo = ima_encode_sample(states[0], samples[i * 2])
+            hi = ima_encode_sample(states[1], samples[i * 2 + 1])
+            out.append(lo | (hi << 4))
+        
+        # Zero-pad the last block to a full sector
+        out += bytes(ADPCM_BLOCK_SAMPLES - (end - start))
+    
+    return bytes(out), total
+
+
+def decode_adpcm(adpcm_data, total):
+    """
+    Decode IMA ADPCM blocks (mirrors the firmware decoder)
+    
+    Returns:
+        tuple: (left samples, right samples)
+    """
+    left = []
+    right = []
+    
+    for offset in range(0, len(adpcm_data), ADPCM_BLOCK_SIZE):
+        block = adpcm_data[offset:offset + ADPCM_BLOCK_SIZE]
+        states = []
+        for ch in range(2):
+            predictor, index, _ = struct.unpack('<hBB', block[ch * 4:ch * 4 + 4])
+            states.append([predictor, min(index, 88)])
+        
+        for byte in block[ADPCM_BLOCK_HEADER:]:
+            if len(left) == total:
+                break
+            left.append(ima_decode_nibble(states[0], byte & 0x0F))
+            right.append(ima_decode_nibble(states[1], byte >> 4))
+    
+    return left, right
+
+
+def reference_decode_channel(adpcm_data, total, channel):
+    """
+    Decode one channel with the standard library IMA/DVI decoder (audioop)
+    
+    Returns:
+        list: Samples, or None if audioop is unavailable (Python 3.13+)
+    """
+    try:
+        import warnings
+        with warnings.catch_warnings():
+            warnings.simplefilter("ignore", DeprecationWarning)
+            import audioop
+    except ImportError:
+        return None
+    
+    samples = []
+    for offset in range(0, len(adpcm_data), ADPCM_BLOCK_SIZE):
+        block = adpcm_data[offset:offset + ADPCM_BLOCK_SIZE]
+        predictor, index, _ = struct.unpack('<hBB', block[channel * 4:channel * 4 + 4])
+        count = min(ADPCM_BLOCK_SAMPLES, total - len(samples))
+        
+        # audioop consumes the high nibble first
+        nibbles = [(b >> (4 * channel)) & 0x0F for b in block[ADPCM_BLOCK_HEADER:]][:count]
+        if len(nibbles) % 2:
+            nibbles.append(0)
+        packed = bytes((nibbles[i] << 4) | nibbles[i + 1] for i in range(0, len(nibbles), 2))
+        
+        decoded, _ = audioop.adpcm2lin(packed, 2, (predictor, min(index, 88)))
+        samples += list(struct.unpack(f'<{len(decoded) // 2}h', decoded))[:count]
+    
+    return samples
+
+
+def verify_adpcm(pcm_data, adpcm_data, total):
+    """
+    Check the ADPCM track against the reference decoder and the source PCM
+    
+    Returns:
+        bool: True if the decoder matches the reference bit-exactly
+    """
+    left, right = decode_adpcm(adpcm_data, total)
+    
+    ok = True
+    for channel, decoded in enumerate((left, right)):
+        reference = reference_decode_channel(adpcm_data, total, channel)
+        name = "Left " if channel == 0 else "Right"
+        if reference is None:
+            print(f"  [SKIP] {name}: audioop not available for reference decode")
+        elif reference != decoded:
+            mismatch = next(i for i, (a, b) in enumerate(zip(reference, decoded)) if a != b)
+            print(f"  [FAIL] {name}: differs from reference at sample {mismatch}")
+            ok = False
+        else:
+            print(f"  [OK]   {name}: bit-exact with reference decoder ({total:,} samples)")
+    
+    # Quality at the DAC's 12-bit resolution
+    source = struct.unpack(f'<{total * 2}h', pcm_data[:total * 4])
+    signal = noise = 0
+    for i in range(total):
+        for ch, decoded in enumerate((left, right)):
+            s = source[i * 2 + ch] >> 4
+            signal += s * s
+            noise += (s - (decoded[i] >> 4)) ** 2
+    
+    if noise == 0:
+        print("  SNR (12-bit):  lossless")
+    else:
+        import math
+        print(f"  SNR (12-bit):  {10 * math.log10(max(signal, 1) / noise):.1f} dB")
+    
+    return ok
+
+
+def write_adpcm_file(pcm_file, adpcm_file):
+    """
+    Encode the PCM output to IMA ADPCM and verify it
+    
+    Returns:
+        bool: True if written and verified
+    """
+    with open(pcm_file, 'rb') as f:
+        pcm_data = f.read()
+    
+    adpcm_data, total = encode_adpcm(pcm_data)
+    
+    with open(adpcm_file, 'wb') as f:
+        f.write(adpcm_data)
+    
+    print(f"[ADPCM] Wrote {adpcm_file}")
+    print(f"  Size:          {len(adpcm_data):,} bytes "
+          f"({len(adpcm_data) / max(len(pcm_data), 1) * 100:.1f}% of PCM)")
+    print(f"  Data rate:     {SAMPLE_RATE / ADPCM_BLOCK_SAMPLES * ADPCM_BLOCK_SIZE / 1024:.1f} KB/s")
+    
+    return verify_adpcm(pcm_data, adpcm_data, total)
+
+
 # ============================================================================
 # AUDIO PROCESSING
 # ============================================================================
@@ -119,7 +361,7 @@ def process_audio():
         bool: True if successful, False otherwise
     """
     print("=" * 70)
-    print("BAD APPLE AUDIO PROCESSOR v2.0.1")
+    print("BAD APPLE AUDIO PROCESSOR v2.1.0")
     print("Target: STM32L476RG Dual DAC (16-bit Stereo @ 32 kHz)")
     print("=" * 70)
     print()
@@ -284,6 +526,16 @@ def process_audio():
             print(f"  Expected: {expected_size:,} bytes")
             print(f"  Actual:   {file_size:,} bytes")
     
+    # ========================================================================
+    # ENCODE IMA ADPCM
+    # ========================================================================
+    
+    if ENCODE_ADPCM:
+        print()
+        if not write_adpcm_file(OUTPUT_FILE, ADPCM_OUTPUT_FILE):
+            print("ERROR: ADPCM decoder does not match the reference!")
+            return False
+    
     print()
     print("[NEXT] Next steps:")
     print("  1. Verify audio quality (optional: play with audacity)")
@@ -300,7 +552,10 @@ def process_audio():
 
 if __name__ == "__main__":
     try:
-        success = process_audio()
+        if "--verify-adpcm" in sys.argv:
+            success = write_adpcm_file(OUTPUT_FILE, ADPCM_OUTPUT_FILE)
+        else:
+            success = process_audio()
         if success:
             print("[OK] Audio processing successful!")
             sys.exit(0)
@@ -9,7 +9,7 @@ Each byte = 8 VERTICAL pixels (not horizontal!)
 Target System:
 - NUCLEO-L476RG @ 80 MHz
 - SSD1306 OLED 128x64 via I2C2 (1 MHz)
-- Target: 30 FPS playback
+- Target: 30 FPS playback (60 FPS mode: TARGET_FPS = 60)
 - Triple buffering with DMA-accelerated transfers
 
 SSD1306 Memory Format:
@@ -19,12 +19,24 @@ SSD1306 Memory Format:
 - Bit 0 = top pixel of 8-pixel column, Bit 7 = bottom pixel
 - Buffer index: x + (y / 8) * 128
 
+Delta Output (badapple_video.dlt):
+- Header: frame_count, keyframe_interval, keyframe_count, stream_size
+  (4 x uint32 LE)
+- Keyframe table: keyframe_count x uint32 LE record offsets into the stream
+- Record stream, one record per frame:
+    [uint16 LE payload length][uint8 flags (bit 0 = keyframe)][payload]
+  Keyframe payload = raw 1024-byte frame. Delta payload = tokens
+  [skip u8][len u8][len bytes XORed onto the previous frame].
+- Frame k * KEYFRAME_INTERVAL is always a keyframe; combine_files.py packs
+  the stream and table into the v3 container.
+
 Author: David Leathers
 Date: November 2025
-Version: 2.1.0 - FIXED SSD1306 byte format
+Version: 2.2.0 - XOR/RLE delta output
 """
 
 import cv2
+import math
 import numpy as np
 import struct
 import os
@@ -38,6 +50,7 @@ from PIL import Image
 # Input/Output
 VIDEO_FILE = "BadApple.mp4"
 OUTPUT_FILE = os.path.join("output", "badapple_video.bin")
+DELTA_OUTPUT_FILE = os.path.join("output", "badapple_video.dlt")
 PREVIEW_DIR = "frames"
 
 # Display settings (SSD1306 OLED)
@@ -47,10 +60,13 @@ OLED_PAGES = OLED_HEIGHT // 8  # 8 pages of 8 pixels each
 FRAMEBUFFER_SIZE = 1024  # 128 columns x 8 pages
 
 # Video processing settings
-TARGET_FPS = 30          # 30 fps for smooth playback (matches STM32 target)
+TARGET_FPS = 30          # 30, or 60 for the 60 fps mode (set VIDEO_FPS_NUM in combine_files.py too)
 THRESHOLD = 128          # Black/white threshold (0-255)
 INVERT = False           # Set True if colors appear inverted
 
+# Delta codec
+KEYFRAME_INTERVAL = TARGET_FPS   # Frames between keyframes (1 second)
+
 # Image enhancement
 CONTRAST_BOOST = 1.2     # 1.0 = no boost, 1.5 = high boost
 BRIGHTNESS_OFFSET = 0    # -50 to +50 for brightness adjustment
@@ -199,6 +215,180 @@ def verify_ssd1306_format(frame_bytes, original_binary):
     return np.array_equal(decoded, original_binary)
 
 
+# ============================================================================
+# DELTA CODEC
+# ============================================================================
+
+DELTA_RECORD_HEADER = 3  # uint16 length + uint8 flags
+DELTA_FLAG_KEYFRAME = 0x01
+DELTA_MAX_TOKEN = 255    # skip and len are single bytes
+DELTA_MERGE_GAP = 2      # Unchanged gaps this short are cheaper inside a run
+
+
+def xor_rle_encode(prev, cur):
+    """
+    Encode cur as XOR-against-prev tokens
+    
+    Args:
+        prev: Previous frame (1024 bytes)
+        cur: Current frame (1024 bytes)
+    
+    Returns:
+        bytes: Tokens [skip][len][len XOR bytes], empty if frames match
+    """
+    diff = bytes(a ^ b for a, b in zip(prev, cur))
+    
+    # Find runs of changed bytes, absorbing short unchanged gaps
+    runs = []
+    pos = 0
+    while pos < FRAMEBUFFER_SIZE:
+        if diff[pos] == 0:
+            pos += 1
+            continue
+        start = pos
+        end = pos + 1
+        while end < FRAMEBUFFER_SIZE:
+            if diff[end] != 0:
+                end += 1
+            elif any(diff[end:end + DELTA_MERGE_GAP + 1]):
+                end += 1
+            else:
+                break
+        # Trim absorbed zeros at the tail
+        while diff[end - 1] == 0:
+            end -= 1
+        runs.append((start, end))
+        pos = end
+    
+    tokens = bytearray()
+    cursor = 0
+    for start, end in runs:
+        skip = start - cursor
+        while skip > DELTA_MAX_TOKEN:
+            tokens += bytes((DELTA_MAX_TOKEN, 0))
+            skip -= DELTA_MAX_TOKEN
+        while start < end:
+            length = min(end - start, DELTA_MAX_TOKEN)
+            tokens += bytes((skip, length)) + diff[start:start + length]
+            start += length
+            skip = 0
+        cursor = end
+    
+    return bytes(tokens)
+
+
+def encode_delta_record(prev, cur, keyframe):
+    """
+    Build one record (falls back to a keyframe if the delta is not smaller)
+    
+    Returns:
+        tuple: (record bytes, is_keyframe)
+    """
+    if not keyframe:
+        payload = xor_rle_encode(prev, cur)
+        if len(payload) < FRAMEBUFFER_SIZE:
+            return struct.pack('<HB', len(payload), 0) + payload, False
+    
+    return struct.pack('<HB', FRAMEBUFFER_SIZE, DELTA_FLAG_KEYFRAME) + bytes(cur), True
+
+
+def decode_delta_record(ref, record):
+    """
+    Apply one record to the reference frame (mirrors the firmware decoder)
+    
+    Args:
+        ref: bytearray reference frame, updated in place
+        record: Record bytes (header + payload)
+    
+    Returns:
+        int: Record size in bytes
+    """
+    length, flags = struct.unpack('<HB', record[:DELTA_RECORD_HEADER])
+    payload = record[DELTA_RECORD_HEADER:DELTA_RECORD_HEADER + length]
+    
+    if flags & DELTA_FLAG_KEYFRAME:
+        ref[:] = payload
+    else:
+        p = 0
+        pos = 0
+        while p + 2 <= length:
+            skip, run = payload[p], payload[p + 1]
+            pos += skip
+            p += 2
+            for i in range(run):
+                ref[pos + i] ^= payload[p + i]
+            pos += run
+            p += run
+    
+    return DELTA_RECORD_HEADER + length
+
+
+def encode_delta_stream(frames, interval=KEYFRAME_INTERVAL):
+    """
+    Encode all frames as a delta record stream
+    
+    Args:
+        frames: List of 1024-byte frames
+        interval: Keyframe interval in frames
+    
+    Returns:
+        tuple: (stream bytes, keyframe offset list, extra keyframe count)
+    """
+    stream = bytearray()
+    keyframe_offsets = []
+    extra_keyframes = 0
+    prev = bytes(FRAMEBUFFER_SIZE)
+    
+    for idx, frame in enumerate(frames):
+        forced = (idx % interval == 0)
+        if forced:
+            keyframe_offsets.append(len(stream))
+        record, is_keyframe = encode_delta_record(prev, frame, forced)
+        if is_keyframe and not forced:
+            extra_keyframes += 1
+        stream += record
+        prev = frame
+    
+    return bytes(stream), keyframe_offsets, extra_keyframes
+
+
+def verify_delta_stream(frames, stream, keyframe_offsets, interval=KEYFRAME_INTERVAL):
+    """
+    Decode the whole stream and check every frame (and every keyframe entry)
+    
+    Returns:
+        bool: True if all frames decode exactly
+    """
+    ref = bytearray(FRAMEBUFFER_SIZE)
+    offset = 0
+    for idx, frame in enumerate(frames):
+        if idx % interval == 0 and keyframe_offsets[idx // interval] != offset:
+            return False
+        offset += decode_delta_record(ref, stream[offset:])
+        if bytes(ref) != frame:
+            return False
+    return offset == len(stream)
+
+
+def write_delta_file(filename, frames, interval=KEYFRAME_INTERVAL):
+    """
+    Encode frames and write the delta output file
+    
+    Returns:
+        tuple: (stream size, keyframe count, extra keyframes, verified)
+    """
+    stream, keyframe_offsets, extra = encode_delta_stream(frames, interval)
+    verified = verify_delta_stream(frames, stream, keyframe_offsets, interval)
+    
+    with open(filename, 'wb') as f:
+        f.write(struct.pack('<4I', len(frames), interval,
+                            len(keyframe_offsets), len(stream)))
+        f.write(struct.pack(f'<{len(keyframe_offsets)}I', *keyframe_offsets))
+        f.write(stream)
+    
+    return len(stream), len(keyframe_offsets), extra, verified
+
+
 # ============================================================================
 # VIDEO PROCESSING
 # ============================================================================
@@ -214,7 +404,7 @@ def process_video():
         bool: True if successful, False otherwise
     """
     print("=" * 70)
-    print("BAD APPLE VIDEO PROCESSOR v2.1.0 (FIXED SSD1306 FORMAT)")
+    print("BAD APPLE VIDEO PROCESSOR v2.2.0 (SSD1306 FORMAT + DELTA)")
     print("Target: STM32L476RG + SSD1306 OLED (128x64)")
     print("=" * 70)
     print()
@@ -280,14 +470,17 @@ def process_video():
     # CALCULATE PROCESSING PARAMETERS
     # ========================================================================
     
-    frame_skip = max(1, round(video_fps / TARGET_FPS))
-    expected_frames = total_frames // frame_skip
+    # Output frame n shows the source frame on screen at n / TARGET_FPS, so
+    # faster sources are decimated and slower ones repeat frames
+    source_fps = video_fps if video_fps > 0 else TARGET_FPS
+    expected_frames = math.ceil(total_frames * TARGET_FPS / source_fps)
     expected_duration = expected_frames / TARGET_FPS
     
     print(f"[OUTPUT] Output Video Configuration:")
     print(f"  Resolution: {OLED_WIDTH}x{OLED_HEIGHT}")
     print(f"  Frame rate: {TARGET_FPS} fps")
-    print(f"  Frame skip: every {frame_skip} frame(s)")
+    print(f"  Resample:   {source_fps:.2f} -> {TARGET_FPS} fps "
+          f"({'repeat' if source_fps < TARGET_FPS else 'decimate'})")
     print(f"  Expected:   {expected_frames:,} frames")
     print(f"  Duration:   {int(expected_duration//60)}:{int(expected_duration%60):02d}")
     print(f"  Format:     SSD1306 vertical page (8 pages x 128 columns)")
@@ -324,8 +517,10 @@ def process_video():
         if not ret:
             break
         
-        # Skip frames to achieve target FPS
-        if frame_idx % frame_skip == 0:
+        # Emit this source frame for every output slot it covers (none if
+        # the next source frame is already on screen by the next slot)
+        repeats = math.ceil((frame_idx + 1) * TARGET_FPS / source_fps) - processed_count
+        if repeats > 0:
             # Convert to grayscale
             gray = cv2.cvtColor(frame, cv2.COLOR_BGR2GRAY)
             
@@ -339,7 +534,7 @@ def process_video():
             
             # Convert to SSD1306 format (FIXED: vertical page format)
             frame_bytes = frame_to_ssd1306_format(resized)
-            frames_data.append(frame_bytes)
+            frames_data.extend([frame_bytes] * repeats)
             
             # Verify first few frames
             if processed_count < 5:
@@ -355,7 +550,7 @@ def process_video():
                 save_preview_image(resized, processed_count)
                 preview_saved += 1
             
-            processed_count += 1
+            processed_count += repeats
             
             # Update progress bar
             if expected_frames > 0:
@@ -394,6 +589,27 @@ def process_video():
         for frame_data in frames_data:
             f.write(frame_data)
     
+    # ========================================================================
+    # WRITE DELTA FILE
+    # ========================================================================
+    
+    print(f"[WRITE] Encoding XOR/RLE delta to {DELTA_OUTPUT_FILE}...")
+    
+    delta_size, keyframe_count, extra_keyframes, delta_ok = \
+        write_delta_file(DELTA_OUTPUT_FILE, frames_data, KEYFRAME_INTERVAL)
+    raw_size = len(frames_data) * FRAMEBUFFER_SIZE
+    
+    print(f"  Keyframes:  {keyframe_count} (every {KEYFRAME_INTERVAL} frames)"
+          f" + {extra_keyframes} where delta was larger")
+    print(f"  Stream:     {delta_size:,} bytes ({delta_size / raw_size * 100:.1f}% of raw)")
+    print(f"  Bandwidth:  {delta_size / (len(frames_data) / TARGET_FPS) / 1024:.1f} KB/s"
+          f" (raw {TARGET_FPS * FRAMEBUFFER_SIZE / 1024:.1f} KB/s)")
+    
+    if not delta_ok:
+        print("ERROR: Delta stream failed round-trip verification!")
+        return False
+    print("  [OK] Round-trip verified for all frames")
+    
     # ========================================================================
     # FINAL STATISTICS
     # ========================================================================